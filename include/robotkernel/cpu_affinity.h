@@ -0,0 +1,125 @@
+//! robotkernel cpu affinity
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__CPU_AFFINITY_H
+#define ROBOTKERNEL__CPU_AFFINITY_H
+
+#include <string>
+#include <bitset>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <yaml-cpp/yaml.h>
+
+namespace robotkernel {
+
+//! cpu affinity set
+/*!
+ * Set of cpus a thread is allowed to run on, not limited to the 32 cpus
+ * of an int bit mask. An empty set means no pinning. Sets are given as
+ * cpu lists like "0-3,8,10-11", as single cpu numbers, as YAML sequences
+ * of both, or as all cpus of a NUMA node.
+ */
+class cpu_affinity {
+    public:
+        static const int max_cpus = 1024;   //!< highest supported cpu number + 1
+
+    private:
+        std::bitset<max_cpus> cpus;         //!< cpu bits
+
+    public:
+        //! construction of empty set, no pinning
+        cpu_affinity() {}
+
+        //! construction from legacy bit mask
+        /*!
+         * \param[in] mask      Bit mask of cpus 0 to 31.
+         */
+        explicit cpu_affinity(int mask);
+
+        //! construction from cpu list
+        /*!
+         * \param[in] list      Cpu list, e.g. "0-3,8,10-11".
+         *
+         * \throw runtime_error on parse errors.
+         */
+        explicit cpu_affinity(const std::string& list);
+
+        //! construction from yaml node
+        /*!
+         * \param[in] node      Cpu number, cpu list string or sequence 
+         *                      of both.
+         *
+         * \throw runtime_error on parse errors.
+         */
+        explicit cpu_affinity(const YAML::Node& node);
+
+        //! return all cpus of a NUMA node
+        /*!
+         * \param[in] node      NUMA node number.
+         *
+         * \throw runtime_error if node does not exist.
+         */
+        static cpu_affinity numa_node_cpus(int node);
+
+        void set(int cpu);                  //!< add cpu to set
+        void reset(int cpu);                //!< remove cpu from set
+        bool is_set(int cpu) const;         //!< test if cpu is in set
+        bool empty() const { return cpus.none(); }      //!< returns true if no cpu set
+        size_t count() const { return cpus.count(); }   //!< number of cpus in set
+
+        //! return lowest cpu in set, -1 if empty
+        int first() const;
+
+        //! return next cpu in set after cpu, -1 if none
+        int next(int cpu) const;
+
+        //! return cpu list string, e.g. "0-3,8"
+        std::string to_string() const;
+
+        //! return legacy bit mask, only cpus 0 to 31
+        int to_mask() const;
+
+#ifdef __linux__
+        //! fill cpu_set_t
+        /*!
+         * \param[out] set      Set to fill, cleared before.
+         */
+        void to_cpu_set(cpu_set_t& set) const;
+#endif
+
+        cpu_affinity& operator|=(const cpu_affinity& a) { cpus |= a.cpus; return *this; }
+        bool operator==(const cpu_affinity& a) const { return cpus == a.cpus; }
+        bool operator!=(const cpu_affinity& a) const { return cpus != a.cpus; }
+        bool operator<(const cpu_affinity& a) const;
+};
+
+}; // namespace robotkernel
+
+#endif // ROBOTKERNEL__CPU_AFFINITY_H
+
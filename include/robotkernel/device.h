@@ -30,6 +30,7 @@
 #include <memory>
 #include <map>
 #include <string>
+#include <stdint.h>
 
 namespace robotkernel {
 
@@ -39,24 +40,28 @@ class device {
         const std::string device_name;  //!< device instance name
         const std::string suffix;       //!< device suffix name
 
+    private:
+        const std::string _id;          //!< "owner.device_name.suffix"
+
     public:
         device(
                 const std::string& owner, 
                 const std::string& device_name,
                 const std::string& suffix) :
-            owner(owner), device_name(device_name), suffix(suffix) {};
+            owner(owner), device_name(device_name), suffix(suffix),
+            _id(owner + "." + device_name + "." + suffix) {};
         virtual ~device() {};
 
-        std::string id() const;
-};
-        
-inline std::string device::id() const {
-    return owner + std::string(".") + device_name + std::string(".") + suffix;
+        //! return unique device id "owner.device_name.suffix"
+        const std::string& id() const { return _id; }
 };
 
 typedef std::shared_ptr<device> sp_device_t;
 typedef std::map<std::string, sp_device_t> device_map_t;
 
+//! interned device id, see get_device_handle
+typedef uint32_t device_handle_t;
+
 }; // namespace robotkernel
 
 #endif // ROBOTKERNEL__DEVICE_H
@@ -28,22 +28,42 @@
 #define ROBOTKERNEL_DEVICE_LISTENER_H
 
 #include <string>
+#include <vector>
+#include <map>
 
 // public header
 #include "robotkernel/device.h"
 
 namespace robotkernel {
 
+//! device type bits, used as device listener filter
+enum device_type_t {
+    device_type_process_data        = 0x01,
+    device_type_trigger             = 0x02,
+    device_type_stream              = 0x04,
+    device_type_service_interface   = 0x08,
+    device_type_other               = 0x10,     //!< any other device
+    device_type_all                 = 0x1f
+};
+
 class device_listener 
 {
     public: 
         const std::string owner;        //!< device owner
         const std::string name;         //!< listener name
+        const uint32_t device_types;    //!< device_type_t bits to be notified about
 
     public:
         //! construction
-        device_listener(const std::string& owner, const std::string& name) :
-            owner(owner), name(name) {};
+        /*!
+         * \param[in] owner         Listener owner.
+         * \param[in] name          Listener name.
+         * \param[in] device_types  Or'ed device_type_t bits, the listener 
+         *                          is only notified about these devices.
+         */
+        device_listener(const std::string& owner, const std::string& name, 
+                uint32_t device_types = device_type_all) :
+            owner(owner), name(name), device_types(device_types) {};
 
         //! destruction
         virtual ~device_listener() = 0;
@@ -53,6 +73,27 @@ class device_listener
 
         // remove a named device
         virtual void notify_remove_device(sp_device_t req) = 0;
+
+        //! add a batch of named devices
+        /*!
+         * Called from the device event thread. Override to handle
+         * a whole batch at once.
+         *
+         * \param[in] reqs  Added devices in registration order.
+         */
+        virtual void notify_add_devices(const std::vector<sp_device_t>& reqs) {
+            for (const auto& req : reqs)
+                notify_add_device(req);
+        }
+
+        //! remove a batch of named devices
+        /*!
+         * \param[in] reqs  Removed devices in removal order.
+         */
+        virtual void notify_remove_devices(const std::vector<sp_device_t>& reqs) {
+            for (const auto& req : reqs)
+                notify_remove_device(req);
+        }
 };
 
 //! destruction
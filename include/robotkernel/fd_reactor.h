@@ -0,0 +1,161 @@
+//! robotkernel fd reactor
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__FD_REACTOR_H
+#define ROBOTKERNEL__FD_REACTOR_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <functional>
+#include <sys/epoll.h>
+
+// public headers
+#include "robotkernel/runnable.h"
+#include "robotkernel/trigger.h"
+
+#include <yaml-cpp/yaml.h>
+
+namespace robotkernel {
+
+//! file descriptor reactor
+/*!
+ * One thread waits with epoll on all registered file descriptors (timerfds,
+ * sockets, ptys, trigger subscriptions, ...) and fires the associated trigger
+ * device when a descriptor becomes ready. All descriptors ready in one
+ * wakeup are handled as a batch, a trigger associated with several ready
+ * descriptors is fired only once per wakeup.
+ *
+ * The reactor owns registered descriptors and closes them when they are
+ * removed or when the reactor is destructed.
+ */
+class fd_reactor : public runnable {
+    public:
+        //! ready handler
+        /*!
+         * Called from the reactor thread before the trigger is fired. Should
+         * consume the pending data or event (e.g. read the timerfd expiration
+         * count), otherwise the descriptor keeps signalling readiness.
+         *
+         * \param[in] fd        Ready file descriptor.
+         * \param[in] events    Ready epoll events.
+         */
+        typedef std::function<void(int fd, uint32_t events)> handler_t;
+
+    private:
+        fd_reactor(const fd_reactor&);             // prevent copy-construction
+        fd_reactor& operator=(const fd_reactor&);  // prevent assignment
+
+        struct entry {
+            int fd;                 //!< owned file descriptor
+            sp_trigger_t trg;       //!< trigger to fire, may be empty
+            handler_t handler;      //!< ready handler, may be empty
+
+            ~entry();
+        };
+
+        typedef std::shared_ptr<entry> sp_entry_t;
+        typedef std::map<int, sp_entry_t> entry_map_t;
+
+        int epoll_fd;               //!< epoll instance
+        int wakeup_fd;              //!< used to interrupt epoll_wait on stop
+        int max_events;             //!< max events handled per wakeup
+
+        std::mutex mtx;             //!< protects entries
+        entry_map_t entries;        //!< registered descriptors
+
+        //! create epoll instance and wakeup descriptor
+        void init();
+
+        //! remove descriptor which hung up, called from reactor thread
+        void remove_hung_up(const sp_entry_t& e);
+
+    public:
+        const std::string name;     //!< reactor name
+
+        //! construction with yaml node
+        /*!
+         * \param[in] node  YAML node which may contain name, prio, affinity,
+         *                  thread_name and max_events.
+         */
+        fd_reactor(const YAML::Node& node);
+
+        //! construction
+        /*!
+         * \param[in] name          Reactor name.
+         * \param[in] prio          Reactor thread priority.
+         * \param[in] affinity      Reactor thread cpu affinity.
+         * \param[in] max_events    Max events handled per wakeup.
+         */
+        fd_reactor(const std::string& name, int prio = 0, 
+                const cpu_affinity& affinity = cpu_affinity(), int max_events = 64);
+
+        //! destruction
+        ~fd_reactor();
+
+        //! add file descriptor
+        /*!
+         * \param[in] fd        File descriptor, owned by the reactor afterwards.
+         * \param[in] trg       Trigger device fired on readiness, may be empty.
+         * \param[in] handler   Ready handler, if empty pending data is read
+         *                      and discarded (suitable for timerfds and
+         *                      eventfds used as pure wakeup sources). Such 
+         *                      descriptors are removed on eof or hangup.
+         * \param[in] events    Epoll events to wait for.
+         */
+        void add_fd(int fd, sp_trigger_t trg, handler_t handler = nullptr,
+                uint32_t events = EPOLLIN);
+
+        //! remove and close file descriptor
+        /*!
+         * \param[in] fd        File descriptor to remove.
+         */
+        void remove_fd(int fd);
+
+        //! change epoll events of registered file descriptor
+        /*!
+         * May be called from any thread, wakes the reactor if the 
+         * descriptor is ready for the new events.
+         *
+         * \param[in] fd        Registered file descriptor.
+         * \param[in] events    Epoll events to wait for.
+         */
+        void modify_fd(int fd, uint32_t events);
+
+        //! handler function called if thread is running
+        void run();
+
+        //! stop reactor thread
+        void stop();
+};
+
+typedef std::shared_ptr<fd_reactor> sp_fd_reactor_t;
+typedef std::map<std::string, sp_fd_reactor_t> fd_reactor_map_t;
+
+}; // namespace robotkernel
+
+#endif // ROBOTKERNEL__FD_REACTOR_H
+
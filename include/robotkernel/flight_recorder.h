@@ -0,0 +1,139 @@
+//! robotkernel flight recorder
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__FLIGHT_RECORDER_H
+#define ROBOTKERNEL__FLIGHT_RECORDER_H
+
+#include <string>
+#include <atomic>
+#include <ostream>
+#include <stdint.h>
+
+namespace robotkernel {
+
+//! flight recorder file header
+/*!
+ * The file consists of this header followed by the record ring. All
+ * values are stored in host byte order.
+ */
+struct flight_recorder_header {
+    char magic[8];                      //!< "RKFLIGHT"
+    uint32_t version;                   //!< file format version
+    uint32_t header_size;               //!< offset of record ring
+    uint64_t ring_size;                 //!< size of record ring in bytes
+    std::atomic<uint64_t> write_pos;    //!< bytes ever reserved in ring
+    int32_t pid;                        //!< process id of writer
+    uint32_t reserved;
+};
+
+//! flight recorder record header
+/*!
+ * Records start at 8 byte aligned ring positions and may wrap around the
+ * end of the ring. The payload (text without terminating zero) follows
+ * the header. The magic is written last, so a record with valid magic 
+ * is complete. Stale records of earlier ring rounds are detected by their
+ * position.
+ */
+struct flight_recorder_record {
+    uint32_t magic;                     //!< record_magic if complete
+    uint16_t type;                      //!< record type
+    uint16_t level;                     //!< loglevel of log records
+    uint32_t size;                      //!< record size including header and padding
+    uint32_t len;                       //!< payload length
+    uint64_t ts;                        //!< CLOCK_REALTIME [ns]
+    uint64_t pos;                       //!< write position of record
+};
+
+//! crash-surviving log and trace ring
+/*!
+ * Records are appended to a ring in a shared memory mapped file, e.g. in
+ * /dev/shm. The pages belong to the file, not to the process, so
+ * everything appended before a crash can be decoded afterwards with
+ * rk_flight_decode. Appending is lock-free, concurrent writers reserve
+ * space with one fetch-and-add and the oldest records are overwritten.
+ */
+class flight_recorder {
+    private:
+        flight_recorder(const flight_recorder&);             // prevent copy-construction
+        flight_recorder& operator=(const flight_recorder&);  // prevent assignment
+
+        std::string path;                       //!< file path
+        size_t map_size;                        //!< mapped bytes
+        flight_recorder_header *hdr;            //!< mapped header
+        char *ring;                             //!< mapped record ring
+        uint64_t ring_mask;                     //!< ring size - 1
+
+        //! copy bytes into ring, wrapping around at the end
+        void copy_in(uint64_t pos, const void *src, size_t len);
+
+    public:
+        static const uint32_t version = 1;
+        static const uint32_t record_magic = 0x52464B52;   //!< "RKFR"
+
+        enum record_type {
+            type_log   = 1,                     //!< log record
+            type_trace = 2,                     //!< trace event
+        };
+
+        //! construction
+        /*!
+         * Creates or truncates the file and maps it.
+         *
+         * \param[in] path      File path.
+         * \param[in] size      Ring size in bytes, rounded up to a power of two.
+         */
+        flight_recorder(const std::string& path, size_t size);
+
+        //! destruction, the file is kept
+        ~flight_recorder();
+
+        //! append record
+        /*!
+         * \param[in] type      Record type.
+         * \param[in] level     Loglevel of log records.
+         * \param[in] ts        CLOCK_REALTIME timestamp [ns].
+         * \param[in] text      Payload.
+         * \param[in] len       Payload length.
+         */
+        void append(record_type type, int level, uint64_t ts,
+                const char *text, size_t len);
+
+        //! decode flight recorder file
+        /*!
+         * \param[in] path      File path.
+         * \param[in] out       Output stream for decoded records.
+         * \param[in] max_bytes Only decode the newest bytes of the ring,
+         *                      0 for the whole ring.
+         * \return number of decoded records
+         */
+        static size_t decode(const std::string& path, std::ostream& out,
+                size_t max_bytes = 0);
+};
+
+}; // namespace robotkernel
+
+#endif // ROBOTKERNEL__FLIGHT_RECORDER_H
+
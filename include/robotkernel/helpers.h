@@ -40,6 +40,7 @@
 #include <stdexcept>
 
 #include "robotkernel/exceptions.h"
+#include "robotkernel/cpu_affinity.h"
 
 #define timespec_add(tvp, sec, nsec) { \
     (tvp)->tv_nsec += nsec; \
@@ -77,6 +78,10 @@ std::vector<std::string> string_split(const std::string& str, const char delimit
 
 void set_priority(int priority, int policy = SCHED_FIFO);
 void set_affinity_mask(int affinity_mask);
+void set_affinity(const cpu_affinity& affinity);
+bool numa_bind_memory(void *addr, size_t len, int numa_node);
+bool numa_bind_thread(int numa_node);
+bool set_sched_deadline(uint64_t runtime_ns, uint64_t deadline_ns, uint64_t period_ns);
 
 void set_thread_name(std::thread& tid, const std::string& thread_name);
 void set_thread_name(pthread_t tid, const std::string& thread_name);
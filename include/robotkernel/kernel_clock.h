@@ -0,0 +1,119 @@
+//! robotkernel kernel clock
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__KERNEL_CLOCK_H
+#define ROBOTKERNEL__KERNEL_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace robotkernel {
+
+//! kernel time service
+/*!
+ * Monotonic nanosecond timestamps for logging, tracing and statistics.
+ * On x86_64 the time stamp counter is used if the Linux kernel uses it
+ * as clocksource (constant and synchronized between cores). It is 
+ * calibrated against CLOCK_MONOTONIC_RAW by \link calibrate \endlink,
+ * before that and on other platforms CLOCK_MONOTONIC_RAW is read directly.
+ *
+ * Timestamps are converted to wall clock time for display with a 
+ * CLOCK_REALTIME anchor, which is refreshed by \link resync_wall \endlink.
+ */
+class kernel_clock {
+    private:
+        kernel_clock();                         // only static members
+
+        struct state {
+            bool use_tsc;                       //!< tsc fast path calibrated
+            uint64_t tsc_base;                  //!< tsc at calibration
+            uint64_t ns_base;                   //!< CLOCK_MONOTONIC_RAW at calibration [ns]
+            uint64_t mult;                      //!< ns per tsc tick << 32
+        };
+
+        static state st;                        //!< written once by calibrate
+        static std::atomic<int64_t> wall_offset;    //!< CLOCK_REALTIME - now_ns() [ns]
+
+        //! read CLOCK_MONOTONIC_RAW
+        static uint64_t raw_ns() {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+            return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+        }
+
+    public:
+        //! return monotonic timestamp [ns]
+        static uint64_t now_ns() {
+#if defined(__x86_64__)
+            if (st.use_tsc) {
+                uint64_t d = __rdtsc() - st.tsc_base;
+                return st.ns_base + (uint64_t)(((unsigned __int128)d * st.mult) >> 32);
+            }
+#endif
+            return raw_ns();
+        }
+
+        //! convert monotonic timestamp to wall clock time
+        /*!
+         * \param[in] ns    Timestamp returned by \link now_ns \endlink.
+         * \return CLOCK_REALTIME based time [ns]
+         */
+        static uint64_t to_wall_ns(uint64_t ns) {
+            return ns + wall_offset.load(std::memory_order_relaxed);
+        }
+
+        //! return wall clock time [ns]
+        static uint64_t wall_ns() { return to_wall_ns(now_ns()); }
+
+        //! calibrate time stamp counter and wall clock anchor
+        /*!
+         * Has to be called once before other threads use the clock, takes 
+         * about 10 ms.
+         */
+        static void calibrate();
+
+        //! refresh wall clock anchor
+        /*!
+         * Compensates calibration error and wall clock adjustments, should
+         * be called periodically from a non real-time thread.
+         */
+        static void resync_wall();
+
+        //! return name of time source
+        static const char *source() { 
+            return st.use_tsc ? "tsc" : "clock_monotonic_raw"; 
+        }
+};
+
+}; // namespace robotkernel
+
+#endif // ROBOTKERNEL__KERNEL_CLOCK_H
+
@@ -0,0 +1,192 @@
+//! robotkernel typed in-process service calls
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__LOCAL_SERVICE_H
+#define ROBOTKERNEL__LOCAL_SERVICE_H
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+
+#include "robotkernel/service.h"
+#include "robotkernel/helpers.h"
+#include "robotkernel/kernel_clock.h"
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! typed in-process service handler
+/*!
+ * Takes the generated request and response structs by reference, 
+ * in-process callers skip the conversion to service_arglist_t.
+ */
+template <typename Req, typename Resp>
+struct service_local_handler : public service_local_handler_base {
+    typedef std::function<void(const Req&, Resp&)> function_t;
+
+    function_t fn;
+
+    service_local_handler(const function_t& fn) : fn(fn) {}
+};
+
+//! get service by name
+/*!
+ * \param[in] owner     Owner of service.
+ * \param[in] name      Name of service.
+ * \return service, throws if not found
+ */
+extern sp_service_t get_service(
+        const std::string& owner,
+        const std::string& name);
+
+//! set typed handler of an existing service
+/*!
+ * \param[in] owner     Owner of service.
+ * \param[in] name      Name of service.
+ * \param[in] handler   Typed handler, replaces previous one.
+ */
+extern void set_service_local_handler(
+        const std::string& owner,
+        const std::string& name,
+        sp_service_local_handler_t handler);
+
+//! run typed call of queued service on service worker pool and wait
+/*!
+ * \param[in] svc       Service with dispatch async or serialized.
+ * \param[in] call      Calls typed handler.
+ */
+extern void call_service_local_queued(sp_service_t svc, std::function<void()> call);
+
+//! add typed handler to an existing service
+/*!
+ * The service has to be added first, e.g. with the generated add_svc_*
+ * method. Bridges keep using the service_arglist_t callback.
+ *
+ * \param[in] owner     Owner of service.
+ * \param[in] name      Name of service.
+ * \param[in] fn        Typed handler.
+ */
+template <typename Req, typename Resp>
+inline void add_local_handler(const std::string& owner, const std::string& name,
+        const typename service_local_handler<Req, Resp>::function_t& fn) {
+    set_service_local_handler(owner, name, 
+            std::make_shared<service_local_handler<Req, Resp> >(fn));
+}
+
+//! add typed handler to an existing service
+/*!
+ * \param[in] owner     Owner of service.
+ * \param[in] name      Name of service.
+ * \param[in] obj       Object implementing service, e.g. module.
+ * \param[in] fn        Service method, e.g. &svc_base_set_state::svc_set_state.
+ */
+template <typename T, typename B, typename Req, typename Resp>
+inline void add_local_handler(const std::string& owner, const std::string& name,
+        T *obj, void (B::*fn)(const Req&, Resp&)) {
+    B *base = obj;
+    add_local_handler<Req, Resp>(owner, name, 
+            [base, fn](const Req& req, Resp& resp) { (base->*fn)(req, resp); });
+}
+
+//! typed in-process service call
+/*!
+ * Resolves the service once on construction. Calls of inline services
+ * pass request and response by reference to the typed handler on the
+ * calling thread without any allocation. Queued services are executed 
+ * on the service worker pool as usual.
+ */
+template <typename Req, typename Resp>
+class local_service {
+    private:
+        sp_service_t svc;
+
+    public:
+        //! construction
+        /*!
+         * \param[in] owner     Owner of service.
+         * \param[in] name      Name of service.
+         */
+        local_service(const std::string& owner, const std::string& name) :
+            svc(get_service(owner, name)) {}
+
+        //! call service
+        /*!
+         * \param[in]  req     Service request.
+         * \param[out] resp    Service response.
+         */
+        void operator()(const Req& req, Resp& resp) const {
+            sp_service_local_handler_t h = std::atomic_load(&svc->local);
+            auto typed = dynamic_cast<const service_local_handler<Req, Resp> *>(h.get());
+            if (!typed)
+                throw std::runtime_error(string_printf("service %s.%s: owner %s %s!\n", 
+                            svc->owner.c_str(), svc->name.c_str(), svc->owner.c_str(),
+                            h ? "registered a local handler for a different request type" :
+                            "registered no local handler or removed the service"));
+
+            if (svc->dispatch != service_dispatch_inline) {
+                call_service_local_queued(svc, [typed, &req, &resp]() { typed->fn(req, resp); });
+                return;
+            }
+
+            uint64_t start = kernel_clock::now_ns();
+
+            try {
+                typed->fn(req, resp);
+            } catch (...) {
+                svc->stats->record(kernel_clock::now_ns() - start, true);
+                throw;
+            }
+
+            svc->stats->record(kernel_clock::now_ns() - start, false);
+        }
+};
+
+//! call service in-process with typed request and response
+/*!
+ * Looks up the service on every call, use local_service for 
+ * repeated calls.
+ *
+ * \param[in]  owner     Owner of service.
+ * \param[in]  name      Name of service.
+ * \param[in]  req       Service request.
+ * \param[out] resp      Service response.
+ */
+template <typename Req, typename Resp>
+inline void call_service_local(const std::string& owner, const std::string& name,
+        const Req& req, Resp& resp) {
+    local_service<Req, Resp>(owner, name)(req, resp);
+}
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__LOCAL_SERVICE_H
+
@@ -33,10 +33,42 @@
 #include "robotkernel/helpers.h"
 #include "yaml-cpp/yaml.h"
 
+#include <atomic>
+#include <stdarg.h>
+#include <stdint.h>
+
 namespace robotkernel {
 
+//! per-callsite log rate limiter
+/*!
+ * Token bucket implemented as generic cell rate algorithm. The state is a
+ * single atomic theoretical arrival time, so it is lock-free and can be
+ * placed as static object at the log callsite (see RK_LOG). Rate and burst
+ * are taken from the logging log_base instance.
+ */
+class log_ratelimit {
+    private:
+        std::atomic<uint64_t> tat;          //!< theoretical arrival time [ns]
+        std::atomic<uint32_t> suppressed;   //!< suppressed since last pass
+
+    public:
+        //! construction
+        constexpr log_ratelimit() : tat(0), suppressed(0) {}
+
+        //! check if message may pass
+        /*!
+         * \param[in]   rate        Allowed messages per second.
+         * \param[in]   burst       Allowed burst of messages.
+         * \param[out]  n_supp      Number of messages suppressed since
+         *                          last passed message.
+         * \return true if message may be logged
+         */
+        bool pass(double rate, unsigned int burst, uint32_t& n_supp);
+};
+
 class log_base : 
-    public services::robotkernel::log_base::svc_base_configure_loglevel
+    public services::robotkernel::log_base::svc_base_configure_loglevel,
+    public services::robotkernel::log_base::svc_base_configure_log_rate
 {
     private:
         log_base();                 //!< prevent default construction
@@ -47,6 +79,13 @@ class log_base :
         std::string impl;           //!< name of implementation
         std::string service_prefix; //!< name of service
 
+        std::atomic<double> log_rate;           //!< messages per second per callsite, 0 unlimited
+        std::atomic<unsigned int> log_burst;    //!< burst of messages per callsite
+
+        //! highest level of records needed besides printing (dump log,
+        //! trace fd, lttng, flight recorder), 0 if none
+        static std::atomic<int> capture_level;
+
         //! construction
         /*!
          * \param[in]   ll          Loglevel to set.
@@ -81,10 +120,50 @@ class log_base :
             const struct services::robotkernel::log_base::svc_req_configure_loglevel& req, 
             struct services::robotkernel::log_base::svc_resp_configure_loglevel& resp) override;
 
+        //! svc_configure_log_rate
+        /*!
+         * \param[in]   req     Service request data.
+         * \param[out]  resp    Service response data.
+         */
+        void svc_configure_log_rate(
+            const struct services::robotkernel::log_base::svc_req_configure_log_rate& req, 
+            struct services::robotkernel::log_base::svc_resp_configure_log_rate& resp) override;
+
+        //! check if a message of given level has to be produced
+        /*!
+         * \param[in]   lvl     Loglevel of message.
+         * \return true if message is printed or captured
+         */
+        bool log_enabled(loglevel lvl) const;
+
         //! log to kernel logging facility
-        void log(robotkernel::loglevel lvl, const char *format, ...);
+        void log(robotkernel::loglevel lvl, const char *format, ...)
+            __attribute__((format(printf, 3, 4)));
+
+        //! log to kernel logging facility with rate limiting
+        /*!
+         * \param[in]   rl      Rate limiter of callsite.
+         * \param[in]   lvl     Loglevel of message.
+         * \param[in]   format  Printf-like format string.
+         */
+        void log_ratelimited(log_ratelimit& rl, robotkernel::loglevel lvl, 
+                const char *format, ...) __attribute__((format(printf, 4, 5)));
+
+    private:
+        //! log to kernel logging facility
+        void vlog(robotkernel::loglevel lvl, const char *format, va_list args);
 };
 
+//! check if a message of given level has to be produced
+/*!
+ * \param[in]   lvl     Loglevel of message.
+ * \return true if message is printed or captured
+ */
+inline bool log_base::log_enabled(loglevel lvl) const {
+    return (lvl.value <= ll.value) || 
+        ((int)lvl.value <= capture_level.load(std::memory_order_relaxed));
+}
+
 //! Return current loglevel
 inline const loglevel log_base::get_loglevel() const { 
     return ll; 
@@ -101,5 +180,17 @@ inline void log_base::set_loglevel(loglevel ll) {
 
 }; // namespace robotkernel
 
+//! log with level check and per-callsite rate limiting
+/*!
+ * Arguments are not evaluated if the message is neither printed nor
+ * captured. Has to be called with a log_base object, e.g.
+ * RK_LOG(*this, info, "value %d\n", value).
+ */
+#define RK_LOG(lb, lvl, ...) do {                                       \
+    static robotkernel::log_ratelimit rk_log_rl__;                      \
+    if ((lb).log_enabled(lvl))                                          \
+        (lb).log_ratelimited(rk_log_rl__, lvl, __VA_ARGS__);            \
+} while (0)
+
 #endif // ROBOTKERNEL_LOG_BASE_H
 
@@ -99,7 +99,10 @@ class pd_provcon_base {
 
 class pd_provider : public pd_provcon_base {
     public:
-        pd_provider(const std::string& name) : pd_provcon_base(name) {}
+        int numa_node;      //!< NUMA node of providing thread, -1 if unknown
+
+        pd_provider(const std::string& name, int numa_node = -1) : 
+            pd_provcon_base(name), numa_node(numa_node) {}
 };
 
 class pd_consumer : public pd_provcon_base {
@@ -290,8 +293,18 @@ class process_data :
         virtual bool new_data() { return true; }
 
         //! set data provider thread, only thread allowed to write and push
+        /*!
+         * If the provider has a NUMA node set, the buffers are moved to
+         * that node.
+         */
         void set_provider(robotkernel::sp_pd_provider_t& prov);
 
+        //! move process data buffers to NUMA node
+        /*!
+         * \param[in] numa_node NUMA node of the cores accessing the data.
+         */
+        virtual void bind_numa_node(int /* numa_node */) {}
+
         //! reset data provider thread
         void reset_provider(sp_pd_provider_t& prov);
 
@@ -344,6 +357,10 @@ class process_data :
         std::shared_ptr<robotkernel::pd_provider> provider;
         std::shared_ptr<robotkernel::pd_consumer> consumer;
 
+        //! changed whenever process data devices are added or removed 
+        //! or their provider or consumer changes
+        static std::atomic<uint64_t> topology_generation;
+
     private: 
         bool trigger_dev_generated = false;
 };
@@ -391,6 +408,9 @@ class single_buffer :
          */
         uint8_t* pop(sp_pd_consumer_t& cons, bool do_trigger = true) override;
 
+        //! move process data buffers to NUMA node
+        void bind_numa_node(int numa_node) override;
+
         //! Write data to buffer.
         /*!
          * \param[in] hash      hash value, get it with set_provider!
@@ -500,6 +520,9 @@ class triple_buffer :
         //! Returns true if new data has been written
         bool new_data() override;
 
+        //! move process data buffers to NUMA node
+        void bind_numa_node(int numa_node) override;
+
     private:
         //! return current read buffer
         const std::vector<uint8_t>& front_buffer();
@@ -28,86 +28,176 @@
 #ifndef ROBOTKERNEL__RK_TYPE_H
 #define ROBOTKERNEL__RK_TYPE_H
 
-#include <functional>
+#include <stdint.h>
+#include <string.h>
+#include <new>
+#include <atomic>
+#include <string>
 #include <typeindex>
-#include <map>
-#include <mutex>
+#include <type_traits>
 #include <stdexcept>
 #include <vector>
 
 namespace robotkernel {
 
-typedef std::map<uint8_t *, size_t> reference_map_t;
-
+//! variant type for service arguments
+/*!
+ * Scalars, small plain structs and short strings are stored inline in
+ * the object, constructing or copying them never allocates. All other
+ * values are stored once in a reference counted payload, copies share
+ * the payload and only increment its atomic reference counter.
+ *
+ * Stored values are never modified, an assignment replaces the value.
+ */
 class rk_type {
     protected:
+        static const size_t inline_size      = 32;  //!< bytes of inline storage
+        static const size_t short_string_len = 15;  //!< longest inline string
+
+        //! type dependent operations on inline storage, NULL for memcpy
+        struct ops_t {
+            bool heap;                                  //!< storage holds payload pointer
+            void (*copy)(void *dst, const void *src);
+            void (*move)(void *dst, void *src);
+            void (*destroy)(void *p);
+        };
+
+        //! reference counted value
+        struct payload {
+            std::atomic<unsigned> refs;
+            void *data;                                 //!< points to value
+
+            payload() : refs(1), data(NULL) {}
+            virtual ~payload() {}
+        };
+
+        template<typename T>
+            struct payload_of : public payload {
+                T value;
+                payload_of(const T& value) : value(value) { data = &this->value; }
+            };
+
         template<typename T>
-            friend T rk_type_cast(rk_type &);
+            static void copy_inline(void *dst, const void *src) 
+            { new (dst) T(*static_cast<const T *>(src)); }
+        template<typename T>
+            static void move_inline(void *dst, void *src) 
+            { new (dst) T(std::move(*static_cast<T *>(src))); }
+        template<typename T>
+            static void destroy_inline(void *p) 
+            { static_cast<T *>(p)->~T(); }
 
-        static reference_map_t __refs;
-        static std::mutex      __refsLock;
+        template<typename T, bool pod>
+            struct inline_ops { static const ops_t ops; };
+
+        static const ops_t heap_ops;
+
+        template<typename T>
+            struct fits_inline {
+                static const bool value = std::is_pod<T>::value && 
+                    (sizeof(T) <= inline_size) && (alignof(T) <= alignof(uint64_t));
+            };
 
         std::type_index __type;     //!< data type for type conversions
-        uint8_t *__value;           //!< data storage pointer
-        std::function<void(void*)> __value_deleter;
+        const ops_t *__ops;         //!< storage operations, NULL if empty
+
+        union {
+            uint64_t u64;
+            double d;
+            payload *p;
+            uint8_t buf[inline_size];
+        } __storage;
+
+        //! return pointer to stored value, NULL if empty
+        const void *data() const {
+            if (!__ops)
+                return NULL;
+            return __ops->heap ? __storage.p->data : (const void *)__storage.buf;
+        }
 
-        void decrease_reference(uint8_t *ref) {
-            if (!ref) {
-                return;
+        //! store value inline
+        template<typename T>
+            void init(const T& value, std::true_type) {
+                new (__storage.buf) T(value);
+                __ops = &inline_ops<T, std::is_pod<T>::value>::ops;
             }
 
-            {
-                std::unique_lock<std::mutex> lock(__refsLock);
-
-                reference_map_t::iterator r = __refs.find(ref);
-                if (r == __refs.end())
-                    return; // should not happen!
+        //! store value in payload
+        template<typename T>
+            void init(const T& value, std::false_type) {
+                __storage.p = new payload_of<T>(value);
+                __ops = &heap_ops;
+            }
 
-                if (r->second > 1) {
-                    r->second --;
-                    return;
-                }
-                __refs.erase(ref);
+        template<typename T>
+            void init(const T& value) {
+                init(value, std::integral_constant<bool, fits_inline<T>::value>());
             }
-            // need to do this without lock held!
-            __value_deleter(ref);
+
+        //! strings are stored inline if they are short
+        void init(const std::string& value) {
+            if (value.size() <= short_string_len)
+                init(value, std::true_type());
+            else
+                init(value, std::false_type());
         }
 
-        void increase_reference(uint8_t *ref) {
-            if (!ref) {
+        //! drop stored value
+        void release() {
+            if (!__ops)
                 return;
-            }
-            
-            std::unique_lock<std::mutex> lock(__refsLock);
-
-            reference_map_t::iterator r = __refs.find(ref);
-            if (r == __refs.end()) {
-                __refs[ref] = 1;
-            } else {
-                r->second++;
-            }
+
+            if (__ops->heap) {
+                if (__storage.p->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    delete __storage.p;
+            } else if (__ops->destroy)
+                __ops->destroy(__storage.buf);
+
+            __ops = NULL;
         }
 
-        void set_value(uint8_t *value) {
-            if (value == __value) {
+        //! share or copy value of other object, has to be empty
+        void copy_from(const rk_type& obj) {
+            __type = obj.__type;
+            __ops  = obj.__ops;
+
+            if (!__ops)
                 return;
-            }
-            decrease_reference(__value);
-            increase_reference(value);
-            __value = value;
+
+            if (__ops->heap) {
+                __storage.p = obj.__storage.p;
+                __storage.p->refs.fetch_add(1, std::memory_order_relaxed);
+            } else if (__ops->copy)
+                __ops->copy(__storage.buf, obj.__storage.buf);
+            else
+                __storage = obj.__storage;
+        }
+
+        //! take value of other object, has to be empty
+        void move_from(rk_type& obj) {
+            __type = obj.__type;
+            __ops  = obj.__ops;
+
+            if (!__ops)
+                return;
+
+            if (!__ops->heap && __ops->move) {
+                __ops->move(__storage.buf, obj.__storage.buf);
+                __ops->destroy(obj.__storage.buf);
+            } else
+                __storage = obj.__storage;
+
+            obj.__ops = NULL;
         }
 
     public:
         //! default constructor
-        rk_type() : __type(typeid(int)), __value(NULL) {
+        rk_type() : __type(typeid(int)), __ops(NULL) {
         }
 
         //! destructor
         ~rk_type() {
-            if (__value) {
-                decrease_reference(__value);
-                __value = NULL;
-            }
+            release();
         }
 
         //! get type of rk_type
@@ -122,29 +212,47 @@ class rk_type {
          * \param value initial value
          */
         template<typename T>
-            rk_type(const T &value) : __type(typeid(T)), __value(NULL) {
-                set_value((uint8_t *) new T);
-                __value_deleter = [](void* p) { delete static_cast<T*>(p); };
-                *((T *) __value) = value;
+            rk_type(const T &value) : __type(typeid(T)), __ops(NULL) {
+                init(value);
             }
 
         //! copy constructor
         /*!
-         * \param value initial value
+         * \param obj   rk_type to copy
+         */
+        rk_type(const rk_type &obj) : __type(obj.__type), __ops(NULL) {
+            copy_from(obj);
+        }
+
+        //! move constructor
+        /*!
+         * \param obj   rk_type to move, empty afterwards
          */
-        rk_type(const rk_type &obj) : __type(obj.__type), __value(NULL) {
-            set_value(obj.__value);
-            __value_deleter = obj.__value_deleter;
+        rk_type(rk_type &&obj) noexcept : __type(obj.__type), __ops(NULL) {
+            move_from(obj);
         }
 
         //! assign operator
         /*!
          * \param rhs rk_type to assign
          */
-        rk_type &operator=(rk_type rhs) {
-            set_value(rhs.__value);
-            __value_deleter = rhs.__value_deleter;
-            __type = rhs.__type;
+        rk_type &operator=(const rk_type &rhs) {
+            if (this != &rhs) {
+                release();
+                copy_from(rhs);
+            }
+            return *this;
+        }
+
+        //! move assign operator
+        /*!
+         * \param rhs rk_type to move, empty afterwards
+         */
+        rk_type &operator=(rk_type &&rhs) noexcept {
+            if (this != &rhs) {
+                release();
+                move_from(rhs);
+            }
             return *this;
         }
 
@@ -156,32 +264,44 @@ class rk_type {
             operator T() const {
                 if (__type != typeid(T)) {
                     throw std::runtime_error(std::string("Unsupported cast"));
-                } else if (__value == NULL) {
+                } else if (!__ops) {
                     throw std::runtime_error(std::string("Uninitialized value!"));
                 }
-                return *static_cast<T *>((void *) __value);
+                return *static_cast<const T *>(data());
             }
 
 
-        std::string to_string();
+        std::string to_string() const;
 
         template<typename T>
         friend T rk_type_cast(const rk_type &rhs);
 };
 
+template<typename T, bool pod>
+const rk_type::ops_t rk_type::inline_ops<T, pod>::ops = { 
+    false, &rk_type::copy_inline<T>, &rk_type::move_inline<T>, &rk_type::destroy_inline<T> };
+
+//! plain data is copied with memcpy and needs no destruction
+template<typename T>
+struct rk_type::inline_ops<T, true> { static const ops_t ops; };
+
+template<typename T>
+const rk_type::ops_t rk_type::inline_ops<T, true>::ops = { false, NULL, NULL, NULL };
+
 template<typename T>
 T rk_type_cast(const rk_type &rhs) {
-    if (rhs.type() != typeid(T))
+    if ((rhs.type() != typeid(T)) || !rhs.__ops)
         throw std::exception();
 
-    return *static_cast<T *>((void *) rhs.__value);
+    return *static_cast<const T *>(rhs.data());
 }
 
 template<typename T>
 std::vector<rk_type> convertVector(const std::vector<T> &in) {
-    std::vector<rk_type> out(in.size());
-    for (int i = 0; i < in.size(); ++i) {
-        out[i] = in[i];
+    std::vector<rk_type> out;
+    out.reserve(in.size());
+    for (unsigned i = 0; i < in.size(); ++i) {
+        out.push_back(rk_type(in[i]));
     }
     return out;
 }
@@ -190,7 +310,7 @@ template<typename T>
 std::vector<T> convertVector2(const std::vector<rk_type> &in) {
     std::vector<T> out(in.size());
     for (unsigned i = 0; i < in.size(); ++i) {
-        out[i] = (T) in[i];
+        out[i] = in[i].operator T();
     }
     return out;
 }
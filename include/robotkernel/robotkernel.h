@@ -27,10 +27,13 @@
 #ifndef ROBOTKERNEL_KERNEL_BASE_H
 #define ROBOTKERNEL_KERNEL_BASE_H
 
+#include <future>
+
 #include "robotkernel/device.h"
 #include "robotkernel/device_listener.h"
 #include "robotkernel/service.h"
 #include "robotkernel/trigger.h"
+#include "robotkernel/fd_reactor.h"
 #include "robotkernel/process_data.h"
 #include "robotkernel/stream.h"
 #include "robotkernel/helpers.h"
@@ -43,12 +46,43 @@ namespace robotkernel {
  * \param name service name
  * \param service_definition service definition
  * \param callback service callback
+ * \param dispatch how the service is executed, may be 
+ *                 overridden by service_dispatch configuration
  */
 extern void add_service(
         const std::string &owner,
         const std::string &name,
         const std::string &service_definition,
-        service_callback_t callback);
+        service_callback_t callback,
+        service_dispatch_t dispatch = service_dispatch_inline);
+
+//! call a service asynchronously
+/*!
+ * Inline services are executed before returning, others are queued to
+ * the service worker pool. Throws if the worker queue is full.
+ *
+ * \param[in]  owner         Owner of service to call.
+ * \param[in]  name          Name of service to call.
+ * \param[in]  req           Service request parameters.
+ * \param[in]  done          Completion, called with response or exception.
+ */
+extern void call_service_async(
+        const std::string& owner,
+        const std::string& name,
+        const service_arglist_t& req,
+        service_completion_t done);
+
+//! call a service asynchronously
+/*!
+ * \param[in]  owner         Owner of service to call.
+ * \param[in]  name          Name of service to call.
+ * \param[in]  req           Service request parameters.
+ * \return future of service response
+ */
+extern std::future<service_arglist_t> call_service_async(
+        const std::string& owner,
+        const std::string& name,
+        const service_arglist_t& req);
 
 //! remove on service given by name
 /*!
@@ -107,6 +141,46 @@ inline std::shared_ptr<T> get_device(const std::string& dev_name) {
     return retval;
 };
 
+//! get interned handle of a device name
+/*!
+ * The device does not have to be registered yet. Looking up a device by
+ * its handle avoids the string compare of a lookup by name.
+ *
+ * \param dev_name device name
+ * \return device handle
+ */
+extern device_handle_t get_device_handle(const std::string& dev_name);
+
+//! get a device by handle
+/*!
+ * \param handle device handle from get_device_handle
+ * \return device
+ */
+extern std::shared_ptr<device> get_device(device_handle_t handle);
+
+//! get a device by handle
+/*!
+ * \param handle device handle from get_device_handle
+ * \return device
+ */
+template <typename T>
+inline std::shared_ptr<T> get_device(device_handle_t handle) {
+    std::shared_ptr<device> dev = get_device(handle);
+    std::shared_ptr<T> retval = std::dynamic_pointer_cast<T>(dev);
+    if (!retval)
+        throw std::runtime_error(robotkernel::string_printf("device %s is not of type %s\n", 
+                dev->id().c_str(), typeid(T).name()));
+
+    return retval;
+};
+
+//! get a fd reactor by name
+/*!
+ * \param[in] name      Name of fd reactor from config file.
+ * \return fd reactor
+ */
+extern sp_fd_reactor_t get_fd_reactor(const std::string& name);
+
 //! get robotkernel name
 extern const std::string name(void);
 
@@ -29,11 +29,42 @@
 
 #include <string>
 #include <thread>
+#include <atomic>
+#include <stdint.h>
 
 #include <yaml-cpp/yaml.h>
 
+#include "robotkernel/cpu_affinity.h"
+
 namespace robotkernel {
 
+//! thread settings of a runnable
+/*!
+ * Parsed from yaml without creating a thread, e.g. to compare the
+ * settings of an existing thread with a configuration.
+ */
+struct runnable_config {
+    int prio;                   //!< thread priority
+    cpu_affinity affinity;      //!< thread cpu affinity
+    int numa_node;              //!< NUMA node for thread memory, -1 if not bound
+    std::string thread_name;    //!< thread name
+
+    uint64_t dl_runtime;        //!< SCHED_DEADLINE runtime [ns]
+    uint64_t dl_deadline;       //!< SCHED_DEADLINE relative deadline [ns]
+    uint64_t dl_period;         //!< SCHED_DEADLINE period [ns], 0 if not used
+
+    //! construction with yaml node
+    /*!
+     * \param node yaml node which may contain prio, affinity (cpu number,
+     *             cpu list like "0-3,8" or sequence), numa_node, 
+     *             thread_name and sched_deadline with runtime, deadline 
+     *             and period in seconds
+     *
+     * \throw runtime_error on invalid SCHED_DEADLINE parameters.
+     */
+    runnable_config(const YAML::Node& node);
+};
+
 //! runnable base class
 /*!
  * derive from this class, if you need a runnable instance
@@ -50,7 +81,15 @@ class runnable {
 
         int policy;                 //!< thread scheduling policy
         int prio;                   //!< thread priority
-        int affinity_mask;          //!< thread cpu affinity mask
+        cpu_affinity affinity;      //!< thread cpu affinity
+        int numa_node;              //!< NUMA node for thread memory, -1 if not bound
+
+        uint64_t dl_runtime;        //!< SCHED_DEADLINE runtime [ns]
+        uint64_t dl_deadline;       //!< SCHED_DEADLINE relative deadline [ns]
+        uint64_t dl_period;         //!< SCHED_DEADLINE period [ns], 0 if not used
+
+        std::atomic<uint64_t> deadline_misses;  //!< jobs finished after deadline
+        std::atomic<uint64_t> runtime_overruns; //!< jobs consumed more than runtime
 
     protected:
         std::string thread_name;    //!< thread name used to set threads name with pthread_setname_np
@@ -58,13 +97,32 @@ class runnable {
         std::thread tid;            //!< thread handle
         bool run_flag;              //!< running flag
 
+        //! account one finished job of a deadline thread
+        /*!
+         * Has to be called by the runnable thread itself at the end of each
+         * job, counts deadline misses and runtime overruns.
+         *
+         * \param[in] release_ns    Job release time, kernel_clock [ns].
+         * \param[in] cpu_ns        CPU time consumed by the job [ns].
+         */
+        void account_job(uint64_t release_ns, uint64_t cpu_ns);
+
     public:
         //! construction with yaml node
         /*!
-         * \param node yaml node which must contain prio and affinity
+         * \param node yaml node which must contain prio and affinity 
+         *             (cpu number, cpu list like "0-3,8" or sequence),
+         *             optional numa_node and sched_deadline with runtime,
+         *             deadline and period in seconds
          */
         runnable(const YAML::Node& node);
 
+        //! construction with parsed thread settings
+        /*!
+         * \param config thread settings
+         */
+        runnable(const runnable_config& config);
+
         //! construction with prio and affinity_mask
         /*!
          * \param[in] prio          Runnable thread priority.
@@ -75,6 +133,16 @@ class runnable {
         runnable(const int prio = 0, const int affinity_mask = 0, 
                 std::string thread_name = "runnable");
 
+        //! construction with prio and cpu affinity
+        /*!
+         * \param[in] prio          Runnable thread priority.
+         * \param[in] affinity      Runnable thread cpu affinity.
+         * \param[in] thread_name   Name of runnable thread if started.
+         * \param[in] numa_node     NUMA node for thread memory, -1 for none.
+         */
+        runnable(const int prio, const cpu_affinity& affinity, 
+                std::string thread_name = "runnable", int numa_node = -1);
+
         //! destruction
         virtual ~runnable() {
             stop();
@@ -88,14 +156,46 @@ class runnable {
 
         const int& get_policy() const;        //!< return policy
         const int& get_prio() const;          //!< return priority 
-        const int& get_affinity_mask() const; //!< return affinity mask
+        int get_affinity_mask() const;        //!< return affinity mask of cpus 0 to 31
+        const cpu_affinity& get_affinity() const; //!< return cpu affinity
+        int get_numa_node() const;            //!< return NUMA node, -1 if not bound
         const std::string& get_name() const;  //!< return thread name.
 
         void set_policy(int policy);        //!< set policy
         void set_prio(int prio);            //!< set priority
         void set_affinity_mask(int mask);   //!< set affinity mask
+        void set_affinity(const cpu_affinity& affinity);    //!< set cpu affinity
+
+        //! bind thread memory to NUMA node
+        /*!
+         * Has to be set before the thread is started. The thread prefers
+         * memory of the node for all allocations, already touched stack 
+         * pages are moved. If no affinity is set, the thread runs on the
+         * cpus of the node.
+         *
+         * \param[in] node      NUMA node, -1 for none.
+         */
+        void set_numa_node(int node);
         void set_name(std::string name);    //!< set thread name
 
+        //! use SCHED_DEADLINE instead of priority
+        /*!
+         * Has to be set before the thread is started. With SCHED_DEADLINE 
+         * the kernel rejects cpu affinity masks, restrict such threads 
+         * with exclusive cpusets instead.
+         *
+         * \param[in] runtime_ns    Worst case execution time per period [ns].
+         * \param[in] deadline_ns   Relative deadline [ns], 0 for period.
+         * \param[in] period_ns     Period [ns], 0 disables SCHED_DEADLINE.
+         */
+        void set_deadline(uint64_t runtime_ns, uint64_t deadline_ns, uint64_t period_ns);
+
+        uint64_t get_dl_runtime() const     { return dl_runtime; }      //!< return deadline runtime [ns]
+        uint64_t get_dl_deadline() const    { return dl_deadline; }     //!< return relative deadline [ns]
+        uint64_t get_dl_period() const      { return dl_period; }       //!< return deadline period [ns]
+        uint64_t get_deadline_misses() const  { return deadline_misses; }   //!< return deadline misses
+        uint64_t get_runtime_overruns() const { return runtime_overruns; }  //!< return runtime overruns
+
         bool running();                     //!< returns true if thread is running
 };
 
@@ -107,8 +207,16 @@ inline const int& runnable::get_policy() const {
     return policy;
 }
 
-inline const int& runnable::get_affinity_mask() const { 
-    return affinity_mask; 
+inline int runnable::get_affinity_mask() const { 
+    return affinity.to_mask(); 
+}
+
+inline const cpu_affinity& runnable::get_affinity() const { 
+    return affinity; 
+}
+
+inline int runnable::get_numa_node() const { 
+    return numa_node; 
 }
 
 inline const int& runnable::get_prio() const {
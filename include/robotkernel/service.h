@@ -31,9 +31,13 @@
 #include <string>
 #include <map>
 #include <list>
+#include <memory>
+#include <atomic>
+#include <exception>
 #include <functional>
 
 #include "robotkernel/rk_type.h"
+#include "robotkernel/service_descriptor.h"
 
 typedef void (*get_sd_t)(std::list<std::string>& sd_list);
 
@@ -45,14 +49,94 @@ namespace robotkernel {
 typedef std::vector<rk_type> service_arglist_t;
 typedef std::function<int(const service_arglist_t&, service_arglist_t&)> service_callback_t;
 
+//! service dispatch mode
+typedef enum service_dispatch {
+    service_dispatch_inline = 0,    //!< run on calling thread
+    service_dispatch_async,         //!< run on service worker pool
+    service_dispatch_serialized     //!< run on service worker pool, one call per owner at a time
+} service_dispatch_t;
+
+//! completion of an asynchronous service call
+/*!
+ * \param resp  Service response parameters.
+ * \param ex    Exception thrown by service callback, NULL on success.
+ */
+typedef std::function<void(service_arglist_t& resp, std::exception_ptr ex)> service_completion_t;
+
+//! call statistics of one service
+/*!
+ * Updated lock-free by every call. Bin 0 of the latency histogram counts
+ * calls below 1 us, bin i calls from 2^(i-1) us to below 2^i us, the
+ * last bin all slower calls.
+ */
+struct service_call_stats {
+    static const unsigned histogram_bins = 20;
+
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> errors;           //!< non-zero return or exception
+    std::atomic<uint64_t> total_ns;         //!< sum of call durations
+    std::atomic<uint64_t> max_ns;           //!< longest call
+    std::atomic<uint64_t> histogram[histogram_bins];
+
+    service_call_stats() { reset(); }
+
+    //! reset all counters
+    void reset() {
+        calls    = 0;
+        errors   = 0;
+        total_ns = 0;
+        max_ns   = 0;
+
+        for (unsigned i = 0; i < histogram_bins; ++i)
+            histogram[i] = 0;
+    }
+
+    //! account one call
+    /*!
+     * \param[in] ns        Call duration [ns].
+     * \param[in] failed    Call returned error or threw.
+     */
+    void record(uint64_t ns, bool failed) {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        total_ns.fetch_add(ns, std::memory_order_relaxed);
+        if (failed)
+            errors.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t cur = max_ns.load(std::memory_order_relaxed);
+        while ((ns > cur) && !max_ns.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {}
+
+        uint64_t us = ns / 1000;
+        unsigned bin = us ? 64 - __builtin_clzll(us) : 0;
+        if (bin >= histogram_bins)
+            bin = histogram_bins - 1;
+
+        histogram[bin].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+typedef std::shared_ptr<service_call_stats> sp_service_call_stats_t;
+
+//! typed in-process service handler, see local_service.h
+struct service_local_handler_base {
+    virtual ~service_local_handler_base() {}
+};
+
+typedef std::shared_ptr<const service_local_handler_base> sp_service_local_handler_t;
+
 typedef struct service {
     std::string owner;
     std::string name;
     std::string service_definition;
-    service_callback_t callback;
+    sp_service_descriptor_t descriptor; //!< parsed service definition
+    service_callback_t callback;    //!< synchronous call, waits for queued services
+    service_dispatch_t dispatch;    //!< how the service is executed
+    service_callback_t handler;     //!< service implementation
+    sp_service_call_stats_t stats;  //!< call statistics, updated by callback
+    sp_service_local_handler_t local; //!< typed handler, use std::atomic_load/store
 } service_t;
 
-typedef std::map<std::pair<std::string, std::string>, service_t *> service_map_t;
+typedef std::shared_ptr<service_t> sp_service_t;
+typedef std::map<std::pair<std::string, std::string>, sp_service_t> service_map_t;
 
 #ifdef EMACS
 {
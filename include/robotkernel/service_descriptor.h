@@ -0,0 +1,106 @@
+//! robotkernel service descriptor
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__SERVICE_DESCRIPTOR_H
+#define ROBOTKERNEL__SERVICE_DESCRIPTOR_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! type of one service argument
+typedef enum service_field_type {
+    service_field_string = 0,
+    service_field_double,
+    service_field_float,
+    service_field_int8,
+    service_field_uint8,
+    service_field_int16,
+    service_field_uint16,
+    service_field_int32,
+    service_field_uint32,
+    service_field_int64,
+    service_field_uint64,
+    service_field_unknown           //!< not supported, see type_name
+} service_field_type_t;
+
+//! one field of a service definition
+struct service_field_descriptor {
+    std::string name;               //!< field name
+    std::string type_name;          //!< type as written in definition, e.g. "vector/string"
+    service_field_type_t type;      //!< (element) type
+    bool is_array;                  //!< field is a vector of type
+    size_t offset;                  //!< index in service argument list
+};
+
+typedef std::vector<service_field_descriptor> service_fields_t;
+
+//! parsed service definition
+/*!
+ * Built once by the kernel when a service is added and shared by all
+ * services with the same definition. Bridges can use it to marshal 
+ * requests and responses without parsing the yaml definition.
+ */
+struct service_descriptor {
+    service_fields_t request;       //!< request fields in argument order
+    service_fields_t response;      //!< response fields in argument order
+
+    //! parse service definition
+    /*!
+     * \param[in] definition    Service definition (yaml).
+     * \return descriptor
+     */
+    static std::shared_ptr<const service_descriptor> parse(const std::string& definition);
+
+    //! find request field by name
+    /*!
+     * \param[in] name      Field name.
+     * \return field or NULL if not found
+     */
+    const service_field_descriptor *find_request(const std::string& name) const;
+    
+    //! find response field by name
+    /*!
+     * \param[in] name      Field name.
+     * \return field or NULL if not found
+     */
+    const service_field_descriptor *find_response(const std::string& name) const;
+};
+
+typedef std::shared_ptr<const service_descriptor> sp_service_descriptor_t;
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__SERVICE_DESCRIPTOR_H
+
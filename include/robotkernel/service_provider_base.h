@@ -189,7 +189,7 @@ class service_provider_base :
          */
         service_provider_base(const std::string& name, const std::string& impl) : 
             log_base(name, impl, ""),
-            device_listener(name, "listener")
+            device_listener(name, "listener", device_type_service_interface)
         {};
         
         void init() {
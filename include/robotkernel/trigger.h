@@ -29,6 +29,8 @@
 
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <stdexcept>
 
 // public headers
@@ -36,6 +38,7 @@
 #include "robotkernel/device.h"
 #include "robotkernel/trigger_base.h"
 #include "robotkernel/trigger_worker.h"
+#include "robotkernel/trigger_scheduler.h"
 
 namespace robotkernel {
 
@@ -70,6 +73,56 @@ class trigger_waiter :
 
 typedef std::shared_ptr<trigger_waiter> sp_trigger_waiter_t;
 
+//! pollable trigger subscription
+/*!
+ * Each tick increments an eventfd counter (a non-blocking pipe on systems
+ * without eventfd). The file descriptor can be registered in poll/epoll/select
+ * alongside sockets, so one thread can multiplex many triggers. The 
+ * subscription stays registered at the trigger and is reused for every 
+ * wait, nothing is allocated per tick or per wait.
+ */
+class trigger_eventfd :
+    public trigger_base
+{
+    private:
+        trigger_eventfd(const trigger_eventfd&);                // prevent copy-construction
+        trigger_eventfd& operator=(const trigger_eventfd&);     // prevent assignment
+
+        int fd;             //!< eventfd or read end of pipe
+        int wr_fd;          //!< write end of pipe, equals fd with eventfd
+
+    public:
+        //! construction
+        /*!
+         * \param[in] divisor   Tick every ""divisor"" trigger.
+         */
+        trigger_eventfd(int divisor = 1);
+
+        //! destruction
+        ~trigger_eventfd();
+
+        //! return file descriptor, readable if ticks are pending
+        int get_fd() const { return fd; }
+
+        //! trigger function
+        void tick();
+
+        //! consume pending ticks
+        /*!
+         * \return number of ticks since last consume, 0 if none.
+         */
+        uint64_t consume();
+
+        //! wait blocking for next tick
+        /*!
+         * \param[in] timeout   Wait timeout in seconds.
+         * \return true if ticked, false on timeout.
+         */
+        bool wait(double timeout);
+};
+
+typedef std::shared_ptr<trigger_eventfd> sp_trigger_eventfd_t;
+
 class trigger :
     public device
 {
@@ -80,6 +133,15 @@ class trigger :
         std::mutex list_mtx;                    //!< protection for trigger list
         trigger_list_t triggers;                //!< trigger callback list
         trigger_workers_t workers;              //!< workers
+        sp_trigger_scheduler_t scheduler;       //!< optional parallel scheduler
+
+        std::mutex wait_mtx;                    //!< protection for wait_cond
+        std::condition_variable wait_cond;      //!< signalled on every trigger
+        uint64_t wait_generation;               //!< incremented on every trigger
+        std::atomic<int> waiters;               //!< threads blocked in wait
+
+        //! wake up threads blocked in wait
+        void notify_waiters();
 
     protected:
         double rate;                            //!< trigger rate in [Hz]
@@ -108,6 +170,17 @@ class trigger :
         void add_trigger(sp_trigger_base_t trigger, bool direct_mode=true,
                 int worker_prio=0, int worker_affinity=0);
 
+        //! add a trigger callback function executed by a worker thread
+        /*!
+         * Callbacks with equal worker configuration share one worker.
+         *
+         * \param[in] trigger       Trigger callback.
+         * \param[in] worker_config Worker configuration, may contain prio,
+         *                          affinity and sched_deadline (runtime, 
+         *                          deadline, period in seconds).
+         */
+        void add_trigger(sp_trigger_base_t trigger, const YAML::Node& worker_config);
+
         //! remove a trigger callback function
         /*!
          * \param obj trigger object to trigger callback
@@ -129,14 +202,40 @@ class trigger :
          */
         virtual void set_rate(double new_rate);
 
+        //! set parallel scheduler for direct mode callbacks
+        /*!
+         * \param[in] sched     Scheduler to use, nullptr to execute 
+         *                      callbacks serially in list order.
+         */
+        void set_scheduler(sp_trigger_scheduler_t sched);
+
         //! trigger all modules in list
         void do_trigger();
 
         //! wait blocking for next trigger
         /*!
          * \param[in] timeout   Wait timeout in seconds.
+         *
+         * \throw runtime_error on timeout.
          */
         void wait(double timeout);
+
+        //! wait blocking for next trigger
+        /*!
+         * \param[in] timeout   Wait timeout in seconds.
+         * \return true if triggered, false on timeout.
+         */
+        bool try_wait(double timeout);
+
+        //! create pollable subscription
+        /*!
+         * The returned subscription is registered in direct mode until
+         * it is passed to \link remove_trigger \endlink.
+         *
+         * \param[in] divisor   Rate divisor.
+         * \return subscription holding the file descriptor.
+         */
+        sp_trigger_eventfd_t subscribe(int divisor = 1);
 };
 
 typedef std::shared_ptr<trigger> sp_trigger_t;
@@ -30,6 +30,7 @@
 #include <string>
 #include <memory>
 #include <list>
+#include <set>
 
 namespace robotkernel {
 
@@ -43,7 +44,15 @@ class trigger_base {
         int divisor;        //!< trigger every ""divisor"" step
         int cnt;            //!< internal step counter
 
+        //! optional name of callback, used by trigger_scheduler to match
+        //  explicit dependencies and pd provider/consumer names
+        std::string name;
+
+        std::set<std::string> reads;    //!< ids of process data read in tick()
+        std::set<std::string> writes;   //!< ids of process data written in tick()
+
         trigger_base(int divisor=1) : divisor(divisor), cnt(0) {};
+        virtual ~trigger_base() {};
     
         //! trigger function
         virtual void tick() = 0;
@@ -29,7 +29,7 @@
 #define ROBOTKERNEL__TRIGGER_COLLECTOR_H
 
 #include <stdint.h>
-#include <time.h>
+#include "robotkernel/kernel_clock.h"
 
 #include <functional>
 
@@ -112,10 +112,9 @@ class trigger_collector {
             receive_timeout = 0;
         }
 
+        //! monotonic timestamp [s], not affected by wall clock steps
         double get_timestamp() {
-            struct timespec ts;
-            clock_gettime(CLOCK_REALTIME, &ts);
-            return (double) ts.tv_sec + (ts.tv_nsec / 1e9);
+            return kernel_clock::now_ns() / 1e9;
         }
 
     protected:
@@ -0,0 +1,155 @@
+//! robotkernel trigger scheduler
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__TRIGGER_SCHEDULER_H
+#define ROBOTKERNEL__TRIGGER_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <mutex>
+#include <exception>
+#include <condition_variable>
+
+#include "robotkernel/runnable.h"
+#include "robotkernel/trigger_base.h"
+
+#include <yaml-cpp/yaml.h>
+
+namespace robotkernel {
+
+//! trigger scheduler class
+/*!
+ * Executes all callbacks of one trigger device as a dependency graph.
+ * Edges are derived from the process data read and written by the
+ * callbacks (trigger_base::reads, trigger_base::writes, pd provider and
+ * consumer names) and from explicit dependencies in the configuration.
+ * Independent callbacks are executed in parallel on a set of pinned worker
+ * threads, the calling thread joins at a barrier when all callbacks of the
+ * current cycle have finished.
+ *
+ * Callbacks without any dependency information are executed in list order
+ * with respect to all other callbacks. The graph is rebuilt before the
+ * next cycle if process data devices or their providers or consumers
+ * have changed.
+ *
+ * An exception thrown by a callback is rethrown by execute() after all
+ * callbacks of the cycle have finished, like the serial path does.
+ */
+class trigger_scheduler {
+    private:
+        trigger_scheduler(const trigger_scheduler&);             // prevent copy-construction
+        trigger_scheduler& operator=(const trigger_scheduler&);  // prevent assignment
+
+        class worker : public runnable {
+            public:
+                worker(trigger_scheduler& sched, int prio, int cpu);
+                ~worker();
+
+                //! handler function called if thread is running
+                void run();
+
+            private:
+                trigger_scheduler& sched;
+        };
+
+        typedef std::shared_ptr<worker> sp_worker_t;
+
+        struct node {
+            sp_trigger_base_t t;                //!< callback
+            bool fire;                          //!< divisor matched in this cycle
+            int n_preds;                        //!< number of predecessors
+            int pending;                        //!< unfinished predecessors in this cycle
+            std::vector<int> successors;        //!< dependent nodes
+            uint64_t exec_ns;                   //!< averaged execution time
+            uint64_t rank;                      //!< upward rank (critical path length)
+        };
+
+        std::vector<node> nodes;                //!< nodes in topological order
+        std::vector<int> ready;                 //!< ready nodes in current cycle
+        int done;                               //!< finished nodes in current cycle
+        std::exception_ptr error;               //!< first exception of current cycle
+        uint64_t pd_generation;                 //!< process data topology of graph
+
+        std::mutex              mtx;            //!< protects cycle state
+        std::condition_variable cond;           //!< signals ready nodes and cycle end
+
+        typedef std::map<std::string, std::list<std::string> > depends_map_t;
+        depends_map_t depends;                  //!< explicit dependencies by callback name
+
+        std::vector<sp_worker_t> workers;       //!< pinned worker threads
+
+        //! run ready nodes of current cycle until none is left
+        /*!
+         * \param[in] lock      Locked cycle mutex.
+         * \param[in] wait      Wait for more ready nodes until cycle finished.
+         */
+        void process(std::unique_lock<std::mutex>& lock, bool wait);
+
+        //! recalculate upward ranks from measured execution times
+        void update_ranks();
+
+    public:
+        //! construction with yaml node
+        /*!
+         * \param[in] node  Scheduler configuration, may contain
+         *                  prio, cpus (cpu list, one worker per cpu)
+         *                  and depends.
+         */
+        trigger_scheduler(const YAML::Node& node);
+
+        //! destruction
+        ~trigger_scheduler();
+
+        //! rebuild dependency graph
+        /*!
+         * Has to be called whenever the trigger list changes.
+         *
+         * \param[in] triggers  Trigger callbacks in list order.
+         */
+        void rebuild(const trigger_list_t& triggers);
+
+        //! true if process data topology changed since last rebuild
+        bool outdated() const;
+
+        //! execute one cycle
+        /*!
+         * Runs all callbacks whose divisor matches and returns after all of
+         * them have finished.
+         */
+        void execute();
+
+        //! return number of worker threads
+        size_t worker_count() const { return workers.size(); }
+};
+
+typedef std::shared_ptr<trigger_scheduler> sp_trigger_scheduler_t;
+
+}; // namespace robotkernel
+
+#endif // ROBOTKERNEL__TRIGGER_SCHEDULER_H
+
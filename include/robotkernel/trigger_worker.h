@@ -30,6 +30,7 @@
 #include <string>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 
 // public header
 #include "robotkernel/runnable.h"
@@ -50,8 +51,11 @@ class trigger_worker :
     public:
         struct worker_key {
             int prio;
-            int affinity;
+            cpu_affinity affinity;
             int divisor;
+            uint64_t dl_runtime;
+            uint64_t dl_deadline;
+            uint64_t dl_period;
 
             bool operator<(const worker_key& a) const;
         };
@@ -59,6 +63,14 @@ class trigger_worker :
         //! default construction
         trigger_worker(int prio = 60, int affinity_mask = 0xFF, int divisor=1);
 
+        //! construction with yaml node
+        /*!
+         * \param[in] node      Worker configuration, may contain prio, 
+         *                      affinity, thread_name and sched_deadline.
+         * \param[in] divisor   Rate divisor.
+         */
+        trigger_worker(const YAML::Node& node, int divisor=1);
+
         //! destruction
         ~trigger_worker();
 
@@ -85,6 +97,7 @@ class trigger_worker :
 
     private:
         trigger_list_t triggers;
+        std::atomic<uint64_t> release_ns;   //!< time of last tick
 
         std::condition_variable cond;
         std::mutex              mtx;
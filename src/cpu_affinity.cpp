@@ -0,0 +1,191 @@
+//! robotkernel cpu affinity
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/cpu_affinity.h"
+#include "robotkernel/helpers.h"
+
+#include <fstream>
+#include <cstdlib>
+
+using namespace std;
+using namespace robotkernel;
+
+//! construction from legacy bit mask
+/*!
+ * \param[in] mask      Bit mask of cpus 0 to 31.
+ */
+cpu_affinity::cpu_affinity(int mask) {
+    for (int i = 0; i < 32; ++i)
+        if ((unsigned)mask & (1u << i))
+            cpus.set(i);
+}
+
+//! construction from cpu list
+/*!
+ * \param[in] list      Cpu list, e.g. "0-3,8,10-11".
+ */
+cpu_affinity::cpu_affinity(const std::string& list) {
+    for (const auto& token : string_split(list, ',')) {
+        if (token.find_first_not_of(" \t\n") == string::npos)
+            continue;
+
+        const char *p = token.c_str();
+        char *end;
+
+        long from = strtol(p, &end, 10), to = from;
+        if (end == p)
+            throw runtime_error(string_printf("invalid cpu list \"%s\"", list.c_str()));
+
+        while (*end == ' ') end++;
+        if (*end == '-') {
+            p = end + 1;
+            to = strtol(p, &end, 10);
+            if (end == p)
+                throw runtime_error(string_printf("invalid cpu list \"%s\"", list.c_str()));
+        }
+
+        while ((*end == ' ') || (*end == '\n')) end++;
+        if ((*end != '\0') || (from < 0) || (to < from) || (to >= max_cpus))
+            throw runtime_error(string_printf("invalid cpu list \"%s\"", list.c_str()));
+
+        for (long cpu = from; cpu <= to; ++cpu)
+            cpus.set(cpu);
+    }
+}
+
+//! construction from yaml node
+/*!
+ * \param[in] node      Cpu number, cpu list string or sequence of both.
+ */
+cpu_affinity::cpu_affinity(const YAML::Node& node) {
+    if (node.Type() == YAML::NodeType::Scalar)
+        *this = cpu_affinity(node.as<string>());
+    else if (node.Type() == YAML::NodeType::Sequence)
+        for (const auto& n : node)
+            *this |= cpu_affinity(n.as<string>());
+}
+
+//! return all cpus of a NUMA node
+/*!
+ * \param[in] node      NUMA node number.
+ */
+cpu_affinity cpu_affinity::numa_node_cpus(int node) {
+    string fn = string_printf("/sys/devices/system/node/node%d/cpulist", node);
+    ifstream f(fn);
+    string list;
+
+    if (!f.is_open() || !getline(f, list))
+        throw runtime_error(string_printf("cannot read cpus of NUMA node %d from %s", 
+                    node, fn.c_str()));
+
+    return cpu_affinity(list);
+}
+
+//! add cpu to set
+void cpu_affinity::set(int cpu) {
+    if ((cpu < 0) || (cpu >= max_cpus))
+        throw runtime_error(string_printf("cpu %d out of range", cpu));
+
+    cpus.set(cpu);
+}
+
+//! remove cpu from set
+void cpu_affinity::reset(int cpu) {
+    if ((cpu >= 0) && (cpu < max_cpus))
+        cpus.reset(cpu);
+}
+
+//! test if cpu is in set
+bool cpu_affinity::is_set(int cpu) const {
+    return (cpu >= 0) && (cpu < max_cpus) && cpus.test(cpu);
+}
+
+//! return lowest cpu in set, -1 if empty
+int cpu_affinity::first() const {
+    return next(-1);
+}
+
+//! return next cpu in set after cpu, -1 if none
+int cpu_affinity::next(int cpu) const {
+    for (int i = cpu + 1; i < max_cpus; ++i)
+        if (cpus.test(i))
+            return i;
+
+    return -1;
+}
+
+//! return cpu list string, e.g. "0-3,8"
+std::string cpu_affinity::to_string() const {
+    string ret;
+
+    for (int from = first(); from != -1; ) {
+        int to = from;
+        while ((to + 1 < max_cpus) && cpus.test(to + 1))
+            to++;
+
+        if (!ret.empty())
+            ret += ",";
+
+        ret += (to == from) ? string_printf("%d", from) : string_printf("%d-%d", from, to);
+        from = next(to);
+    }
+
+    return ret;
+}
+
+//! return legacy bit mask, only cpus 0 to 31
+int cpu_affinity::to_mask() const {
+    unsigned mask = 0;
+
+    for (int i = 0; i < 32; ++i)
+        if (cpus.test(i))
+            mask |= (1u << i);
+
+    return (int)mask;
+}
+
+#ifdef __linux__
+//! fill cpu_set_t
+/*!
+ * \param[out] set      Set to fill, cleared before.
+ */
+void cpu_affinity::to_cpu_set(cpu_set_t& set) const {
+    CPU_ZERO(&set);
+
+    for (int i = first(); (i != -1) && (i < CPU_SETSIZE); i = next(i))
+        CPU_SET(i, &set);
+}
+#endif
+
+bool cpu_affinity::operator<(const cpu_affinity& a) const {
+    for (int i = max_cpus - 1; i >= 0; --i)
+        if (cpus.test(i) != a.cpus.test(i))
+            return a.cpus.test(i);
+
+    return false;
+}
+
@@ -0,0 +1,253 @@
+//! robotkernel cyclic executive
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/helpers.h"
+#include "robotkernel/kernel_clock.h"
+
+// private headers
+#include "kernel.h"
+#include "cyclic_executive.h"
+
+#include <time.h>
+#include <errno.h>
+
+using namespace std;
+using namespace robotkernel;
+
+static uint64_t get_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t abs_ns) {
+    struct timespec ts;
+    ts.tv_sec  = abs_ns / 1000000000ull;
+    ts.tv_nsec = abs_ns % 1000000000ull;
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
+
+//! core construction
+/*!
+ * \param[in] exec      Owning executive.
+ * \param[in] node      Core configuration with prio, affinity and frames.
+ */
+cyclic_executive::core::core(cyclic_executive& exec, const YAML::Node& node) :
+    runnable(node), exec(exec)
+{
+    if (!node["thread_name"])
+        set_name(string_printf("rk:ce.%s", exec.name.c_str()));
+
+    const YAML::Node& frames_node = node["frames"];
+    if (!frames_node || !frames_node.IsSequence())
+        throw runtime_error(string_printf("[cyclic_executive] %s: core needs a "
+                    "sequence of frames!", exec.name.c_str()));
+
+    uint64_t dflt_budget = exec.minor_period_ns;
+    if (node["budget"])
+        dflt_budget = get_as<double>(node, "budget") * 1e9;
+
+    for (const auto& frame : frames_node) {
+        std::vector<sp_trigger_t> entries;
+
+        if (frame.IsScalar())
+            entries.push_back(exec.triggers[frame.as<string>()]);
+        else
+            for (const auto& entry : frame)
+                entries.push_back(exec.triggers[entry.as<string>()]);
+
+        frames.push_back(entries);
+        budgets.push_back(dflt_budget);
+    }
+
+    if (dflt_budget > exec.minor_period_ns)
+        throw runtime_error(string_printf("[cyclic_executive] %s: frame budget "
+                    "exceeds minor period!", exec.name.c_str()));
+
+    stats.reset(new frame_stats[frames.size()]);
+}
+
+//! core destruction
+cyclic_executive::core::~core() {
+    stop();
+}
+
+//! handler function called if thread is running
+void cyclic_executive::core::run() {
+    uint64_t minor = exec.minor_period_ns;
+    uint64_t k = 0;
+
+    while (running()) {
+        uint64_t release = exec.base_ns + (k * minor);
+        sleep_until_ns(release);
+
+        size_t f = k % frames.size();
+        uint64_t start = kernel_clock::now_ns();
+
+        for (const auto& t : frames[f])
+            t->do_trigger();
+
+        uint64_t exec_ns = kernel_clock::now_ns() - start;
+        frame_stats& st = stats[f];
+
+        if (exec_ns > st.max_exec_ns)
+            st.max_exec_ns = exec_ns;
+
+        // frame has to be finished before next release, compare on the
+        // clock releases are scheduled with
+        uint64_t end = get_ns();
+        uint64_t next = k + 1;
+        if (end > (exec.base_ns + (next * minor))) {
+            st.overruns++;
+
+            // skip missed releases, but keep frame alignment
+            next = ((end - exec.base_ns) / minor) + 1;
+        }
+
+        k = next;
+    }
+}
+
+//! construction
+/*!
+ * \param[in] node  YAML node with executive configuration.
+ */
+cyclic_executive::cyclic_executive(const YAML::Node& node) :
+    base_ns(0), name(get_as<string>(node, "name"))
+{
+    minor_period_ns = get_as<double>(node, "minor_period") * 1e9;
+    verify_cycles   = get_as<unsigned int>(node, "verify_cycles", 100);
+
+    if (minor_period_ns == 0)
+        throw runtime_error(string_printf("[cyclic_executive] %s: minor_period "
+                    "must not be 0!", name.c_str()));
+
+    const YAML::Node& cores_node = node["cores"];
+    if (!cores_node || !cores_node.IsSequence())
+        throw runtime_error(string_printf("[cyclic_executive] %s: needs a "
+                    "sequence of cores!", name.c_str()));
+
+    // create trigger device for each table entry
+    std::map<std::string, unsigned int> occurrences;
+    minor_frames = 0;
+
+    for (const auto& c : cores_node) {
+        size_t n = 0;
+
+        for (const auto& frame : c["frames"]) {
+            if (frame.IsScalar())
+                occurrences[frame.as<string>()]++;
+            else
+                for (const auto& entry : frame)
+                    occurrences[entry.as<string>()]++;
+            n++;
+        }
+
+        if (minor_frames == 0)
+            minor_frames = n;
+        else if (n != minor_frames)
+            throw runtime_error(string_printf("[cyclic_executive] %s: all cores need "
+                        "the same number of minor frames!", name.c_str()));
+    }
+
+    if (minor_frames == 0)
+        throw runtime_error(string_printf("[cyclic_executive] %s: no frames "
+                    "configured!", name.c_str()));
+
+    double major_period = (minor_frames * minor_period_ns) / 1e9;
+    for (const auto& kv : occurrences)
+        triggers[kv.first] = make_shared<trigger>(name, kv.first, kv.second / major_period);
+
+    for (const auto& c : cores_node)
+        cores.push_back(make_shared<core>(*this, c));
+
+    for (const auto& kv : triggers)
+        kernel::instance.add_device(kv.second);
+
+    kernel::instance.log(info, "[cyclic_executive] %s: %d cores, %d minor frames "
+            "of %.3f ms\n", name.c_str(), (int)cores.size(), (int)minor_frames, 
+            minor_period_ns / 1e6);
+}
+
+//! destruction
+cyclic_executive::~cyclic_executive() {
+    cores.clear();
+
+    for (const auto& kv : triggers)
+        kernel::instance.remove_device(kv.second);
+}
+
+//! start all core threads on a common time base
+void cyclic_executive::start() {
+    // first release on next major frame boundary, at least 10 ms from now
+    uint64_t major = minor_frames * minor_period_ns;
+    base_ns = (((get_ns() + 10000000ull) / major) + 1) * major;
+
+    for (auto& c : cores)
+        c->start();
+}
+
+//! verify measured frame execution times
+/*!
+ * Measures verify_cycles major frames and checks that every minor
+ * frame fits its budget.
+ *
+ * \throw runtime_error if a frame exceeds its budget.
+ */
+void cyclic_executive::verify() {
+    for (auto& c : cores) {
+        for (size_t f = 0; f < c->frames.size(); ++f) {
+            c->stats[f].max_exec_ns = 0;
+            c->stats[f].overruns = 0;
+        }
+    }
+
+    sleep_until_ns(get_ns() + (verify_cycles * minor_frames * minor_period_ns));
+
+    string failed;
+    for (size_t i = 0; i < cores.size(); ++i) {
+        const auto& c = cores[i];
+
+        for (size_t f = 0; f < c->frames.size(); ++f) {
+            uint64_t max_exec = c->stats[f].max_exec_ns;
+            uint64_t overruns = c->stats[f].overruns;
+
+            RK_LOG(kernel::instance, verbose, "[cyclic_executive] %s: core %d frame %d "
+                    "max %.3f ms, budget %.3f ms, overruns %llu\n", name.c_str(), (int)i, 
+                    (int)f, max_exec / 1e6, c->budgets[f] / 1e6, (unsigned long long)overruns);
+
+            if ((max_exec > c->budgets[f]) || overruns)
+                failed += string_printf(" core %d frame %d (%.3f ms > %.3f ms)", 
+                        (int)i, (int)f, max_exec / 1e6, c->budgets[f] / 1e6);
+        }
+    }
+
+    if (failed != "")
+        throw runtime_error(string_printf("[cyclic_executive] %s: frames exceed "
+                    "their budget:%s", name.c_str(), failed.c_str()));
+}
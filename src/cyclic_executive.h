@@ -0,0 +1,134 @@
+//! robotkernel cyclic executive
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__CYCLIC_EXECUTIVE_H
+#define ROBOTKERNEL__CYCLIC_EXECUTIVE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+
+// public headers
+#include "robotkernel/runnable.h"
+#include "robotkernel/trigger.h"
+
+#include "yaml-cpp/yaml.h"
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! time-triggered cyclic executive
+/*!
+ * Runs a static table of trigger devices. The major frame is split into
+ * minor frames of fixed length. For each core one pinned thread executes
+ * the triggers of the current minor frame, released by an absolute time
+ * base tick shared by all cores (clock_nanosleep with TIMER_ABSTIME).
+ *
+ * Every table entry is a trigger device owned by the executive, named
+ * <executive name>.<entry>.trigger. Modules attach their callbacks to
+ * these triggers in direct mode.
+ */
+class cyclic_executive {
+    private:
+        cyclic_executive();
+        cyclic_executive(const cyclic_executive&);              // prevent copy-construction
+        cyclic_executive& operator=(const cyclic_executive&);   // prevent assignment
+
+        struct frame_stats {
+            std::atomic<uint64_t> max_exec_ns;  //!< max execution time of frame
+            std::atomic<uint64_t> overruns;     //!< frame did not finish in time
+
+            frame_stats() : max_exec_ns(0), overruns(0) {}
+        };
+
+        //! one pinned thread per core
+        class core : public runnable {
+            public:
+                core(cyclic_executive& exec, const YAML::Node& node);
+                ~core();
+
+                //! handler function called if thread is running
+                void run();
+
+                std::vector<std::vector<sp_trigger_t> > frames;     //!< triggers per minor frame
+                std::vector<uint64_t> budgets;                      //!< budget per minor frame [ns]
+                std::unique_ptr<frame_stats[]> stats;               //!< statistics per minor frame
+
+            private:
+                cyclic_executive& exec;
+        };
+
+        typedef std::shared_ptr<core> sp_core_t;
+
+        std::vector<sp_core_t> cores;                   //!< executing cores
+        std::map<std::string, sp_trigger_t> triggers;   //!< table entries by name
+
+        uint64_t minor_period_ns;       //!< length of minor frame [ns]
+        size_t minor_frames;            //!< minor frames per major frame
+        unsigned int verify_cycles;     //!< major frames measured by verify
+        uint64_t base_ns;               //!< absolute time base, CLOCK_MONOTONIC [ns]
+
+    public:
+        const std::string name;         //!< executive name
+
+        //! construction
+        /*!
+         * \param[in] node  YAML node with executive configuration.
+         */
+        cyclic_executive(const YAML::Node& node);
+
+        //! destruction
+        ~cyclic_executive();
+
+        //! start all core threads on a common time base
+        void start();
+
+        //! verify measured frame execution times
+        /*!
+         * Measures verify_cycles major frames and checks that every minor
+         * frame fits its budget.
+         *
+         * \throw runtime_error if a frame exceeds its budget.
+         */
+        void verify();
+
+        //! return all table entry triggers
+        const std::map<std::string, sp_trigger_t>& get_triggers() const 
+        { return triggers; }
+};
+
+typedef std::shared_ptr<cyclic_executive> sp_cyclic_executive_t;
+typedef std::map<std::string, sp_cyclic_executive_t> cyclic_executive_map_t;
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__CYCLIC_EXECUTIVE_H
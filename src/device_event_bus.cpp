@@ -0,0 +1,373 @@
+//! robotkernel device event bus
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/process_data.h"
+#include "robotkernel/trigger.h"
+#include "robotkernel/stream.h"
+#include "robotkernel/service_interface.h"
+#include "robotkernel/helpers.h"
+
+// private headers
+#include "device_event_bus.h"
+#include "kernel.h"
+
+using namespace std;
+using namespace robotkernel;
+
+//! set while the current thread calls listeners
+static thread_local bool _in_delivery = false;
+
+//! worker construction
+/*!
+ * \param[in] bus       Owning event bus.
+ * \param[in] node      Thread configuration.
+ */
+device_event_bus::worker::worker(device_event_bus& bus, const YAML::Node& node) :
+    runnable(get_as<int>(node, "prio", 0), cpu_affinity(), "rk:devevents"),
+    bus(bus)
+{
+    if (node["affinity"])
+        set_affinity(cpu_affinity(node["affinity"]));
+
+    start();
+}
+
+//! worker destruction
+device_event_bus::worker::~worker() {
+    {
+        std::unique_lock<std::mutex> lock(bus.mtx);
+        run_flag = false;
+        bus.cond.notify_all();
+    }
+
+    join();
+}
+
+//! handler function called if thread is running
+void device_event_bus::worker::run() {
+    std::unique_lock<std::mutex> lock(bus.mtx);
+
+    while (running()) {
+        if (bus.queue.empty()) {
+            bus.cond.wait(lock);
+            continue;
+        }
+
+        bus.process(lock);
+    }
+}
+
+//! construction, events are delivered synchronously until started
+device_event_bus::device_event_bus() :
+    posted(0), delivered(0)
+{}
+
+//! destruction
+device_event_bus::~device_event_bus() {
+    stop();
+}
+
+//! start delivery thread
+/*!
+ * \param[in] node  Thread configuration, may contain prio and 
+ *                  affinity.
+ */
+void device_event_bus::start(const YAML::Node& node) {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (!thread)
+        thread.reset(new worker(*this, node));
+}
+
+//! deliver queued events and stop delivery thread
+void device_event_bus::stop() {
+    std::unique_ptr<worker> w;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        w.swap(thread);
+    }
+    w.reset();
+
+    dispatch();
+}
+
+//! return device_type_t bits of device
+uint32_t device_event_bus::get_types(const sp_device_t& dev) {
+    uint32_t types = 0;
+
+    if (std::dynamic_pointer_cast<process_data>(dev))
+        types |= device_type_process_data;
+    if (std::dynamic_pointer_cast<trigger>(dev))
+        types |= device_type_trigger;
+    if (std::dynamic_pointer_cast<stream>(dev))
+        types |= device_type_stream;
+    if (std::dynamic_pointer_cast<service_interface>(dev))
+        types |= device_type_service_interface;
+
+    return types ? types : (uint32_t)device_type_other;
+}
+
+//! call listener with run of devices
+static void notify(const sp_device_listener_t& dl, bool add, 
+        const std::vector<sp_device_t>& devs) 
+{
+    try {
+        if (add)
+            dl->notify_add_devices(devs);
+        else
+            dl->notify_remove_devices(devs);
+    } catch (const exception& e) {
+        RK_LOG(kernel::instance, error, "device listener %s.%s threw exception: %s\n",
+                dl->owner.c_str(), dl->name.c_str(), e.what());
+    }
+}
+
+//! deliver batch of events, delivery_mtx has to be held
+/*!
+ * \param[in] batch     Events in posting order.
+ * \param[in] ls        Listeners to notify.
+ */
+void device_event_bus::deliver(const events_t& batch, 
+        const std::vector<listener>& ls) 
+{
+    std::vector<sp_device_t> run;
+
+    for (const auto& l : ls) {
+        const auto& dl = l.dl;
+        bool run_add = true;
+        run.clear();
+
+        // consecutive events of same kind are delivered as one call,
+        // events posted before dl was added are covered by its own events
+        for (const auto& ev : batch) {
+            if ((ev.target ? (ev.target != dl) : (ev.seq < l.since)) || 
+                    !(ev.types & dl->device_types))
+                continue;
+
+            if (!run.empty() && (run_add != ev.add)) {
+                notify(dl, run_add, run);
+                run.clear();
+            }
+
+            run_add = ev.add;
+            run.push_back(ev.dev);
+        }
+
+        if (!run.empty())
+            notify(dl, run_add, run);
+    }
+}
+
+//! deliver queued events until queue is empty
+/*!
+ * \param[in] lock  Locked mtx, unlocked while calling listeners.
+ */
+void device_event_bus::process(std::unique_lock<std::mutex>& lock) {
+    while (!queue.empty()) {
+        // take delivery_mtx first, so batches are delivered in order
+        lock.unlock();
+        std::unique_lock<std::mutex> delivery_lock(delivery_mtx);
+        lock.lock();
+
+        if (queue.empty())
+            break;
+
+        events_t batch;
+        batch.swap(queue);
+
+        std::vector<listener> ls;
+        ls.reserve(listeners.size());
+        for (const auto& kv : listeners)
+            ls.push_back(kv.second);
+
+        lock.unlock();
+
+        _in_delivery = true;
+        deliver(batch, ls);
+        _in_delivery = false;
+
+        delivery_lock.unlock();
+        lock.lock();
+
+        delivered += batch.size();
+        cond.notify_all();
+    }
+}
+
+//! queue event
+void device_event_bus::post(event&& ev) {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    ev.seq = posted++;
+    queue.push_back(std::move(ev));
+
+    if (thread)
+        cond.notify_all();
+}
+
+//! add a listener
+/*!
+ * \param[in] dl    Listener to add.
+ * \param[in] devs  Currently registered devices, add events for
+ *                  dl only are queued for them.
+ * \return false if a listener with same owner and name exists
+ */
+bool device_event_bus::add_listener(sp_device_listener_t dl, 
+        const std::list<sp_device_t>& devs) 
+{
+    std::unique_lock<std::mutex> lock(mtx);
+
+    listener l = { dl, posted };
+    auto ret = listeners.insert(make_pair(make_pair(dl->owner, dl->name), l));
+    if (!ret.second)
+        return false;
+
+    for (const auto& dev : devs) {
+        event ev = { posted, true, dev, get_types(dev), dl };
+        if (ev.types & dl->device_types) {
+            queue.push_back(std::move(ev));
+            posted++;
+        }
+    }
+
+    if (thread)
+        cond.notify_all();
+
+    return true;
+}
+
+//! remove a listener
+/*!
+ * Waits for running deliveries and notifies dl synchronously
+ * about the removal of all currently registered devices.
+ *
+ * \param[in] dl    Listener to remove.
+ * \param[in] devs  Currently registered devices.
+ * \return false if listener was not registered
+ */
+bool device_event_bus::remove_listener(sp_device_listener_t dl, 
+        const std::list<sp_device_t>& devs) 
+{
+    // deliver pending events first, dl may still expect some of them
+    flush();
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        auto it = listeners.find(make_pair(dl->owner, dl->name));
+        if (it == listeners.end())
+            return false;
+
+        listeners.erase(it);
+    }
+
+    std::vector<sp_device_t> run;
+    for (const auto& dev : devs)
+        if (get_types(dev) & dl->device_types)
+            run.push_back(dev);
+
+    // running batch may still contain dl, wait for it
+    std::unique_lock<std::mutex> delivery_lock(delivery_mtx, std::defer_lock);
+    if (!_in_delivery)
+        delivery_lock.lock();
+
+    bool in_delivery = _in_delivery;
+    _in_delivery = true;
+    if (!run.empty())
+        notify(dl, false, run);
+    _in_delivery = in_delivery;
+
+    return true;
+}
+
+//! queue device add event
+/*!
+ * \param[in] dev   Added device.
+ */
+void device_event_bus::post_add(const sp_device_t& dev) {
+    event ev = { 0, true, dev, get_types(dev), nullptr };
+    post(std::move(ev));
+}
+
+//! queue device remove event
+/*!
+ * \param[in] dev   Removed device.
+ */
+void device_event_bus::post_remove(const sp_device_t& dev) {
+    event ev = { 0, false, dev, get_types(dev), nullptr };
+    post(std::move(ev));
+}
+
+//! deliver queued events in calling thread
+/*!
+ * Does nothing if the delivery thread is running or when called
+ * from within a listener.
+ */
+void device_event_bus::dispatch() {
+    if (_in_delivery)
+        return;
+
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (!thread)
+        process(lock);
+}
+
+//! call function while no listener is notified
+/*!
+ * \param[in] fn    Function to call, e.g. to modify listener state
+ *                  from outside of a notification.
+ */
+void device_event_bus::run_exclusive(const std::function<void()>& fn) {
+    std::unique_lock<std::mutex> delivery_lock(delivery_mtx, std::defer_lock);
+    if (!_in_delivery)
+        delivery_lock.lock();
+
+    fn();
+}
+
+//! wait until all events posted so far are delivered
+/*!
+ * Returns immediately when called from within a listener.
+ */
+void device_event_bus::flush() {
+    if (_in_delivery)
+        return;
+
+    std::unique_lock<std::mutex> lock(mtx);
+    uint64_t target = posted;
+
+    while (delivered < target) {
+        if (!thread && !queue.empty()) {
+            process(lock);
+            continue;
+        }
+
+        cond.wait(lock);
+    }
+}
+
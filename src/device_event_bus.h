@@ -0,0 +1,203 @@
+//! robotkernel device event bus
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__DEVICE_EVENT_BUS_H
+#define ROBOTKERNEL__DEVICE_EVENT_BUS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// public headers
+#include "robotkernel/runnable.h"
+#include "robotkernel/device.h"
+#include "robotkernel/device_listener.h"
+
+#include "yaml-cpp/yaml.h"
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! device event bus
+/*!
+ * Delivers device add and remove events to the registered device 
+ * listeners. Events are queued and delivered in batches on a dedicated
+ * thread, every listener only gets the device types it subscribed to.
+ * Without a running thread queued events are delivered by the thread 
+ * calling dispatch.
+ *
+ * Listeners are never called concurrently. After remove_listener
+ * returned, the listener will not be called anymore.
+ */
+class device_event_bus {
+    private:
+        device_event_bus(const device_event_bus&);             // prevent copy-construction
+        device_event_bus& operator=(const device_event_bus&);  // prevent assignment
+
+        class worker : public runnable {
+            public:
+                worker(device_event_bus& bus, const YAML::Node& node);
+                ~worker();
+
+                //! handler function called if thread is running
+                void run();
+
+            private:
+                device_event_bus& bus;
+        };
+
+        struct event {
+            uint64_t seq;                       //!< posting sequence number
+            bool add;                           //!< add or remove event
+            sp_device_t dev;                    //!< added or removed device
+            uint32_t types;                     //!< device_type_t bits of dev
+            sp_device_listener_t target;        //!< only notify target, all if NULL
+        };
+
+        typedef std::vector<event> events_t;
+
+        struct listener {
+            sp_device_listener_t dl;
+            uint64_t since;                     //!< first event sequence number for dl
+        };
+
+        typedef std::map<std::pair<std::string, std::string>, listener> listeners_t;
+
+        std::mutex mtx;                         //!< protects members below
+        std::condition_variable cond;           //!< signals queued and delivered events
+        events_t queue;                         //!< queued events
+        uint64_t posted;                        //!< number of posted events
+        uint64_t delivered;                     //!< number of delivered events
+        listeners_t listeners;                  //!< registered listeners
+        std::unique_ptr<worker> thread;         //!< delivery thread, NULL if synchronous
+
+        std::mutex delivery_mtx;                //!< held while calling listeners
+        
+        //! queue event
+        void post(event&& ev);
+
+        //! deliver queued events until queue is empty
+        /*!
+         * \param[in] lock  Locked mtx, unlocked while calling listeners.
+         */
+        void process(std::unique_lock<std::mutex>& lock);
+
+        //! deliver batch of events, delivery_mtx has to be held
+        /*!
+         * \param[in] batch     Events in posting order.
+         * \param[in] ls        Listeners to notify.
+         */
+        static void deliver(const events_t& batch, 
+                const std::vector<listener>& ls);
+
+    public:
+        //! construction, events are delivered synchronously until started
+        device_event_bus();
+
+        //! destruction
+        ~device_event_bus();
+
+        //! start delivery thread
+        /*!
+         * \param[in] node  Thread configuration, may contain prio and 
+         *                  affinity.
+         */
+        void start(const YAML::Node& node);
+
+        //! deliver queued events and stop delivery thread
+        void stop();
+
+        //! return device_type_t bits of device
+        static uint32_t get_types(const sp_device_t& dev);
+
+        //! add a listener
+        /*!
+         * \param[in] dl    Listener to add.
+         * \param[in] devs  Currently registered devices, add events for
+         *                  dl only are queued for them.
+         * \return false if a listener with same owner and name exists
+         */
+        bool add_listener(sp_device_listener_t dl, const std::list<sp_device_t>& devs);
+
+        //! remove a listener
+        /*!
+         * Waits for running deliveries and notifies dl synchronously
+         * about the removal of all currently registered devices.
+         *
+         * \param[in] dl    Listener to remove.
+         * \param[in] devs  Currently registered devices.
+         * \return false if listener was not registered
+         */
+        bool remove_listener(sp_device_listener_t dl, const std::list<sp_device_t>& devs);
+
+        //! queue device add event
+        /*!
+         * \param[in] dev   Added device.
+         */
+        void post_add(const sp_device_t& dev);
+
+        //! queue device remove event
+        /*!
+         * \param[in] dev   Removed device.
+         */
+        void post_remove(const sp_device_t& dev);
+
+        //! deliver queued events in calling thread
+        /*!
+         * Does nothing if the delivery thread is running or when called
+         * from within a listener.
+         */
+        void dispatch();
+
+        //! call function while no listener is notified
+        /*!
+         * \param[in] fn    Function to call, e.g. to modify listener state
+         *                  from outside of a notification.
+         */
+        void run_exclusive(const std::function<void()>& fn);
+
+        //! wait until all events posted so far are delivered
+        /*!
+         * Returns immediately when called from within a listener.
+         */
+        void flush();
+};
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__DEVICE_EVENT_BUS_H
+
@@ -0,0 +1,230 @@
+//! robotkernel device registry
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// private headers
+#include "device_registry.h"
+
+using namespace std;
+using namespace robotkernel;
+
+static const size_t npos = (size_t)-1;
+
+//! intern device id, lock has to be held exclusively
+device_handle_t device_registry::intern(const std::string& id) {
+    auto it = handles.find(id);
+    if (it != handles.end())
+        return it->second;
+
+    device_handle_t handle = by_handle.size();
+    handles[id] = handle;
+    by_handle.push_back(nullptr);
+
+    return handle;
+}
+
+//! remove entry, lock has to be held exclusively
+void device_registry::erase(entries_t::iterator it) {
+    entry& e = it->second;
+
+    if (e.pd_pos != npos)
+        pds.remove(e.pd_pos, &entry::pd_pos);
+    if (e.trigger_pos != npos)
+        triggers.remove(e.trigger_pos, &entry::trigger_pos);
+    if (e.stream_pos != npos)
+        streams.remove(e.stream_pos, &entry::stream_pos);
+
+    by_handle[e.handle] = nullptr;
+    by_id.erase(it);
+}
+
+//! add a device
+/*!
+ * \param[in] dev   Device to add.
+ * \return false if a device with the same id is already registered
+ */
+bool device_registry::add(const sp_device_t& dev) {
+    const auto& pd  = std::dynamic_pointer_cast<process_data>(dev);
+    const auto& trg = std::dynamic_pointer_cast<trigger>(dev);
+    const auto& str = std::dynamic_pointer_cast<stream>(dev);
+
+    rwlock::write_guard guard(lock);
+
+    auto ret = by_id.insert(make_pair(dev->id(), entry()));
+    if (!ret.second)
+        return false;
+
+    entry& e = ret.first->second;
+    e.dev           = dev;
+    e.handle        = intern(dev->id());
+    e.pd_pos        = pd  ? pds.add(pd, &e) : npos;
+    e.trigger_pos   = trg ? triggers.add(trg, &e) : npos;
+    e.stream_pos    = str ? streams.add(str, &e) : npos;
+
+    by_handle[e.handle] = &e;
+
+    return true;
+}
+
+//! remove a device
+/*!
+ * \param[in] id    Device id.
+ * \return removed device or nullptr if not found
+ */
+sp_device_t device_registry::remove(const std::string& id) {
+    rwlock::write_guard guard(lock);
+
+    auto it = by_id.find(id);
+    if (it == by_id.end())
+        return nullptr;
+
+    sp_device_t dev = it->second.dev;
+    erase(it);
+
+    return dev;
+}
+
+//! remove all devices of owner
+/*!
+ * \param[in] owner Device owner.
+ * \return removed devices
+ */
+std::list<sp_device_t> device_registry::remove_owner(const std::string& owner) {
+    std::list<sp_device_t> removed;
+    string prefix = owner + ".";
+
+    rwlock::write_guard guard(lock);
+
+    // ids start with owner, so all devices of owner are one range
+    auto it = by_id.lower_bound(prefix);
+    while ((it != by_id.end()) && (it->first.compare(0, prefix.size(), prefix) == 0)) {
+        if (it->second.dev->owner != owner) {
+            ++it;
+            continue;
+        }
+
+        removed.push_back(it->second.dev);
+        erase(it++);
+    }
+
+    return removed;
+}
+
+//! find a device by id
+/*!
+ * \param[in] id    Device id.
+ * \return device or nullptr if not found
+ */
+sp_device_t device_registry::find(const std::string& id) const {
+    rwlock::read_guard guard(lock);
+
+    auto it = by_id.find(id);
+    if (it == by_id.end())
+        return nullptr;
+
+    return it->second.dev;
+}
+
+//! find a device by handle
+/*!
+ * \param[in] handle    Device handle from get_handle.
+ * \return device or nullptr if currently not registered
+ */
+sp_device_t device_registry::find(device_handle_t handle) const {
+    rwlock::read_guard guard(lock);
+
+    if ((handle >= by_handle.size()) || !by_handle[handle])
+        return nullptr;
+
+    return by_handle[handle]->dev;
+}
+
+//! get handle of device id
+/*!
+ * The id does not have to be registered yet.
+ *
+ * \param[in] id    Device id.
+ * \return interned device handle
+ */
+device_handle_t device_registry::get_handle(const std::string& id) {
+    {
+        rwlock::read_guard guard(lock);
+
+        auto it = handles.find(id);
+        if (it != handles.end())
+            return it->second;
+    }
+
+    rwlock::write_guard guard(lock);
+    return intern(id);
+}
+
+//! get ids of all devices in sorted order
+/*!
+ * \param[out] ids  Device ids.
+ */
+void device_registry::get_ids(std::vector<std::string>& ids) const {
+    rwlock::read_guard guard(lock);
+
+    ids.reserve(ids.size() + by_id.size());
+    for (const auto& kv : by_id)
+        ids.push_back(kv.first);
+}
+
+//! get all devices in id order
+std::list<sp_device_t> device_registry::get_all() const {
+    std::list<sp_device_t> devs;
+    rwlock::read_guard guard(lock);
+
+    for (const auto& kv : by_id)
+        devs.push_back(kv.second.dev);
+
+    return devs;
+}
+
+//! get all process data devices from index
+void device_registry::get(std::list<sp_process_data_t>& devs) const {
+    rwlock::read_guard guard(lock);
+    devs.insert(devs.end(), pds.devs.begin(), pds.devs.end());
+}
+
+//! get all trigger devices from index
+void device_registry::get(std::list<sp_trigger_t>& devs) const {
+    rwlock::read_guard guard(lock);
+    devs.insert(devs.end(), triggers.devs.begin(), triggers.devs.end());
+}
+
+//! get all stream devices from index
+void device_registry::get(std::list<sp_stream_t>& devs) const {
+    rwlock::read_guard guard(lock);
+    devs.insert(devs.end(), streams.devs.begin(), streams.devs.end());
+}
+
+//! return number of registered devices
+size_t device_registry::size() const {
+    rwlock::read_guard guard(lock);
+    return by_id.size();
+}
+
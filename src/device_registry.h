@@ -0,0 +1,211 @@
+//! robotkernel device registry
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__DEVICE_REGISTRY_H
+#define ROBOTKERNEL__DEVICE_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <unordered_map>
+
+// public headers
+#include "robotkernel/device.h"
+#include "robotkernel/process_data.h"
+#include "robotkernel/trigger.h"
+#include "robotkernel/stream.h"
+
+// private headers
+#include "rwlock.h"
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! registry of all named devices
+/*!
+ * Devices are kept sorted by id. Process data, trigger and stream devices
+ * are additionally kept in per-type indexes so that typed queries do not 
+ * have to cast every registered device. 
+ *
+ * Every device id can be interned to an integer handle. A handle stays 
+ * valid for the lifetime of the registry, also if the device is removed 
+ * and added again, and resolves to the device with O(1).
+ *
+ * All members may be called concurrently, lookups only take a shared lock.
+ */
+class device_registry {
+    private:
+        device_registry(const device_registry&);             // prevent copy-construction
+        device_registry& operator=(const device_registry&);  // prevent assignment
+
+        struct entry {
+            sp_device_t dev;            //!< registered device
+            device_handle_t handle;     //!< interned id
+            size_t pd_pos;              //!< position in pds or npos
+            size_t trigger_pos;         //!< position in triggers or npos
+            size_t stream_pos;          //!< position in streams or npos
+        };
+
+        typedef std::map<std::string, entry> entries_t;
+
+        //! typed index with O(1) removal
+        template <typename T>
+        struct index {
+            std::vector<std::shared_ptr<T> > devs;
+            std::vector<entry *> entries;
+
+            //! append device, returns position
+            size_t add(const std::shared_ptr<T>& dev, entry *e) {
+                devs.push_back(dev);
+                entries.push_back(e);
+                return devs.size() - 1;
+            }
+
+            //! remove device at position, last device takes its place
+            void remove(size_t pos, size_t entry::*member) {
+                devs[pos] = devs.back();
+                entries[pos] = entries.back();
+                entries[pos]->*member = pos;
+                devs.pop_back();
+                entries.pop_back();
+            }
+        };
+
+        mutable rwlock lock;                                //!< protects all members below
+
+        entries_t by_id;                                    //!< registered devices by id
+        std::unordered_map<std::string, device_handle_t> handles;  //!< interned ids
+        std::vector<entry *> by_handle;                     //!< registered devices by handle
+
+        index<process_data> pds;                            //!< process data devices
+        index<trigger> triggers;                            //!< trigger devices
+        index<stream> streams;                              //!< stream devices
+
+        //! intern device id, lock has to be held exclusively
+        device_handle_t intern(const std::string& id);
+
+        //! remove entry, lock has to be held exclusively
+        void erase(entries_t::iterator it);
+
+    public:
+        //! construction
+        device_registry() {};
+
+        //! add a device
+        /*!
+         * \param[in] dev   Device to add.
+         * \return false if a device with the same id is already registered
+         */
+        bool add(const sp_device_t& dev);
+
+        //! remove a device
+        /*!
+         * \param[in] id    Device id.
+         * \return removed device or nullptr if not found
+         */
+        sp_device_t remove(const std::string& id);
+
+        //! remove all devices of owner
+        /*!
+         * \param[in] owner Device owner.
+         * \return removed devices
+         */
+        std::list<sp_device_t> remove_owner(const std::string& owner);
+
+        //! find a device by id
+        /*!
+         * \param[in] id    Device id.
+         * \return device or nullptr if not found
+         */
+        sp_device_t find(const std::string& id) const;
+
+        //! find a device by handle
+        /*!
+         * \param[in] handle    Device handle from get_handle.
+         * \return device or nullptr if currently not registered
+         */
+        sp_device_t find(device_handle_t handle) const;
+
+        //! get handle of device id
+        /*!
+         * The id does not have to be registered yet.
+         *
+         * \param[in] id    Device id.
+         * \return interned device handle
+         */
+        device_handle_t get_handle(const std::string& id);
+
+        //! get ids of all devices in sorted order
+        /*!
+         * \param[out] ids  Device ids.
+         */
+        void get_ids(std::vector<std::string>& ids) const;
+
+        //! get all devices in id order
+        std::list<sp_device_t> get_all() const;
+
+        //! get all devices of given type
+        /*!
+         * \param[out] devs List of devices.
+         */
+        template <typename T>
+        void get(std::list<std::shared_ptr<T> >& devs) const;
+
+        //! get all process data devices from index
+        void get(std::list<sp_process_data_t>& devs) const;
+
+        //! get all trigger devices from index
+        void get(std::list<sp_trigger_t>& devs) const;
+
+        //! get all stream devices from index
+        void get(std::list<sp_stream_t>& devs) const;
+
+        //! return number of registered devices
+        size_t size() const;
+};
+
+// get all devices of given type
+template <typename T>
+inline void device_registry::get(std::list<std::shared_ptr<T> >& devs) const {
+    rwlock::read_guard guard(lock);
+
+    for (const auto& kv : by_id) {
+        std::shared_ptr<T> dev = std::dynamic_pointer_cast<T>(kv.second.dev);
+        if (dev)
+            devs.push_back(dev);
+    }
+}
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__DEVICE_REGISTRY_H
+
@@ -27,68 +27,277 @@
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
-#include <sstream>
-
-#include <list>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
 
 // public headers
 #include "robotkernel/config.h"
+#include "robotkernel/kernel_clock.h"
 
 // private headers
-#include "char_ringbuffer.h"
 #include "dump_log.h"
 #if (HAVE_LTTNG_UST == 1)
 #include "lttng_tp.h"
 #endif
 
 using namespace std;
-using namespace robotkernel;
 
-static char_ringbuffer* _dump_log_buffer = NULL;
-static unsigned int _dump_log_len = 0;
-static unsigned int _do_ust = 0;
+//! per-thread dump ring
+/*!
+ * Single producer ring of variable-length records. The owning thread
+ * appends and overwrites the oldest records, the reader copies records
+ * between tail and head and discards records the writer has overwritten
+ * meanwhile. Rings are never freed while the process runs, a ring of an
+ * exited thread keeps its records until another thread claims it.
+ * Resizing frees the buffers of all rings not being written, readers 
+ * skip rings which were not adapted to the current size yet.
+ *
+ * Every record gets a global sequence number when it is written, readers
+ * use it to merge the rings and as page cursor. While writing, the ring 
+ * announces a lower bound of the number it is going to publish, so a 
+ * reader never hands out a cursor beyond an unpublished record.
+ */
+struct dump_ring {
+    //! record header, records are 8 byte aligned and never wrap
+    struct record {
+        uint64_t ts;                    //!< kernel_clock timestamp [ns]
+        uint64_t seq;                   //!< global sequence number
+        uint32_t size;                  //!< chunk size including header
+        uint32_t len;                   //!< message length, pad_len for padding
+    };
+
+    static const uint32_t pad_len = 0xFFFFFFFF;
+
+    dump_ring *next;                    //!< registry list, never changes once linked
+    std::atomic<bool> in_use;           //!< claimed by a thread
+
+    char *buf;
+    uint64_t size;                      //!< power of two
+    std::atomic<unsigned int> generation;   //!< size generation of buf
+
+    std::atomic<uint64_t> head;         //!< end of newest record
+    std::atomic<uint64_t> tail;         //!< start of oldest record
+    std::atomic<uint64_t> writing;      //!< lower bound of unpublished seq, 0 if idle
+
+    dump_ring() : next(NULL), in_use(true), buf(NULL), size(0), 
+        generation(0), head(0), tail(0), writing(0) {}
+};
+
+static std::atomic<dump_ring *> _rings(NULL);          //!< all rings
+static std::mutex _reader_mtx;                          //!< serializes readers and resizing
+static std::atomic<unsigned int> _dump_log_len(0);      //!< ring size per thread
+static std::atomic<unsigned int> _generation(0);        //!< changed on every resize
+static std::atomic<unsigned int> _do_ust(0);
+static std::atomic<uint64_t> _seq(0);                   //!< last taken sequence number
+static uint64_t _consumed = 0;                          //!< cursor of dump_log_dump
+
+//! releases ring when owning thread exits
+struct ring_owner {
+    dump_ring *ring;
+
+    ring_owner() : ring(NULL) {}
+    ~ring_owner() {
+        if (ring)
+            ring->in_use.store(false, std::memory_order_release);
+    }
+};
+
+static thread_local ring_owner _owner;
+
+//! claim unused ring or create new one
+static dump_ring *claim_ring() {
+    for (dump_ring *r = _rings.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return r;
+    }
+
+    dump_ring *r = new dump_ring();
+    r->next = _rings.load(std::memory_order_relaxed);
+    while (!_rings.compare_exchange_weak(r->next, r, std::memory_order_release));
+
+    return r;
+}
+
+//! adapt ring to current size, called by owner only
+static void resize_ring(dump_ring *r) {
+    std::unique_lock<std::mutex> lock(_reader_mtx);
 
-static double ts2double(struct timespec* ts) {
-    return (double)ts->tv_sec + (ts->tv_nsec / 1e9);
+    unsigned int len = _dump_log_len.load(std::memory_order_relaxed);
+    uint64_t size = 0;
+
+    if (len) {
+        // at least one maximum sized message has to fit
+        size = 2048;
+        while (size < len)
+            size <<= 1;
+    }
+
+    if (size != r->size) {
+        delete [] r->buf;
+        r->buf  = size ? new char[size] : NULL;
+        r->size = size;
+    }
+
+    r->head.store(0, std::memory_order_relaxed);
+    r->tail.store(0, std::memory_order_relaxed);
+    r->generation.store(_generation.load(std::memory_order_relaxed), std::memory_order_relaxed);
 }
 
-static double get_time() {
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    return ts2double(&ts);
+//! append message to ring of calling thread
+static void ring_write(const char *msg, size_t len) {
+    dump_ring *r = _owner.ring;
+    if (!r)
+        r = _owner.ring = claim_ring();
+
+    // announce before taking seq, readers stop in front of it. Also 
+    // announced before checking the size, resizing does not free the 
+    // buffer of a ring which is written
+    r->writing.store(_seq.load(std::memory_order_relaxed) + 1);
+
+    if ((r->generation.load(std::memory_order_relaxed) != _generation.load()) || !r->buf)
+        resize_ring(r);
+    if (!r->buf) {
+        r->writing.store(0, std::memory_order_release);
+        return;
+    }
+
+    uint64_t seq = _seq.fetch_add(1) + 1;
+    uint64_t now = robotkernel::kernel_clock::now_ns();
+
+    uint64_t mask = r->size - 1;
+    uint64_t need = (sizeof(dump_ring::record) + len + 7) & ~7ull;
+    uint64_t h = r->head.load(std::memory_order_relaxed);
+    uint64_t t = r->tail.load(std::memory_order_relaxed);
+    uint64_t off = h & mask;
+    uint64_t pad = (r->size - off < need) ? r->size - off : 0;
+
+    // release overwritten records before touching their bytes
+    while (h + pad + need - t > r->size) {
+        dump_ring::record *old = (dump_ring::record *)&r->buf[t & mask];
+        t += old->size;
+    }
+    r->tail.store(t, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (pad) {
+        dump_ring::record *p = (dump_ring::record *)&r->buf[off];
+        p->ts   = 0;
+        p->seq  = 0;
+        p->size = pad;
+        p->len  = dump_ring::pad_len;
+        off = 0;
+    }
+
+    dump_ring::record *rec = (dump_ring::record *)&r->buf[off];
+    rec->ts   = now;
+    rec->seq  = seq;
+    rec->size = need;
+    rec->len  = len;
+    memcpy(&r->buf[off + sizeof(dump_ring::record)], msg, len);
+
+    r->head.store(h + pad + need, std::memory_order_release);
+    r->writing.store(0, std::memory_order_release);
 }
 
-void format_time(char* ts_buffer, int ts_buffer_len) {
-    double timestamp = get_time();
-    time_t seconds = (time_t)timestamp;
-    double mseconds = (timestamp - (double)seconds) * 1e6;
+//! dump log entry copied by reader
+struct dump_entry {
+    uint64_t ts;
+    uint64_t seq;
+    std::string msg;
+
+    bool operator<(const dump_entry& other) const { return seq < other.seq; }
+};
+
+//! copy records in (cursor, horizon] from ring, reader mutex has to be locked
+static void ring_read(dump_ring *r, uint64_t cursor, uint64_t horizon, 
+        vector<dump_entry>& entries) {
+    // records from before the last resize
+    if (!r->buf || (r->generation.load(std::memory_order_relaxed) != 
+                _generation.load(std::memory_order_relaxed)))
+        return;
+
+    uint64_t mask = r->size - 1;
+    uint64_t h = r->head.load(std::memory_order_acquire);
+    uint64_t pos = r->tail.load(std::memory_order_acquire);
+
+    while (pos < h) {
+        dump_ring::record rec = *(dump_ring::record *)&r->buf[pos & mask];
+        dump_entry e;
+        bool take = (rec.len != dump_ring::pad_len) && 
+            (rec.seq > cursor) && (rec.seq <= horizon);
+
+        if (take) {
+            e.ts  = rec.ts;
+            e.seq = rec.seq;
+            e.msg.assign(&r->buf[(pos & mask) + sizeof(rec)], 
+                    std::min((uint64_t)rec.len, r->size - (pos & mask) - sizeof(rec)));
+        }
+
+        // record overwritten while copying, restart at oldest record
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t t = r->tail.load(std::memory_order_relaxed);
+        if (t > pos) {
+            pos = t;
+            continue;
+        }
+
+        if (rec.size == 0)
+            break;  // cannot happen with consistent rings
+
+        if (take)
+            entries.push_back(std::move(e));
+
+        pos += rec.size;
+    }
+}
+
+static void format_time(uint64_t ts, char* ts_buffer, int ts_buffer_len) {
+    time_t seconds = ts / 1000000000ull;
     struct tm btime;
     localtime_r(&seconds, &btime);
     strftime(ts_buffer, ts_buffer_len, "%Y-%m-%d %H:%M:%S", &btime);
     int sl = strlen(ts_buffer);
-    snprintf(ts_buffer + sl, ts_buffer_len - sl, ".%06.0f", mseconds);
+    snprintf(ts_buffer + sl, ts_buffer_len - sl, ".%06u", 
+            (unsigned)((ts % 1000000000ull) / 1000));
 }
 
 void dump_log_free() {
-    if (_dump_log_buffer)
-        delete _dump_log_buffer;
+    // rings stay registered, buffers of rings not being written are freed
+    dump_log_set_len(0, 0);
 }
 
 void dump_log_set_len(unsigned int len, unsigned int do_ust) {
-    _dump_log_len = len;
-    _do_ust = do_ust;
-
-    if(_dump_log_len > 0) {
-        if(!_dump_log_buffer) {
-            printf("allocating %d bytes\n", _dump_log_len);
-            _dump_log_buffer = new char_ringbuffer(_dump_log_len);
-        } else
-            _dump_log_buffer->set_size(_dump_log_len);
+    std::unique_lock<std::mutex> lock(_reader_mtx);
+
+    _dump_log_len.store(len, std::memory_order_relaxed);
+    _do_ust.store(do_ust, std::memory_order_relaxed);
+    _generation.fetch_add(1);
+    _consumed = 0;
+
+    // a writer announcing later sees the new generation and resizes its
+    // ring itself, the others are written right now and stay stale
+    for (dump_ring *r = _rings.load(std::memory_order_acquire); r; r = r->next) {
+        if (r->writing.load() || !r->buf)
+            continue;
+
+        delete [] r->buf;
+        r->buf  = NULL;
+        r->size = 0;
+        r->head.store(0, std::memory_order_relaxed);
+        r->tail.store(0, std::memory_order_relaxed);
     }
 }
 
+bool dump_log_active() {
+    return _dump_log_len.load(std::memory_order_relaxed) || 
+        _do_ust.load(std::memory_order_relaxed);
+}
+
 void dump_log(const char* format, ...) {
-    if(!_dump_log_len)
+    if (!dump_log_active())
         return;
 
     va_list ap;
@@ -98,14 +307,19 @@ void dump_log(const char* format, ...) {
 }
 
 void vdump_log(const char* format, va_list nap) {
-    if(!_dump_log_len && !_do_ust)
+    if (!dump_log_active())
         return;
 
     char msg[1024];
     va_list ap;
     va_copy(ap, nap);
-    vsnprintf(msg, 1024, format, ap);
+    int n = vsnprintf(msg, 1024, format, ap);
     va_end(ap);
+
+    if (n < 0)
+        return;
+    if (n > 1023)
+        n = 1023;
     
 #if (HAVE_LTTNG_UST == 1)
     if(_do_ust) {
@@ -113,17 +327,84 @@ void vdump_log(const char* format, va_list nap) {
     }
 #endif
     
-    if(_dump_log_len && _dump_log_buffer) {
+    if (_dump_log_len.load(std::memory_order_relaxed))
+        ring_write(msg, n);
+}
+
+//! read page of merged dump log
+/*!
+ * Records of all threads are merged by sequence number. Records which
+ * are still written by other threads are returned with a later page.
+ *
+ * \param[in]   cursor      Return records after cursor, 0 for all.
+ * \param[in]   max_len     Maximum page length in bytes, 0 for unlimited.
+ *                          At least one record is returned.
+ * \param[out]  next_cursor Cursor to request next page.
+ * \param[out]  more        Records after next_cursor are available.
+ * \return formatted records
+ */
+std::string dump_log_read(uint64_t cursor, size_t max_len, 
+        uint64_t& next_cursor, bool& more) {
+    vector<dump_entry> entries;
+    uint64_t last, horizon;
+
+    {
+        std::unique_lock<std::mutex> lock(_reader_mtx);
+
+        // all records up to horizon are published, a writer announces 
+        // its record before it takes the sequence number
+        last = horizon = _seq.load();
+        for (dump_ring *r = _rings.load(std::memory_order_acquire); r; r = r->next) {
+            uint64_t w = r->writing.load();
+            if (w && (w - 1 < horizon))
+                horizon = w - 1;
+        }
+
+        for (dump_ring *r = _rings.load(std::memory_order_acquire); r; r = r->next)
+            ring_read(r, cursor, horizon, entries);
+    }
+
+    std::sort(entries.begin(), entries.end());
+
+    string out;
+    size_t i = 0;
+    next_cursor = cursor;
+
+    for (; i < entries.size(); ++i) {
+        const dump_entry& e = entries[i];
+
+        if (max_len && (i > 0) && (out.size() + e.msg.size() + 28 > max_len))
+            break;
+
         char ts_buffer[64];
-        format_time(ts_buffer, 64);
-                _dump_log_buffer->write(string(ts_buffer) + " " + string(msg));
+        format_time(robotkernel::kernel_clock::to_wall_ns(e.ts), ts_buffer, sizeof(ts_buffer));
+        out += ts_buffer;
+        out += " ";
+        out += e.msg;
+
+        next_cursor = e.seq;
     }
+
+    more = (i < entries.size()) || (horizon < last);
+    return out;
 }
 
 std::string dump_log_dump(bool keep) {
-    if(!_dump_log_buffer)
-        return string();
+    uint64_t cursor;
 
-    return _dump_log_buffer->get(keep);
-}
+    {
+        std::unique_lock<std::mutex> lock(_reader_mtx);
+        cursor = _consumed;
+    }
 
+    uint64_t next_cursor;
+    bool more;
+    string out = dump_log_read(cursor, 0, next_cursor, more);
+
+    if (!keep) {
+        std::unique_lock<std::mutex> lock(_reader_mtx);
+        _consumed = next_cursor;
+    }
+
+    return out;
+}
@@ -29,12 +29,25 @@
 
 #include <string>
 #include <stdarg.h>
+#include <stdint.h>
 
 void dump_log_free();
 void dump_log_set_len(unsigned int len, unsigned int do_ust);
+bool dump_log_active();
 void dump_log(const char* format, ...);
 void vdump_log(const char* format, va_list nap);
 std::string dump_log_dump(bool keep=false);
 
+//! read page of merged dump log
+/*!
+ * \param[in]   cursor      Return records after cursor, 0 for all.
+ * \param[in]   max_len     Maximum page length in bytes, 0 for unlimited.
+ * \param[out]  next_cursor Cursor to request next page.
+ * \param[out]  more        Records after next_cursor are available.
+ * \return formatted records
+ */
+std::string dump_log_read(uint64_t cursor, size_t max_len, 
+        uint64_t& next_cursor, bool& more);
+
 #endif // DUMP_LOG_H
 
@@ -0,0 +1,337 @@
+//! robotkernel fd reactor
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/fd_reactor.h"
+#include "robotkernel/helpers.h"
+
+// private headers
+#include "kernel.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <vector>
+
+using namespace std;
+using namespace robotkernel;
+
+//! entry destruction, closes owned descriptor
+fd_reactor::entry::~entry() {
+    close(fd);
+}
+
+//! read and discard pending data of non-blocking descriptor
+/*!
+ * \param[in] fd        Non-blocking file descriptor.
+ * \return false on end of file or read error
+ */
+static bool drain(int fd) {
+    uint8_t buf[256];
+    ssize_t ret;
+
+    while ((ret = ::read(fd, buf, sizeof(buf))) > 0) {}
+
+    if (ret == 0)
+        return false;
+
+    return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+}
+
+//! construction with yaml node
+/*!
+ * \param[in] node  YAML node which may contain name, prio, affinity,
+ *                  thread_name and max_events.
+ */
+fd_reactor::fd_reactor(const YAML::Node& node) : 
+    runnable(node), name(get_as<string>(node, "name"))
+{
+    max_events = get_as<int>(node, "max_events", 64);
+
+    if (thread_name == "runnable")
+        thread_name = string_printf("rk:reactor.%s", name.c_str());
+
+    init();
+}
+
+//! construction
+/*!
+ * \param[in] name          Reactor name.
+ * \param[in] prio          Reactor thread priority.
+ * \param[in] affinity      Reactor thread cpu affinity.
+ * \param[in] max_events    Max events handled per wakeup.
+ */
+fd_reactor::fd_reactor(const std::string& name, int prio, 
+        const cpu_affinity& affinity, int max_events) :
+    runnable(prio, affinity, string_printf("rk:reactor.%s", name.c_str())),
+    max_events(max_events), name(name)
+{
+    init();
+}
+
+//! create epoll instance and wakeup descriptor
+void fd_reactor::init() {
+    if (max_events < 1)
+        throw runtime_error(string_printf("[fd_reactor] %s: max_events has to "
+                    "be at least 1!", name.c_str()));
+
+    if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1)
+        throw runtime_error(string_printf("[fd_reactor] %s: epoll_create1 failed: %s",
+                    name.c_str(), strerror(errno)));
+
+    if ((wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+        close(epoll_fd);
+        throw runtime_error(string_printf("[fd_reactor] %s: eventfd failed: %s",
+                    name.c_str(), strerror(errno)));
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events  = EPOLLIN;
+    ev.data.fd = wakeup_fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &ev) == -1) {
+        close(wakeup_fd);
+        close(epoll_fd);
+        throw runtime_error(string_printf("[fd_reactor] %s: cannot add wakeup fd: %s",
+                    name.c_str(), strerror(errno)));
+    }
+
+    start();
+}
+
+//! destruction
+fd_reactor::~fd_reactor() {
+    stop();
+
+    entries.clear();
+    close(wakeup_fd);
+    close(epoll_fd);
+}
+
+//! stop reactor thread
+void fd_reactor::stop() {
+    if (!running())
+        return;
+
+    run_flag = false;
+
+    uint64_t val = 1;
+    ssize_t local_ret = ::write(wakeup_fd, &val, sizeof(val));
+    (void)local_ret;
+
+    join();
+}
+
+//! add file descriptor
+/*!
+ * \param[in] fd        File descriptor, owned by the reactor afterwards.
+ * \param[in] trg       Trigger device fired on readiness, may be empty.
+ * \param[in] handler   Ready handler, if empty pending data is read
+ *                      and discarded (suitable for timerfds and
+ *                      eventfds used as pure wakeup sources). Such 
+ *                      descriptors are removed on eof or hangup.
+ * \param[in] events    Epoll events to wait for.
+ */
+void fd_reactor::add_fd(int fd, sp_trigger_t trg, handler_t handler, uint32_t events) {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (entries.find(fd) != entries.end())
+        throw runtime_error(string_printf("[fd_reactor] %s: fd %d already registered!",
+                    name.c_str(), fd));
+
+    sp_entry_t e = make_shared<entry>();
+    e->fd      = fd;
+    e->trg     = trg;
+    e->handler = handler;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events  = events;
+    ev.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        e->fd = -1;
+        throw runtime_error(string_printf("[fd_reactor] %s: cannot add fd %d: %s",
+                    name.c_str(), fd, strerror(errno)));
+    }
+
+    if (!handler)
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    entries[fd] = e;
+
+    kernel::instance.log(verbose, "[fd_reactor] %s: added fd %d, trigger %s\n", 
+            name.c_str(), fd, trg ? trg->id().c_str() : "none");
+}
+
+//! remove and close file descriptor
+/*!
+ * \param[in] fd        File descriptor to remove.
+ */
+void fd_reactor::remove_fd(int fd) {
+    sp_entry_t e;
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        auto it = entries.find(fd);
+        if (it == entries.end())
+            throw runtime_error(string_printf("[fd_reactor] %s: fd %d not registered!",
+                        name.c_str(), fd));
+
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+
+        // descriptor is closed with the last reference, the reactor thread
+        // may still hold the entry in its current batch
+        e = it->second;
+        entries.erase(it);
+    }
+
+    kernel::instance.log(verbose, "[fd_reactor] %s: removed fd %d\n", name.c_str(), fd);
+}
+
+//! remove descriptor which hung up, called from reactor thread
+/*!
+ * \param[in] e         Entry of descriptor, closed with last reference.
+ */
+void fd_reactor::remove_hung_up(const sp_entry_t& e) {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        // may have been removed or replaced concurrently
+        auto it = entries.find(e->fd);
+        if ((it == entries.end()) || (it->second != e))
+            return;
+
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, e->fd, NULL);
+        entries.erase(it);
+    }
+
+    RK_LOG(kernel::instance, warning, "[fd_reactor] %s: fd %d hung up, removed\n", 
+            name.c_str(), e->fd);
+}
+
+//! change epoll events of registered file descriptor
+/*!
+ * May be called from any thread, wakes the reactor if the 
+ * descriptor is ready for the new events.
+ *
+ * \param[in] fd        Registered file descriptor.
+ * \param[in] events    Epoll events to wait for.
+ */
+void fd_reactor::modify_fd(int fd, uint32_t events) {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (entries.find(fd) == entries.end())
+        throw runtime_error(string_printf("[fd_reactor] %s: fd %d not registered!",
+                    name.c_str(), fd));
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events  = events;
+    ev.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) == -1)
+        throw runtime_error(string_printf("[fd_reactor] %s: cannot modify fd %d: %s",
+                    name.c_str(), fd, strerror(errno)));
+}
+
+//! handler function called if thread is running
+void fd_reactor::run() {
+    vector<struct epoll_event> events(max_events);
+    vector<pair<sp_entry_t, uint32_t> > batch;
+    vector<trigger *> fired;
+
+    batch.reserve(max_events);
+    fired.reserve(max_events);
+
+    while (running()) {
+        int n = epoll_wait(epoll_fd, &events[0], max_events, -1);
+
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+
+            RK_LOG(kernel::instance, error, "[fd_reactor] %s: epoll_wait failed: %s\n",
+                    name.c_str(), strerror(errno));
+            break;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+
+            for (int i = 0; i < n; ++i) {
+                auto it = entries.find(events[i].data.fd);
+                if (it != entries.end())
+                    batch.push_back(make_pair(it->second, (uint32_t)events[i].events));
+            }
+        }
+
+        // consume all ready descriptors first, then fire each trigger once
+        for (const auto& b : batch) {
+            if (!b.first->handler) {
+                // a trigger-only descriptor at eof stays readable forever
+                if (!drain(b.first->fd) || (b.second & (EPOLLHUP | EPOLLERR)))
+                    remove_hung_up(b.first);
+
+                continue;
+            }
+
+            try {
+                b.first->handler(b.first->fd, b.second);
+            } catch (const exception& e) {
+                RK_LOG(kernel::instance, error, "[fd_reactor] %s: handler of fd %d "
+                        "threw exception: %s\n", name.c_str(), b.first->fd, e.what());
+            }
+        }
+
+        for (const auto& b : batch) {
+            trigger *trg = b.first->trg.get();
+            if (!trg)
+                continue;
+
+            bool already_fired = false;
+            for (const auto& f : fired) 
+                if (f == trg) {
+                    already_fired = true;
+                    break;
+                }
+
+            if (already_fired)
+                continue;
+
+            fired.push_back(trg);
+            trg->do_trigger();
+        }
+
+        fired.clear();
+        batch.clear();
+    }
+}
+
@@ -0,0 +1,244 @@
+//! robotkernel flight recorder
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/flight_recorder.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+using namespace robotkernel;
+
+static const char file_magic[8] = { 'R', 'K', 'F', 'L', 'I', 'G', 'H', 'T' };
+static const uint32_t ring_offset = 4096;
+
+//! construction
+/*!
+ * Creates or truncates the file and maps it.
+ *
+ * \param[in] path      File path.
+ * \param[in] size      Ring size in bytes, rounded up to a power of two.
+ */
+flight_recorder::flight_recorder(const std::string& path, size_t size) :
+    path(path)
+{
+    uint64_t ring_size = 4096;
+    while (ring_size < size)
+        ring_size <<= 1;
+
+    ring_mask = ring_size - 1;
+    map_size  = ring_offset + ring_size;
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw runtime_error(string("flight recorder: cannot open ") + 
+                path + ": " + strerror(errno));
+
+    if (ftruncate(fd, map_size) != 0) {
+        int err = errno;
+        close(fd);
+        throw runtime_error(string("flight recorder: cannot resize ") + 
+                path + ": " + strerror(err));
+    }
+
+    void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        throw runtime_error(string("flight recorder: cannot map ") + 
+                path + ": " + strerror(errno));
+
+    // touch all pages now, appending must not fault
+    memset(map, 0, map_size);
+
+    hdr  = (flight_recorder_header *)map;
+    ring = (char *)map + ring_offset;
+
+    hdr->version     = version;
+    hdr->header_size = ring_offset;
+    hdr->ring_size   = ring_size;
+    hdr->pid         = getpid();
+    hdr->write_pos.store(0, std::memory_order_relaxed);
+
+    // magic last, decoder only accepts complete headers
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(hdr->magic, file_magic, sizeof(hdr->magic));
+}
+
+//! destruction, the file is kept
+flight_recorder::~flight_recorder() {
+    munmap(hdr, map_size);
+}
+
+//! copy bytes into ring, wrapping around at the end
+void flight_recorder::copy_in(uint64_t pos, const void *src, size_t len) {
+    uint64_t off = pos & ring_mask;
+    size_t first = std::min((uint64_t)len, (ring_mask + 1) - off);
+
+    memcpy(&ring[off], src, first);
+    if (first < len)
+        memcpy(&ring[0], (const char *)src + first, len - first);
+}
+
+//! append record
+/*!
+ * \param[in] type      Record type.
+ * \param[in] level     Loglevel of log records.
+ * \param[in] ts        CLOCK_REALTIME timestamp [ns].
+ * \param[in] text      Payload.
+ * \param[in] len       Payload length.
+ */
+void flight_recorder::append(record_type type, int level, uint64_t ts,
+        const char *text, size_t len) {
+    flight_recorder_record rec;
+
+    len = std::min(len, (size_t)(ring_mask + 1) / 2);
+
+    rec.magic = 0;
+    rec.type  = type;
+    rec.level = level;
+    rec.len   = len;
+    rec.size  = (sizeof(rec) + len + 7) & ~7u;
+    rec.ts    = ts;
+    rec.pos   = hdr->write_pos.fetch_add(rec.size, std::memory_order_relaxed);
+
+    // records are 8 byte aligned, the magic never wraps
+    std::atomic<uint32_t> *magic = 
+        reinterpret_cast<std::atomic<uint32_t> *>(&ring[rec.pos & ring_mask]);
+    magic->store(0, std::memory_order_relaxed);
+
+    copy_in(rec.pos + sizeof(rec.magic), (const char *)&rec + sizeof(rec.magic), 
+            sizeof(rec) - sizeof(rec.magic));
+    copy_in(rec.pos + sizeof(rec), text, len);
+
+    magic->store(record_magic, std::memory_order_release);
+}
+
+//! decode flight recorder file
+/*!
+ * \param[in] path      File path.
+ * \param[in] out       Output stream for decoded records.
+ * \param[in] max_bytes Only decode the newest bytes of the ring,
+ *                      0 for the whole ring.
+ * \return number of decoded records
+ */
+size_t flight_recorder::decode(const std::string& path, std::ostream& out,
+        size_t max_bytes) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw runtime_error(string("flight recorder: cannot open ") + 
+                path + ": " + strerror(errno));
+
+    struct stat st;
+    void *map = MAP_FAILED;
+    if ((fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(flight_recorder_header)))
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        throw runtime_error(string("flight recorder: cannot map ") + path);
+
+    const flight_recorder_header *h = (const flight_recorder_header *)map;
+    if (    (memcmp(h->magic, file_magic, sizeof(file_magic)) != 0) || 
+            (h->version != version) || (h->ring_size & (h->ring_size - 1)) ||
+            ((uint64_t)st.st_size < h->header_size + h->ring_size)) {
+        munmap(map, st.st_size);
+        throw runtime_error(string("flight recorder: invalid file ") + path);
+    }
+
+    const char *r = (const char *)map + h->header_size;
+    uint64_t mask = h->ring_size - 1;
+    uint64_t wp = h->write_pos.load(std::memory_order_acquire);
+    uint64_t start = (wp > h->ring_size) ? wp - h->ring_size : 0;
+
+    if (max_bytes && (wp - start > max_bytes))
+        start = (wp - max_bytes + 7) & ~7ull;
+
+    auto copy_out = [&](uint64_t pos, void *dst, size_t len) {
+        uint64_t off = pos & mask;
+        size_t first = std::min((uint64_t)len, h->ring_size - off);
+        memcpy(dst, &r[off], first);
+        if (first < len)
+            memcpy((char *)dst + first, &r[0], len - first);
+    };
+
+    static const char *level_names[] = { "????", "ERR ", "WARN", "INFO", "VERB" };
+    vector<char> text;
+    size_t cnt = 0;
+    uint64_t p = start;
+
+    while (p + sizeof(flight_recorder_record) <= wp) {
+        flight_recorder_record rec;
+        copy_out(p, &rec, sizeof(rec));
+
+        // skip torn, incomplete or stale records
+        if (    (rec.magic != record_magic) || (rec.pos != p) || 
+                (rec.size < sizeof(rec)) || (rec.size > h->ring_size) ||
+                (rec.len > rec.size - sizeof(rec)) || (p + rec.size > wp)) {
+            p += 8;
+            continue;
+        }
+
+        text.resize(rec.len);
+        copy_out(p + sizeof(rec), text.data(), rec.len);
+
+        char ts_buf[64];
+        struct tm tm;
+        time_t sec = rec.ts / 1000000000ull;
+        localtime_r(&sec, &tm);
+        size_t n = strftime(ts_buf, sizeof(ts_buf), "%F %T", &tm);
+        snprintf(&ts_buf[n], sizeof(ts_buf) - n, ".%06u", 
+                (unsigned)((rec.ts % 1000000000ull) / 1000));
+
+        out << ts_buf << " ";
+        if (rec.type == type_log)
+            out << level_names[rec.level < 5 ? rec.level : 0] << " ";
+        else if (rec.type == type_trace)
+            out << "TRCE ";
+        else
+            out << "???? ";
+
+        out.write(text.data(), text.size());
+        if (text.empty() || (text.back() != '\n'))
+            out << "\n";
+
+        p += rec.size;
+        cnt++;
+    }
+
+    munmap(map, st.st_size);
+    return cnt;
+}
+
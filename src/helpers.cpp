@@ -36,6 +36,11 @@
 #include <taskLib.h>
 #endif
 
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
 #include <regex>
 #include <string>
 #include <cstdarg>
@@ -130,30 +135,148 @@ void robotkernel::set_priority(int priority, int policy) {
 
     param.sched_priority = priority;
     if (pthread_setschedparam(pthread_self(), policy, &param) != 0)
-        robotkernel::kernel::instance.log(warning, "setPriority: pthread_setschedparam(0x%x, %d, %d): %s\n",
-                pthread_self(), policy, priority, strerror(errno));
+        robotkernel::kernel::instance.log(warning, "setPriority: pthread_setschedparam(0x%lx, %d, %d): %s\n",
+                (unsigned long)pthread_self(), policy, priority, strerror(errno));
+}
+
+#ifdef __linux__
+//! sched_setattr argument, not exported by all libc versions
+struct rk_sched_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t  sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE  6
+#endif
+#endif
+
+bool robotkernel::set_sched_deadline(uint64_t runtime_ns, uint64_t deadline_ns, uint64_t period_ns) {
+    if (!period_ns)
+        return false;
+#if defined(__linux__) && defined(SYS_sched_setattr)
+    struct rk_sched_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.sched_policy   = SCHED_DEADLINE;
+    attr.sched_runtime  = runtime_ns;
+    attr.sched_deadline = deadline_ns ? deadline_ns : period_ns;
+    attr.sched_period   = period_ns;
+
+    robotkernel::kernel::instance.log(info, "setting SCHED_DEADLINE runtime %llu ns, "
+            "deadline %llu ns, period %llu ns\n", (unsigned long long)attr.sched_runtime, 
+            (unsigned long long)attr.sched_deadline, (unsigned long long)attr.sched_period);
+
+    if (syscall(SYS_sched_setattr, 0, &attr, 0) != 0) {
+        robotkernel::kernel::instance.log(warning, "set_sched_deadline: sched_setattr: %s\n", 
+                strerror(errno));
+        return false;
+    }
+
+    return true;
+#else
+    robotkernel::kernel::instance.log(warning, "set_sched_deadline: SCHED_DEADLINE "
+            "not supported on this platform\n");
+    return false;
+#endif
 }
 
 void robotkernel::set_affinity_mask(int affinity_mask) {
-    if (!affinity_mask)
+    set_affinity(cpu_affinity(affinity_mask));
+}
+
+void robotkernel::set_affinity(const cpu_affinity& affinity) {
+    if (affinity.empty())
         return;
 #ifdef __VXWORKS__
-    taskCpuAffinitySet(taskIdSelf(), (cpuset_t) affinity_mask);
+    taskCpuAffinitySet(taskIdSelf(), (cpuset_t) affinity.to_mask());
 #elif defined __QNX__
-    ThreadCtl(_NTO_TCTL_RUNMASK, (void *) affinity_mask);
+    ThreadCtl(_NTO_TCTL_RUNMASK, (void *) affinity.to_mask());
 #else
     cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);
-    for (unsigned i = 0; i < (sizeof(affinity_mask) * 8); ++i)
-        if (affinity_mask & (1 << i))
-            CPU_SET(i, &cpuset);
+    affinity.to_cpu_set(cpuset);
 
-    robotkernel::kernel::instance.log(info, "setting cpu affinity mask %#x\n", affinity_mask);
+    robotkernel::kernel::instance.log(info, "setting cpu affinity %s\n", affinity.to_string().c_str());
 
     int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
     if (ret != 0)
-        robotkernel::kernel::instance.log(warning, "setAffinityMask: pthread_setaffinity(%p, %#x): %d %s\n", 
-                (void *) pthread_self(), affinity_mask, ret, strerror(ret));
+        robotkernel::kernel::instance.log(warning, "set_affinity: pthread_setaffinity(%p, %s): %d %s\n", 
+                (void *) pthread_self(), affinity.to_string().c_str(), ret, strerror(ret));
+#endif
+}
+
+#ifdef __linux__
+#define RK_MPOL_PREFERRED   1
+#define RK_MPOL_MF_MOVE     (1 << 1)
+#endif
+
+bool robotkernel::numa_bind_memory(void *addr, size_t len, int numa_node) {
+    if ((numa_node < 0) || !addr || !len)
+        return false;
+#if defined(__linux__) && defined(SYS_mbind)
+    // mbind works on whole pages
+    uintptr_t page  = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)addr & ~(page - 1);
+    uintptr_t end   = ((uintptr_t)addr + len + page - 1) & ~(page - 1);
+
+    unsigned long nodemask[cpu_affinity::max_cpus / (8 * sizeof(unsigned long))] = { 0 };
+    if (numa_node >= (int)(sizeof(nodemask) * 8))
+        return false;
+    nodemask[numa_node / (8 * sizeof(unsigned long))] |= 1ul << (numa_node % (8 * sizeof(unsigned long)));
+
+    if (syscall(SYS_mbind, start, end - start, RK_MPOL_PREFERRED, nodemask, 
+                sizeof(nodemask) * 8, RK_MPOL_MF_MOVE) != 0) {
+        robotkernel::kernel::instance.log(warning, "numa_bind_memory: mbind(%p, %zu, node %d): %s\n", 
+                (void *)start, (size_t)(end - start), numa_node, strerror(errno));
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool robotkernel::numa_bind_thread(int numa_node) {
+    if (numa_node < 0)
+        return false;
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+    unsigned long nodemask[cpu_affinity::max_cpus / (8 * sizeof(unsigned long))] = { 0 };
+    if (numa_node >= (int)(sizeof(nodemask) * 8))
+        return false;
+    nodemask[numa_node / (8 * sizeof(unsigned long))] |= 1ul << (numa_node % (8 * sizeof(unsigned long)));
+
+    robotkernel::kernel::instance.log(info, "binding thread memory to NUMA node %d\n", numa_node);
+
+    // all further allocations of this thread prefer the node
+    if (syscall(SYS_set_mempolicy, RK_MPOL_PREFERRED, nodemask, sizeof(nodemask) * 8) != 0) {
+        robotkernel::kernel::instance.log(warning, "numa_bind_thread: set_mempolicy(node %d): %s\n", 
+                numa_node, strerror(errno));
+        return false;
+    }
+
+    // move already touched stack pages
+    pthread_attr_t attr;
+    void *stack_addr;
+    size_t stack_size;
+
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        if (pthread_attr_getstack(&attr, &stack_addr, &stack_size) == 0)
+            numa_bind_memory(stack_addr, stack_size, numa_node);
+
+        pthread_attr_destroy(&attr);
+    }
+
+    return true;
+#else
+    robotkernel::kernel::instance.log(warning, "numa_bind_thread: not supported on this platform\n");
+    return false;
 #endif
 }
 
@@ -34,11 +34,14 @@
 #include "robotkernel/module_base.h"
 #include "robotkernel/bridge_base.h"
 #include "robotkernel/config.h"
+#include "robotkernel/kernel_clock.h"
 #include "robotkernel/service_definitions.h"
+#include "robotkernel/local_service.h"
 
 // private headers
 #include "kernel.h"
 #include "rkc_loader.h"
+#include "service_marshal.h"
 
 #include "yaml-cpp/yaml.h"
 #include "sys/stat.h"
@@ -90,25 +93,43 @@ void kernel::trace_write(const char *fmt, ...) {
     char buf[256];
     int n;
 
-    if (trace_fd < 0)
-        return;
-
     va_start(ap, fmt);
     n = vsnprintf(buf, 256, fmt, ap);
     va_end(ap);
+    n = std::min(n, 255);
+
+    if (flight) {
+        flight->append(flight_recorder::type_trace, 0, 
+                kernel_clock::wall_ns(), buf, n);
+    }
+
+    if (trace_fd < 0)
+        return;
 
     int local_ret = write(trace_fd, buf, n);
     (void)local_ret;
 }
         
-void kernel::trace_write(const struct log_thread::log_pool_object *obj) {
+void kernel::trace_write(const struct log_thread::log_record *rec) {
     if (trace_fd < 0)
         return;
 
-    int local_ret = write(trace_fd, obj->buf, obj->len);
+    int local_ret = write(trace_fd, rec->buf, rec->len);
     (void)local_ret;
 }
 
+//! update up to which level records above loglevel have to be produced
+void kernel::update_log_capture() {
+    int lvl = 0;
+
+    if (do_log_to_trace_fd() || log_to_lttng_ust || dump_log_active())
+        lvl = verbose;
+    else if (flight)
+        lvl = flight_ll.value;
+
+    log_base::capture_level = lvl;
+}
+
 //! kernel singleton instance
 kernel kernel::instance;
 
@@ -236,18 +257,20 @@ module_state_t kernel::get_state(std::string mod_name) {
  */
 void kernel::call_service(const std::string& name, 
         const service_arglist_t& req, service_arglist_t& resp) {
-    for (auto& kv : services) {
-        string svc_name = kv.first.first + "." + kv.first.second;
+    sp_service_t svc;
 
-        if (svc_name != name) 
-            continue;
-    
-        service_t *svc = kv.second;
-        svc->callback(req, resp);
-        return;
+    {
+        rwlock::read_guard guard(services_lock);
+        service_index_t::const_iterator it = service_index.find(name);
+        if (it != service_index.end())
+            svc = it->second;
     }
-        
-    throw runtime_error(string_printf("service \"%s\" not found!\n", name.c_str()));
+
+    if (!svc)
+        throw runtime_error(string_printf("service \"%s\" not found!\n", name.c_str()));
+
+    // called without lock, callback may add or remove services
+    svc->callback(req, resp);
 }
 
 //! call a robotkernel service
@@ -259,16 +282,18 @@ void kernel::call_service(const std::string& name,
  */
 void kernel::call_service(const std::string& owner, const std::string& name, 
         const service_arglist_t& req, service_arglist_t& resp) {
-    
-    service_map_t::iterator it;
-    if ((it = services.find(std::make_pair(owner, name))) == services.end()) {
-        throw runtime_error(string_printf("service \"%s.%s\" not found!\n", owner.c_str(), name.c_str()));
+    sp_service_t svc;
+
+    {
+        rwlock::read_guard guard(services_lock);
+        service_map_t::const_iterator it = services.find(std::make_pair(owner, name));
+        if (it != services.end())
+            svc = it->second;
     }
-    
-    for (const auto& kv : bridge_map)
-        kv.second->remove_service(*(it->second));
 
-    service_t *svc = it->second;
+    if (!svc)
+        throw runtime_error(string_printf("service \"%s.%s\" not found!\n", owner.c_str(), name.c_str()));
+    
     svc->callback(req, resp);
 }
 
@@ -278,31 +303,309 @@ void kernel::call_service(const std::string& owner, const std::string& name,
  * \param name service name
  * \param service_definition service definition
  * \param callback service callback
+ * \param dispatch how the service is executed, may be 
+ *                 overridden by service_dispatch configuration
  */
 void kernel::add_service(
         const std::string& owner,
         const std::string& name, 
         const std::string& service_definition, 
-        service_callback_t callback) {
+        service_callback_t callback,
+        service_dispatch_t dispatch) {
+    service_dispatch_map_t::const_iterator dit;
+    if (    ((dit = service_dispatch_config.find(owner + "." + name)) != service_dispatch_config.end()) ||
+            ((dit = service_dispatch_config.find(owner + ".*")) != service_dispatch_config.end()))
+        dispatch = dit->second;
+
+    sp_service_t svc = make_shared<service_t>();
+    svc->owner              = owner;
+    svc->name               = name;
+    svc->service_definition = service_definition;
+    svc->descriptor         = get_service_descriptor(service_definition);
+    svc->dispatch           = dispatch;
+    svc->handler            = callback;
+    svc->callback           = callback;
+
+    if (dispatch != service_dispatch_inline) {
+        // bridges call the service synchronously, queue and wait
+        std::weak_ptr<service_t> weak_svc = svc;
+        svc->callback = [this, weak_svc](const service_arglist_t& req, service_arglist_t& resp) {
+            sp_service_t locked = weak_svc.lock();
+            if (!locked)
+                throw runtime_error(string_printf("service was removed!\n"));
+
+            return call_queued(locked, req, resp);
+        };
+    }
+
+    // account every call, bridges call the callback directly
+    sp_service_call_stats_t stats = svc->stats = make_shared<service_call_stats>();
+    service_callback_t call = svc->callback;
+    svc->callback = [stats, call](const service_arglist_t& req, service_arglist_t& resp) {
+        uint64_t start = kernel_clock::now_ns();
+        int ret;
+
+        try {
+            ret = call(req, resp);
+        } catch (...) {
+            stats->record(kernel_clock::now_ns() - start, true);
+            throw;
+        }
+
+        stats->record(kernel_clock::now_ns() - start, ret != 0);
+        return ret;
+    };
+
+    {
+        rwlock::write_guard guard(services_lock);
     
-    if (services.find(std::make_pair(owner, name)) != services.end()) {
-        log(warning, "SKIPPING service (already in) owner \"%s\", name \"%s\", service_definition:\n%s\n", 
-                owner.c_str(), name.c_str(), service_definition.c_str());
-        return;
+        if (!services.insert(std::make_pair(std::make_pair(owner, name), svc)).second) {
+            log(warning, "SKIPPING service (already in) owner \"%s\", name \"%s\", service_definition:\n%s\n", 
+                    owner.c_str(), name.c_str(), service_definition.c_str());
+            return;
+        }
+
+        service_index[owner + "." + name] = svc;
     }
 
     log(verbose, "adding service owner \"%s\", name \"%s\", service_definition:\n%s\n", 
             owner.c_str(), name.c_str(), service_definition.c_str());
 
-    service_t *svc          = new service_t();
-    svc->owner              = owner;
-    svc->name               = name;
-    svc->service_definition = service_definition;
-    svc->callback           = callback;
-    services[std::make_pair(owner, name)] = svc;
-
     for (const auto& kv : bridge_map)
         kv.second->add_service(*svc);
+    if (uds)
+        uds->add_service(*svc);
+}
+
+//! return parsed descriptor of service definition
+/*!
+ * Every distinct definition is parsed only once.
+ *
+ * \param[in] service_definition  Service definition (yaml).
+ * \return descriptor, empty if definition is invalid
+ */
+sp_service_descriptor_t kernel::get_service_descriptor(const std::string& service_definition) {
+    std::unique_lock<std::mutex> lock(service_descriptors_mtx);
+
+    auto it = service_descriptors.find(service_definition);
+    if (it != service_descriptors.end())
+        return it->second;
+
+    sp_service_descriptor_t desc;
+    try {
+        desc = service_descriptor::parse(service_definition);
+    } catch (const exception& e) {
+        log(warning, "invalid service definition: %s\n%s\n", e.what(), service_definition.c_str());
+        desc = make_shared<service_descriptor>();
+    }
+
+    service_descriptors[service_definition] = desc;
+    return desc;
+}
+
+//! return service executor, NULL after shutdown
+service_executor *kernel::get_service_executor() {
+    std::unique_lock<std::mutex> lock(svc_exec_mtx);
+
+    if (svc_exec_stopped)
+        return NULL;
+
+    if (!svc_exec)
+        svc_exec.reset(new service_executor(svc_exec_config));
+
+    return svc_exec.get();
+}
+
+//! call queued service synchronously
+/*!
+ * \param[in]  svc     Service with dispatch async or serialized.
+ * \param[in]  req     Service request parameters.
+ * \param[out] resp    Service response parameters.
+ */
+int kernel::call_queued(sp_service_t svc, const service_arglist_t& req, service_arglist_t& resp) {
+    service_executor *exec;
+
+    if (!(exec = get_service_executor()))
+        return svc->handler(req, resp);
+
+    if (service_executor::in_worker()) {
+        int ret = 0;
+        exec->run_nested(svc, [&]() { ret = svc->handler(req, resp); });
+        return ret;
+    }
+
+    auto result = make_shared<std::promise<int> >();
+    std::future<int> f = result->get_future();
+
+    exec->submit(svc, req, [result, &resp](int ret, service_arglist_t& r, std::exception_ptr ex) {
+                if (ex)
+                    result->set_exception(ex);
+                else {
+                    resp = std::move(r);
+                    result->set_value(ret);
+                }
+            }, true);
+
+    return f.get();
+}
+
+//! get service by name
+/*!
+ * \param[in] owner     Owner of service.
+ * \param[in] name      Name of service.
+ * \return service, throws if not found
+ */
+sp_service_t kernel::get_service(const std::string& owner, const std::string& name) {
+    rwlock::read_guard guard(services_lock);
+
+    service_map_t::const_iterator it = services.find(std::make_pair(owner, name));
+    if (it == services.end())
+        throw runtime_error(string_printf("service \"%s.%s\" not found!\n", owner.c_str(), name.c_str()));
+
+    return it->second;
+}
+
+//! set typed handler of an existing service
+/*!
+ * \param[in] owner     Owner of service.
+ * \param[in] name      Name of service.
+ * \param[in] handler   Typed handler, replaces previous one.
+ */
+void kernel::set_service_local_handler(const std::string& owner, const std::string& name,
+        sp_service_local_handler_t handler) {
+    sp_service_t svc = get_service(owner, name);
+    std::atomic_store(&svc->local, handler);
+}
+
+//! run typed call of queued service on service worker pool and wait
+/*!
+ * \param[in] svc       Service with dispatch async or serialized.
+ * \param[in] call      Calls typed handler.
+ */
+void kernel::call_local_queued(sp_service_t svc, std::function<void()> call) {
+    uint64_t start = kernel_clock::now_ns();
+    service_executor *exec;
+
+    try {
+        if (!(exec = get_service_executor()))
+            call();
+        else if (service_executor::in_worker())
+            exec->run_nested(svc, call);
+        else {
+            auto result = make_shared<std::promise<void> >();
+            std::future<void> f = result->get_future();
+
+            exec->submit(svc, call, [result](int, service_arglist_t&, std::exception_ptr ex) {
+                        if (ex)
+                            result->set_exception(ex);
+                        else
+                            result->set_value();
+                    }, true);
+
+            f.get();
+        }
+    } catch (...) {
+        svc->stats->record(kernel_clock::now_ns() - start, true);
+        throw;
+    }
+
+    svc->stats->record(kernel_clock::now_ns() - start, false);
+}
+
+//! call a robotkernel service asynchronously
+/*!
+ * Inline services are executed before returning, others are 
+ * queued to the service worker pool.
+ *
+ * \param[in]  owner         Owner of service to call.
+ * \param[in]  name          Name of service to call.
+ * \param[in]  req           Service request parameters.
+ * \param[in]  done          Completion, called with response or exception.
+ */
+void kernel::call_service_async(const std::string& owner, const std::string& name, 
+        const service_arglist_t& req, service_completion_t done) {
+    call_service_async(get_service(owner, name), req, done);
+}
+
+//! call a robotkernel service asynchronously
+/*!
+ * \param[in]  svc           Service to call.
+ * \param[in]  req           Service request parameters.
+ * \param[in]  done          Completion, called with response or exception.
+ */
+void kernel::call_service_async(sp_service_t svc, const service_arglist_t& req, 
+        service_completion_t done) {
+    // account call on completion
+    uint64_t start = kernel_clock::now_ns();
+    sp_service_call_stats_t stats = svc->stats;
+    service_executor::completion_t result = [stats, start, done](int ret, 
+            service_arglist_t& resp, std::exception_ptr ex) {
+        stats->record(kernel_clock::now_ns() - start, (ex != nullptr) || (ret != 0));
+        done(resp, ex);
+    };
+
+    service_executor *exec = NULL;
+    if (svc->dispatch != service_dispatch_inline)
+        exec = get_service_executor();
+
+    if (!exec || service_executor::in_worker()) {
+        service_arglist_t resp;
+        std::exception_ptr ex;
+        int ret = 0;
+
+        try {
+            if (exec)
+                exec->run_nested(svc, [&]() { ret = svc->handler(req, resp); });
+            else
+                ret = svc->handler(req, resp);
+        } catch (...) {
+            ex = std::current_exception();
+        }
+
+        result(ret, resp, ex);
+        return;
+    }
+
+    exec->submit(svc, req, result, false);
+}
+
+//! call a robotkernel service asynchronously
+/*!
+ * \param[in]  owner         Owner of service to call.
+ * \param[in]  name          Name of service to call.
+ * \param[in]  req           Service request parameters.
+ * \return future of service response
+ */
+std::future<service_arglist_t> kernel::call_service_async(const std::string& owner, 
+        const std::string& name, const service_arglist_t& req) {
+    auto result = make_shared<std::promise<service_arglist_t> >();
+    std::future<service_arglist_t> f = result->get_future();
+
+    call_service_async(owner, name, req, [result](service_arglist_t& r, std::exception_ptr ex) {
+                if (ex)
+                    result->set_exception(ex);
+                else
+                    result->set_value(std::move(r));
+            });
+
+    return f;
+}
+
+//! get queueing statistics of service
+/*!
+ * \param[in]  owner         Owner of service.
+ * \param[in]  name          Name of service.
+ * \param[out] st            Statistics.
+ * \return false if service was never queued
+ */
+bool kernel::get_service_queue_stats(const std::string& owner, 
+        const std::string& name, service_queue_stats& st) {
+    std::unique_lock<std::mutex> lock(svc_exec_mtx);
+
+    if (!svc_exec)
+        return false;
+
+    return svc_exec->get_stats(owner + "." + name, st);
 }
 
 //! remove on service given by name
@@ -311,15 +614,28 @@ void kernel::add_service(
  * \param[in] name      Name of service.
  */
 void kernel::remove_service(const std::string& owner, const std::string& name) {
-    service_map_t::iterator it;
-    if ((it = services.find(std::make_pair(owner, name))) == services.end())
-        return; // service not found
+    sp_service_t svc;
+
+    {
+        rwlock::write_guard guard(services_lock);
+
+        service_map_t::iterator it;
+        if ((it = services.find(std::make_pair(owner, name))) == services.end())
+            return; // service not found
+
+        svc = it->second;
+        services.erase(it);
+        service_index.erase(owner + "." + name);
+    }
     
-    for (const auto& kv : bridge_map)
-        kv.second->remove_service(*(it->second));
+    // service object stays valid until running calls have finished,
+    // typed handles must not call into the owner any more
+    std::atomic_store(&svc->local, sp_service_local_handler_t());
 
-    delete it->second;
-    services.erase(it);
+    for (const auto& kv : bridge_map)
+        kv.second->remove_service(*svc);
+    if (uds)
+        uds->remove_service(*svc);
 }
 
 //! remove all services from owner
@@ -327,29 +643,36 @@ void kernel::remove_service(const std::string& owner, const std::string& name) {
  * \param owner service owner
  */
 void kernel::remove_services(const std::string& owner) {
-    // remove all slaves from service providers
-    for (service_provider_map_t::iterator it = service_provider_map.begin();
-            it != service_provider_map.end(); ++it) {
-        it->second->remove_module(owner);
-    }
+    // remove all slaves from service providers, they also get device events
+    dev_events.run_exclusive([this, &owner]() {
+        for (service_provider_map_t::iterator it = service_provider_map.begin();
+                it != service_provider_map.end(); ++it) {
+            it->second->remove_module(owner);
+        }
+    });
 
-    for (service_map_t::iterator it = services.begin(); 
-            it != services.end(); ) {
-        const auto& svc = *(it->second);
+    std::list<sp_service_t> removed;
 
-        if (svc.owner != owner) {
-            ++it;
-            continue;
+    {
+        rwlock::write_guard guard(services_lock);
+
+        // services are ordered by owner
+        service_map_t::iterator it = services.lower_bound(std::make_pair(owner, string()));
+        while ((it != services.end()) && (it->first.first == owner)) {
+            service_index.erase(owner + "." + it->first.second);
+            removed.push_back(it->second);
+            it = services.erase(it);
         }
+    }
 
-        log(verbose, "removing service %s.%s\n", svc.owner.c_str(), svc.name.c_str());
+    for (const auto& svc : removed) {
+        log(verbose, "removing service %s.%s\n", svc->owner.c_str(), svc->name.c_str());
+        std::atomic_store(&svc->local, sp_service_local_handler_t());
     
         for (const auto& kv : bridge_map)
-            kv.second->remove_service(svc);
-
-
-        delete it->second;
-        it = services.erase(it);
+            kv.second->remove_service(*svc);
+        if (uds)
+            uds->remove_service(*svc);
     }
 }
 
@@ -362,13 +685,30 @@ kernel::kernel() :
 {
     _name = "robotkernel";
 
+    kernel_clock::calibrate();
     rk_log.start();
+
+    log(verbose, "using %s as time source\n", kernel_clock::source());
 }
         
 //! destruction
 kernel::~kernel() {
     log(info, "destructing...\n");
 
+    std::unique_ptr<service_executor> exec;
+    {
+        // queued services run inline from now on
+        std::unique_lock<std::mutex> lock(svc_exec_mtx);
+        svc_exec_stopped = true;
+        exec.swap(svc_exec);
+    }
+    exec.reset();
+
+    log(verbose, "log arena: %llu of %llu bytes used at most, %llu records dropped\n",
+            (unsigned long long)rk_log.get_high_water_mark(),
+            (unsigned long long)rk_log.get_arena_size(),
+            (unsigned long long)rk_log.get_dropped());
+
     log(info, "removing modules\n");
 
     // first step: set all modules to init
@@ -390,6 +730,12 @@ kernel::~kernel() {
         module_map.erase(it);
     }
     
+    log(info, "removing cyclic executives\n");
+    cyclic_executive_map.clear();
+
+    log(info, "removing fd reactors\n");
+    fd_reactor_map.clear();
+
     log(info, "removing bridges\n");
     bridge_map_t::iterator bit;
     while ((bit = bridge_map.begin()) != bridge_map.end()) {
@@ -398,6 +744,11 @@ kernel::~kernel() {
 
         log(verbose, "    bridge %s\n", bridge->name.c_str());
     }
+
+    if (uds) {
+        log(verbose, "    bridge %s\n", uds->name.c_str());
+        uds.reset();
+    }
     
     log(info, "removing service providers\n");
     service_provider_map_t::iterator sit;
@@ -408,6 +759,9 @@ kernel::~kernel() {
         log(verbose, "    service_provider %s\n", sp->name.c_str());
     }
 
+    // remaining device events are delivered synchronously from now on
+    dev_events.stop();
+
     // remove services
     log(verbose, "removing services\n");
     service_map_t::iterator slit;
@@ -419,16 +773,16 @@ kernel::~kernel() {
         for (const auto& kv : bridge_map)
             kv.second->remove_service(svc);
 
-        delete slit->second;
         services.erase(slit);
     }
+    service_index.clear();
 
 
     // remove process data
     log(verbose, "removing process data\n");
     std::map<std::string, sp_process_data_t>::iterator pdit;
     while ((pdit = process_data_map.begin()) != process_data_map.end()) {
-        log(verbose, "    process_data %d\n", pdit->first.c_str());
+        log(verbose, "    process_data %s\n", pdit->first.c_str());
         process_data_map.erase(pdit);
     }
 
@@ -585,6 +939,20 @@ void kernel::config(std::string config_file, int argc, char *argv[]) {
     rk_log.sync_logging = 
         get_as<bool>(doc, "sync_logging", false);
 
+    rk_log.binary_logging = 
+        get_as<bool>(doc, "log_binary", false);
+
+    if (doc["log_arena_size"])
+        rk_log.set_arena_size(get_as<size_t>(doc, "log_arena_size"));
+
+    if (doc["log_sinks"]) {
+        std::vector<sp_log_sink_t> sinks;
+        for (const auto& sink_node : doc["log_sinks"])
+            sinks.push_back(log_sink::create(sink_node));
+
+        rk_log.set_sinks(sinks);
+    }
+
     // search for log level
     if (doc["max_dump_log_len"]) {
         unsigned int len = 
@@ -592,9 +960,78 @@ void kernel::config(std::string config_file, int argc, char *argv[]) {
         dump_log_set_len(len, 0);
     }
 
+    if (doc["flight_recorder"]) {
+        const YAML::Node& fr = doc["flight_recorder"];
+        flight_ll = get_as<string>(fr, "loglevel", "verbose");
+        flight.reset(new flight_recorder(
+                    get_as<string>(fr, "path", "/dev/shm/robotkernel.flight"),
+                    get_as<size_t>(fr, "size", 8 * 1024 * 1024)));
+    }
+
+    update_log_capture();
+
+    if (doc["service_executor"])
+        svc_exec_config = doc["service_executor"];
+
+    YAML::Node dev_events_config;
+    if (doc["device_events"])
+        dev_events_config = doc["device_events"];
+    if (!get_as<bool>(dev_events_config, "synchronous", false))
+        dev_events.start(dev_events_config);
+
+    if (doc["service_dispatch"]) {
+        for (const auto& kv : doc["service_dispatch"]) {
+            string mode = kv.second.as<string>();
+            service_dispatch_t dispatch;
+
+            if (mode == "inline")
+                dispatch = service_dispatch_inline;
+            else if (mode == "async")
+                dispatch = service_dispatch_async;
+            else if (mode == "serialized")
+                dispatch = service_dispatch_serialized;
+            else
+                throw runtime_error(string_printf("[robotkernel] unknown service dispatch "
+                            "\"%s\" for %s, use inline, async or serialized\n", 
+                            mode.c_str(), kv.first.as<string>().c_str()));
+
+            service_dispatch_config[kv.first.as<string>()] = dispatch;
+        }
+    }
+
     _do_not_unload_modules = 
         get_as<bool>(doc, "do_not_unload_modules", false);
 
+    // parallel schedulers, applied when the trigger device gets registered
+    const YAML::Node& trigger_schedulers = doc["trigger_schedulers"];
+    for (YAML::const_iterator it = trigger_schedulers.begin(); it != trigger_schedulers.end(); ++it) {
+        const YAML::Node& ts_node = *it;
+        string trigger_name = get_as<string>(ts_node, "trigger");
+        trigger_scheduler_configs[trigger_name] = ts_node;
+    }
+
+    // fd reactors, created before modules so they can register descriptors
+    const YAML::Node& fd_reactors = doc["fd_reactors"];
+    for (YAML::const_iterator it = fd_reactors.begin(); it != fd_reactors.end(); ++it) {
+        sp_fd_reactor_t fr;
+        try {
+            fr = make_shared<fd_reactor>(*it);
+        }
+        catch(const exception& e) {
+            throw runtime_error(string_printf("exception while instantiating fd_reactor %s:\n%s",
+                                get_as<string>(*it, "name", "<no name specified>").c_str(),
+                                e.what()));
+        }
+
+        if (fd_reactor_map.find(fr->name) != fd_reactor_map.end()) {
+            throw runtime_error(string_printf("[robotkernel] duplicate fd_reactor name: %s\n", 
+                    fr->name.c_str()));
+        }
+
+        log(verbose, "adding [%s]\n", fr->name.c_str());
+        fd_reactor_map[fr->name] = fr;
+    }
+
     // creating modules specified in config file
     const YAML::Node& modules = doc["modules"];
     for (YAML::const_iterator it = modules.begin(); it != modules.end(); ++it) {
@@ -633,6 +1070,28 @@ void kernel::config(std::string config_file, int argc, char *argv[]) {
         mdl->set_state(module_state_init);
     }
 
+    const YAML::Node& cyclic_executives = doc["cyclic_executives"];
+    for (YAML::const_iterator it = cyclic_executives.begin(); it != cyclic_executives.end(); ++it) {
+        sp_cyclic_executive_t ce;
+        try {
+            ce = make_shared<cyclic_executive>(*it);
+        }
+        catch(const exception& e) {
+            throw runtime_error(string_printf("exception while instantiating cyclic_executive %s:\n%s",
+                                get_as<string>(*it, "name", "<no name specified>").c_str(),
+                                e.what()));
+        }
+
+        if (cyclic_executive_map.find(ce->name) != cyclic_executive_map.end()) {
+            throw runtime_error(string_printf("[robotkernel] duplicate cyclic_executive name: %s\n", 
+                    ce->name.c_str()));
+        }
+
+        log(verbose, "adding [%s]\n", ce->name.c_str());
+        cyclic_executive_map[ce->name] = ce;
+        ce->start();
+    }
+
     const YAML::Node& bridges = doc["bridges"];
     for (YAML::const_iterator it = bridges.begin(); it != bridges.end(); ++it) {
         sp_bridge_t brdg;
@@ -659,9 +1118,19 @@ void kernel::config(std::string config_file, int argc, char *argv[]) {
         log(verbose, "adding [%s]\n", brdg->name.c_str());
         bridge_map[brdg->name] = brdg;
 
+        rwlock::read_guard guard(services_lock);
         for (const auto& kv : services)
             brdg->add_service(*(kv.second));
     }
+
+    if (doc["uds_bridge"]) {
+        const YAML::Node& uds_node = doc["uds_bridge"];
+        uds = make_shared<uds_bridge>(get_as<string>(uds_node, "name", "uds_bridge"), uds_node);
+
+        rwlock::read_guard guard(services_lock);
+        for (const auto& kv : services)
+            uds->add_service(*(kv.second));
+    }
     
     const YAML::Node& service_providers = doc["service_providers"];
     for (YAML::const_iterator it = service_providers.begin(); it != service_providers.end(); ++it) {
@@ -691,6 +1160,7 @@ void kernel::config(std::string config_file, int argc, char *argv[]) {
     }
 
     add_svc_get_dump_log(_name, "get_dump_log");
+    add_svc_get_dump_log_page(_name, "get_dump_log_page");
     add_svc_config_dump_log(_name, "config_dump_log");
     add_svc_module_list(_name, "module_list");
     add_svc_reconfigure_module(_name, "reconfigure_module");
@@ -705,6 +1175,28 @@ void kernel::config(std::string config_file, int argc, char *argv[]) {
     add_svc_del_pd_injection(_name, "del_pd_injection");
     add_svc_list_pd_injections(_name, "list_pd_injections");
     add_svc_configure_loglevel(_name, "configure_loglevel");
+    add_svc_configure_log_rate(_name, "configure_log_rate");
+    add_svc_service_stats(_name, "service_stats");
+    add_svc_call_batch(_name, "call_batch");
+
+    // typed handlers for in-process callers
+    add_local_handler(_name, "get_dump_log", this, &kernel::svc_get_dump_log);
+    add_local_handler(_name, "get_dump_log_page", this, &kernel::svc_get_dump_log_page);
+    add_local_handler(_name, "config_dump_log", this, &kernel::svc_config_dump_log);
+    add_local_handler(_name, "module_list", this, &kernel::svc_module_list);
+    add_local_handler(_name, "reconfigure_module", this, &kernel::svc_reconfigure_module);
+    add_local_handler(_name, "add_module", this, &kernel::svc_add_module);
+    add_local_handler(_name, "remove_module", this, &kernel::svc_remove_module);
+    add_local_handler(_name, "list_devices", this, &kernel::svc_list_devices);
+    add_local_handler(_name, "process_data_info", this, &kernel::svc_process_data_info);
+    add_local_handler(_name, "trigger_info", this, &kernel::svc_trigger_info);
+    add_local_handler(_name, "stream_info", this, &kernel::svc_stream_info);
+    add_local_handler(_name, "service_interface_info", this, &kernel::svc_service_interface_info);
+    add_local_handler(_name, "add_pd_injection", this, &kernel::svc_add_pd_injection);
+    add_local_handler(_name, "del_pd_injection", this, &kernel::svc_del_pd_injection);
+    add_local_handler(_name, "list_pd_injections", this, &kernel::svc_list_pd_injections);
+    add_local_handler(_name, "service_stats", this, &kernel::svc_service_stats);
+    add_local_handler(_name, "call_batch", this, &kernel::svc_call_batch);
 }
 
 //! powering up modules
@@ -740,6 +1232,16 @@ bool kernel::power_up() {
         }
     }
         
+    // modules are up, check if static schedules fit their budgets
+    for (const auto& kv : cyclic_executive_map) {
+        try {
+            kv.second->verify();
+        } catch (exception& e) {
+            log(error, "%s\n", e.what());
+            failed_modules.push_back(kv.first);
+        }
+    }
+
     if (!failed_modules.empty()) {
         string msg = "modules failed to switch to OP: ";
 
@@ -849,59 +1351,64 @@ int kernel::state_change(const char *mod_name, module_state_t new_state) {
         
 // adds a device listener
 void kernel::add_device_listener(sp_device_listener_t dl) {
-    auto key = std::make_pair(dl->owner, dl->name);
-    if (dl_map.find(key) != dl_map.end()) {
+    bool added;
+    {
+        std::unique_lock<std::mutex> lock(dev_events_mtx);
+        added = dev_events.add_listener(dl, devices.get_all());
+    }
+
+    if (!added) {
         log(warning, "duplicate device listener! owner %s, name %s\n", 
                 dl->owner.c_str(), dl->name.c_str());
         return;
     }
 
-    dl_map[key] = dl;
-   
-    for (const auto& kv : device_map)
-        dl->notify_add_device(kv.second);
+    dev_events.dispatch();
 }
 
 // remove a device listener
 void kernel::remove_device_listener(sp_device_listener_t dl) {
-    auto key = std::make_pair(dl->owner, dl->name);
-    auto it = dl_map.find(key);
-    if (it == dl_map.end()) {
+    if (!dev_events.remove_listener(dl, devices.get_all()))
         log(warning, "cannot remove device listener (does not exists)! owner %s, name %s\n", 
                 dl->owner.c_str(), dl->name.c_str());
-        return;
-    }
-
-    for (const auto& kv : device_map)
-        dl_map[key]->notify_remove_device(kv.second);
-
-    dl_map[key] = nullptr;
-    dl_map.erase(it);
 }
 
 // add a named device
 void kernel::add_device(sp_device_t req) {
-    auto map_index = req->id();
-    if (device_map.find(map_index) != device_map.end()) {
-        log(warning, "duplicate regiser of device \"%s\", ignoring new device!\n", map_index.c_str());
-        return; // already in
+    const auto& map_index = req->id();
+    {
+        std::unique_lock<std::mutex> lock(dev_events_mtx);
+        if (!devices.add(req)) {
+            log(warning, "duplicate regiser of device \"%s\", ignoring new device!\n", map_index.c_str());
+            return; // already in
+        }
+
+        dev_events.post_add(req);
     }
 
     log(verbose, "registered device \"%s\"\n", map_index.c_str());
-    device_map[map_index] = req;
+
+    const auto& trg = std::dynamic_pointer_cast<trigger>(req);
+    auto ts_it = trigger_scheduler_configs.find(map_index);
+    if ((trg != nullptr) && (ts_it != trigger_scheduler_configs.end())) {
+        log(info, "using trigger_scheduler for trigger \"%s\"\n", map_index.c_str());
+        trg->set_scheduler(make_shared<trigger_scheduler>(ts_it->second));
+    }
     
     const auto& pd = std::dynamic_pointer_cast<process_data>(req);
-    if ((pd != nullptr) && pd->is_trigger_dev_generated()) {
-        add_device(pd->trigger_dev);
+    if (pd != nullptr) {
+        process_data::topology_generation++;
+
+        if (pd->is_trigger_dev_generated())
+            add_device(pd->trigger_dev);
     }
 
-    for (const auto& kv : dl_map) 
-        kv.second->notify_add_device(req);
+    dev_events.dispatch();
 };
         
 // remove a named device
 void kernel::remove_device(sp_device_t req) {
-    auto map_index = req->id();
+    const auto& map_index = req->id();
     
     const auto& pd = std::dynamic_pointer_cast<process_data>(req);
     if ((pd != nullptr) && pd->is_trigger_dev_generated()) {
@@ -910,26 +1417,47 @@ void kernel::remove_device(sp_device_t req) {
 
     log(verbose, "removing device %s\n", map_index.c_str());
 
-    for (const auto& kv : dl_map) 
-        kv.second->notify_remove_device(req);
+    {
+        std::unique_lock<std::mutex> lock(dev_events_mtx);
+        sp_device_t removed = devices.remove(map_index);
+        if (removed)
+            dev_events.post_remove(removed);
+    }
 
-    auto it = device_map.find(map_index);
-    if (it == device_map.end())
-        return; // no device with name found
+    if (pd != nullptr)
+        process_data::topology_generation++;
 
-    device_map[map_index] = nullptr;
-    device_map.erase(it);
+    // listeners must be done with the device before its module is unloaded
+    dev_events.flush();
 };
 
 // remove all devices from owner
 void kernel::remove_devices(const std::string& owner) {
-    for (auto it = device_map.begin(); it != device_map.end(); ) {
-        if (it->second->owner == owner) {
-            log(verbose, "removing device %s\n", it->second->id().c_str());
-            it = device_map.erase(it);
-        } else
-            ++it;
+    {
+        std::unique_lock<std::mutex> lock(dev_events_mtx);
+        for (const auto& dev : devices.remove_owner(owner)) {
+            log(verbose, "removing device %s\n", dev->id().c_str());
+            dev_events.post_remove(dev);
+
+            if (std::dynamic_pointer_cast<process_data>(dev))
+                process_data::topology_generation++;
+        }
     }
+
+    dev_events.flush();
+}
+
+//! get a fd reactor by name
+/*!
+ * \param[in] name      Name of fd reactor from config file.
+ * \return fd reactor
+ */
+sp_fd_reactor_t kernel::get_fd_reactor(const std::string& name) {
+    auto it = fd_reactor_map.find(name);
+    if (it == fd_reactor_map.end())
+        throw runtime_error(string_printf("[robotkernel] fd_reactor %s not found\n", name.c_str()));
+
+    return it->second;
 }
 
 //! loads additional modules
@@ -967,6 +1495,20 @@ void kernel::svc_get_dump_log(
     resp.log = dump_log_dump();
 }
 
+//! svc_get_dump_log_page
+/*!
+ * \param[in]   req     Service request data.
+ * \param[out]  resp    Service response data.
+ */
+void kernel::svc_get_dump_log_page(
+        const struct services::robotkernel::kernel::svc_req_get_dump_log_page& req, 
+        struct services::robotkernel::kernel::svc_resp_get_dump_log_page& resp) 
+{
+    bool more;
+    resp.log = dump_log_read(req.cursor, req.max_len, resp.next_cursor, more);
+    resp.more = more;
+}
+
 //! svc_config_dump_log
 /*!
  * \param[in]   req     Service request data.
@@ -993,6 +1535,7 @@ void kernel::svc_config_dump_log(
     else loglevel_to_string(verbose);
 
     ll = req.set_loglevel;
+    update_log_capture();
 }
 
 //! svc_add_module
@@ -1014,7 +1557,7 @@ void kernel::svc_add_module(
         log(info, "module \"%s\" added\n", mod_name.c_str());
     } catch(exception& e) {
         resp.error_message = e.what();
-        log(error, "error adding module \"%s\": %s\n", resp.error_message.c_str());
+        log(error, "error adding module: %s\n", resp.error_message.c_str());
     }
 
 }
@@ -1045,7 +1588,8 @@ void kernel::svc_remove_module(
         log(info, "module \"%s\" removed\n", req.mod_name.c_str());
     } catch (exception& e) {
         resp.error_message = e.what();
-        log(error, "error removing module \"%s\": %s\n", resp.error_message.c_str());
+        log(error, "error removing module \"%s\": %s\n", 
+                req.mod_name.c_str(), resp.error_message.c_str());
     }
 }
 
@@ -1125,9 +1669,7 @@ void kernel::svc_list_devices(
         const struct services::robotkernel::kernel::svc_req_list_devices& req, 
         struct services::robotkernel::kernel::svc_resp_list_devices& resp) 
 {
-    for (const auto& kv : device_map) {
-        resp.devices.push_back(kv.first);
-    }
+    devices.get_ids(resp.devices);
 
     resp.error_message = "";
 }
@@ -1143,8 +1685,9 @@ void kernel::svc_process_data_info(
 {
     resp.error_message = "";
 
-    if (device_map.find(req.name) != device_map.end()) {
-        const auto& pd = std::dynamic_pointer_cast<process_data>(device_map[req.name]);
+    sp_device_t found = devices.find(req.name);
+    if (found) {
+        const auto& pd = std::dynamic_pointer_cast<process_data>(found);
 
         if (pd) {
             resp.owner      = pd->owner;
@@ -1177,8 +1720,9 @@ void kernel::svc_trigger_info(
     resp.rate = 0.;
     resp.error_message = "";
 
-    if (device_map.find(req.name) != device_map.end()) {
-        const auto& dev = std::dynamic_pointer_cast<trigger>(device_map[req.name]);
+    sp_device_t found = devices.find(req.name);
+    if (found) {
+        const auto& dev = std::dynamic_pointer_cast<trigger>(found);
 
         if (dev) {
             resp.owner     = dev->owner;
@@ -1204,8 +1748,9 @@ void kernel::svc_stream_info(
     resp.owner = "";
     resp.error_message = "";
 
-    if (device_map.find(req.name) != device_map.end()) {
-        const auto& dev = std::dynamic_pointer_cast<stream>(device_map[req.name]);
+    sp_device_t found = devices.find(req.name);
+    if (found) {
+        const auto& dev = std::dynamic_pointer_cast<stream>(found);
 
         if (dev) {
             resp.owner     = dev->owner;
@@ -1230,8 +1775,9 @@ void kernel::svc_service_interface_info(
     resp.owner = "";
     resp.error_message = "";
 
-    if (device_map.find(req.name) != device_map.end()) {
-        const auto& dev = std::dynamic_pointer_cast<service_interface>(device_map[req.name]);
+    sp_device_t found = devices.find(req.name);
+    if (found) {
+        const auto& dev = std::dynamic_pointer_cast<service_interface>(found);
 
         if (dev) {
             resp.owner     = dev->owner;
@@ -1309,13 +1855,13 @@ void kernel::svc_list_pd_injections(
 {
     resp.error_message = "";
 
-    for (const auto& kv : device_map) {
+    for (const auto& pd : get_devices<process_data>()) {
         std::shared_ptr<pd_injection_base> retval = 
-            std::dynamic_pointer_cast<pd_injection_base>(kv.second);
+            std::dynamic_pointer_cast<pd_injection_base>(pd);
 
         if (retval) {
             for (const auto& kv_inj : retval->pd_injections) {
-                resp.pd_dev.push_back(kv.second->id());
+                resp.pd_dev.push_back(pd->id());
                 resp.field_name.push_back(kv_inj.second.field_name);
                 resp.value.push_back(kv_inj.second.value_string);
                 resp.bitmask.push_back(kv_inj.second.bitmask_string);
@@ -1324,6 +1870,224 @@ void kernel::svc_list_pd_injections(
     }
 }
 
+//! svc_service_stats
+/*!
+ * \param[in]   req     Service request data.
+ * \param[out]  resp    Service response data.
+ */
+void kernel::svc_service_stats(
+        const struct services::robotkernel::kernel::svc_req_service_stats& req, 
+        struct services::robotkernel::kernel::svc_resp_service_stats& resp)
+{
+    resp.error_message  = "";
+    resp.histogram_bins = service_call_stats::histogram_bins;
+
+    // empty name for all services, "owner.*" for all services of owner
+    string owner_prefix;
+    if ((req.name.size() > 2) && (req.name.compare(req.name.size() - 2, 2, ".*") == 0))
+        owner_prefix = req.name.substr(0, req.name.size() - 1);
+
+    std::vector<sp_service_t> matched;
+    {
+        rwlock::read_guard guard(services_lock);
+
+        if ((req.name == "") || (owner_prefix != "")) {
+            for (const auto& kv : services) {
+                if ((owner_prefix == "") || ((kv.first.first + ".") == owner_prefix))
+                    matched.push_back(kv.second);
+            }
+        } else {
+            service_index_t::const_iterator it = service_index.find(req.name);
+            if (it != service_index.end())
+                matched.push_back(it->second);
+        }
+    }
+
+    if (matched.empty() && (req.name != "")) {
+        resp.error_message = string_printf("service \"%s\" not found!\n", req.name.c_str());
+        return;
+    }
+
+    for (const auto& svc : matched) {
+        service_call_stats& st = *svc->stats;
+        uint64_t calls = st.calls;
+
+        resp.names.push_back(svc->owner + "." + svc->name);
+        resp.calls.push_back(calls);
+        resp.errors.push_back(st.errors);
+        resp.mean_ns.push_back(calls ? st.total_ns / calls : 0);
+        resp.max_ns.push_back(st.max_ns);
+
+        for (unsigned i = 0; i < service_call_stats::histogram_bins; ++i)
+            resp.histogram.push_back(st.histogram[i]);
+
+        service_queue_stats qst = service_queue_stats();
+        get_service_queue_stats(svc->owner, svc->name, qst);
+        resp.queue_blocked.push_back(qst.blocked);
+        resp.queue_rejected.push_back(qst.rejected);
+
+        if (req.reset)
+            st.reset();
+    }
+}
+
+//! svc_call_batch
+/*!
+ * \param[in]   req     Service request data.
+ * \param[out]  resp    Service response data.
+ */
+void kernel::svc_call_batch(
+        const struct services::robotkernel::kernel::svc_req_call_batch& req, 
+        struct services::robotkernel::kernel::svc_resp_call_batch& resp)
+{
+    resp.error_message = "";
+    size_t n = req.owners.size();
+
+    if ((req.names.size() != n) || (req.requests.size() != n)) {
+        resp.error_message = string_printf("owners, names and requests need same length "
+                "(%d, %d, %d)\n", (int)n, (int)req.names.size(), (int)req.requests.size());
+        return;
+    }
+
+    struct batch_entry {
+        sp_service_t svc;
+        const service_fields_t *resp_fields;
+        service_arglist_t req;
+        service_arglist_t resp;
+        string error;
+    };
+
+    std::vector<batch_entry> entries(n);
+    {
+        rwlock::read_guard guard(services_lock);
+
+        for (size_t i = 0; i < n; ++i) {
+            service_map_t::const_iterator it = services.find(std::make_pair(req.owners[i], req.names[i]));
+            if (it != services.end())
+                entries[i].svc = it->second;
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        batch_entry& e = entries[i];
+
+        if (!e.svc) {
+            e.error = string_printf("service \"%s.%s\" not found!\n", 
+                    req.owners[i].c_str(), req.names[i].c_str());
+            continue;
+        }
+
+        try {
+            e.resp_fields = &e.svc->descriptor->response;
+            yaml_to_arglist(e.svc->descriptor->request, YAML::Load(req.requests[i]), e.req);
+        } catch (const exception& ex) {
+            e.error = string_printf("invalid request for %s.%s: %s", 
+                    req.owners[i].c_str(), req.names[i].c_str(), ex.what());
+            e.svc.reset();
+        }
+    }
+
+    service_executor *exec = NULL;
+    if (req.parallel && !service_executor::in_worker())
+        exec = get_service_executor();
+
+    if (exec) {
+        // run on worker pool, serialized services keep their owner order
+        std::mutex done_mtx;
+        std::condition_variable done_cond;
+        size_t pending = 0;
+
+        // completion finished, also if storing the result throws
+        struct done_guard {
+            std::mutex& mtx;
+            std::condition_variable& cond;
+            size_t& pending;
+
+            ~done_guard() {
+                std::unique_lock<std::mutex> lock(mtx);
+                if (--pending == 0)
+                    cond.notify_all();
+            }
+        };
+
+        for (auto& e : entries) {
+            if (!e.svc)
+                continue;
+
+            uint64_t start = kernel_clock::now_ns();
+            sp_service_call_stats_t stats = e.svc->stats;
+            batch_entry *ep = &e;
+
+            {
+                std::unique_lock<std::mutex> lock(done_mtx);
+                pending++;
+            }
+
+            try {
+                exec->submit(e.svc, e.req, [&, ep, stats, start](int ret, 
+                            service_arglist_t& r, std::exception_ptr ex) {
+                            done_guard guard = { done_mtx, done_cond, pending };
+                            stats->record(kernel_clock::now_ns() - start, (ex != nullptr) || (ret != 0));
+
+                            if (ex) {
+                                try {
+                                    std::rethrow_exception(ex);
+                                } catch (const exception& err) {
+                                    ep->error = err.what();
+                                } catch (...) {
+                                    ep->error = "unknown exception";
+                                }
+                            } else
+                                ep->resp = std::move(r);
+                        }, true);
+            } catch (const exception& ex) {
+                e.error = ex.what();
+
+                std::unique_lock<std::mutex> lock(done_mtx);
+                pending--;
+            } catch (...) {
+                e.error = "unknown exception";
+
+                std::unique_lock<std::mutex> lock(done_mtx);
+                pending--;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(done_mtx);
+        done_cond.wait(lock, [&pending] { return pending == 0; });
+    } else {
+        for (auto& e : entries) {
+            if (!e.svc)
+                continue;
+
+            try {
+                e.svc->callback(e.req, e.resp);
+            } catch (const exception& ex) {
+                e.error = ex.what();
+            } catch (...) {
+                e.error = "unknown exception";
+            }
+        }
+    }
+
+    resp.responses.resize(n);
+    resp.errors.resize(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        batch_entry& e = entries[i];
+
+        if (e.svc && (e.error == "")) {
+            try {
+                resp.responses[i] = arglist_to_yaml(*e.resp_fields, e.resp);
+            } catch (const exception& ex) {
+                e.error = string_printf("invalid response: %s", ex.what());
+            }
+        }
+
+        resp.errors[i] = e.error;
+    }
+}
+
 //! convert buffer to hex string
 std::string robotkernel::hex_string(const void *data, size_t len) {
     char hex_buf[4];
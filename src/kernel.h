@@ -29,6 +29,8 @@
 
 #include <string>
 #include <mutex>
+#include <unordered_map>
+#include <future>
 #include <functional>
 #include <stdexcept>
 
@@ -42,14 +44,22 @@
 #include <robotkernel/service_definitions.h>
 #include <robotkernel/stream.h>
 #include <robotkernel/trigger.h>
+#include <robotkernel/fd_reactor.h>
+#include <robotkernel/flight_recorder.h>
 #include <robotkernel/log_base.h>
 
 // private headers
 #include "log_thread.h"
 #include "module.h"
 #include "bridge.h"
+#include "uds_bridge.h"
 #include "service_provider.h"
 #include "dump_log.h"
+#include "cyclic_executive.h"
+#include "rwlock.h"
+#include "service_executor.h"
+#include "device_registry.h"
+#include "device_event_bus.h"
 
 namespace robotkernel {
 
@@ -57,6 +67,7 @@ class kernel :
     public log_base,
     public services::robotkernel::kernel::svc_base_config_dump_log,
     public services::robotkernel::kernel::svc_base_get_dump_log,
+    public services::robotkernel::kernel::svc_base_get_dump_log_page,
     public services::robotkernel::kernel::svc_base_list_devices,
     public services::robotkernel::kernel::svc_base_module_list,
     public services::robotkernel::kernel::svc_base_add_module,
@@ -68,7 +79,9 @@ class kernel :
     public services::robotkernel::kernel::svc_base_service_interface_info,
     public services::robotkernel::kernel::svc_base_add_pd_injection,
     public services::robotkernel::kernel::svc_base_del_pd_injection,
-    public services::robotkernel::kernel::svc_base_list_pd_injections
+    public services::robotkernel::kernel::svc_base_list_pd_injections,
+    public services::robotkernel::kernel::svc_base_service_stats,
+    public services::robotkernel::kernel::svc_base_call_batch
 {
     public:
         //! kernel singleton instance
@@ -81,16 +94,58 @@ class kernel :
 
         loglevel                    ll;                         //!< robotkernel global loglevel
         bridge_map_t                bridge_map;                 //!< bridges map
+        sp_uds_bridge_t             uds;                        //!< built-in unix domain socket bridge
         service_provider_map_t      service_provider_map;       //!< service_providers map
+        cyclic_executive_map_t      cyclic_executive_map;       //!< cyclic executives map
+        fd_reactor_map_t            fd_reactor_map;             //!< fd reactors map
         module_map_t                module_map;                 //!< modules map
         std::recursive_mutex        module_map_mtx;             //!< module map lock
         service_map_t               services;                   //!< service list
-        device_listener_map_t       dl_map;                     //!< device listeners
+
+        typedef std::unordered_map<std::string, sp_service_t> service_index_t;
+        service_index_t             service_index;              //!< services by "owner.name"
+        rwlock                      services_lock;              //!< protects services and service_index
+
+        typedef std::unordered_map<std::string, sp_service_descriptor_t> service_descriptor_map_t;
+        service_descriptor_map_t    service_descriptors;        //!< parsed descriptors by definition
+        std::mutex                  service_descriptors_mtx;    //!< protects service_descriptors
+
+        //! return parsed descriptor of service definition
+        /*!
+         * Every distinct definition is parsed only once.
+         *
+         * \param[in] service_definition  Service definition (yaml).
+         * \return descriptor, empty if definition is invalid
+         */
+        sp_service_descriptor_t get_service_descriptor(const std::string& service_definition);
+
+        typedef std::map<std::string, service_dispatch_t> service_dispatch_map_t;
+        service_dispatch_map_t      service_dispatch_config;    //!< dispatch by "owner.name" or "owner.*"
+        YAML::Node                  svc_exec_config;            //!< service executor configuration
+        std::unique_ptr<service_executor> svc_exec;             //!< service worker pool, created on demand
+        bool                        svc_exec_stopped = false;   //!< run queued services inline
+        std::mutex                  svc_exec_mtx;               //!< protects svc_exec
+
+        //! return service executor, NULL after shutdown
+        service_executor *get_service_executor();
+
+        //! call queued service synchronously
+        /*!
+         * \param[in]  svc     Service with dispatch async or serialized.
+         * \param[in]  req     Service request parameters.
+         * \param[out] resp    Service response parameters.
+         */
+        int call_queued(sp_service_t svc, const service_arglist_t& req, service_arglist_t& resp);
+        device_event_bus            dev_events;                 //!< device listener notification
+        std::mutex                  dev_events_mtx;             //!< orders device changes with their events
 
         typedef std::map<std::string, std::string> datatypes_map_t;
         datatypes_map_t datatypes_map;
 
-        device_map_t device_map;
+        device_registry devices;                                //!< registered devices
+
+        typedef std::map<std::string, YAML::Node> trigger_scheduler_configs_t;
+        trigger_scheduler_configs_t trigger_scheduler_configs;  //!< scheduler configs by trigger id
 
         int trace_fd = 0;
         bool log_to_trace_fd = false;
@@ -113,7 +168,7 @@ class kernel :
 
         //! log object to trace fd
         void trace_write(const char *fmt, ...);
-        void trace_write(const struct log_thread::log_pool_object *obj);
+        void trace_write(const struct log_thread::log_record *rec);
 
         //! call a robotkernel service
         /*!
@@ -140,12 +195,81 @@ class kernel :
          * \param name service name
          * \param service_definition service definition
          * \param callback service callback
+         * \param dispatch how the service is executed, may be 
+         *                 overridden by service_dispatch configuration
          */
         void add_service(
                 const std::string &owner,
                 const std::string &name,
                 const std::string &service_definition,
-                service_callback_t callback);
+                service_callback_t callback,
+                service_dispatch_t dispatch = service_dispatch_inline);
+
+        //! call a robotkernel service asynchronously
+        /*!
+         * Inline services are executed before returning, others are 
+         * queued to the service worker pool.
+         *
+         * \param[in]  owner         Owner of service to call.
+         * \param[in]  name          Name of service to call.
+         * \param[in]  req           Service request parameters.
+         * \param[in]  done          Completion, called with response or exception.
+         */
+        void call_service_async(const std::string& owner, const std::string& name, 
+                const service_arglist_t& req, service_completion_t done);
+
+        //! call a robotkernel service asynchronously
+        /*!
+         * \param[in]  svc           Service to call.
+         * \param[in]  req           Service request parameters.
+         * \param[in]  done          Completion, called with response or exception.
+         */
+        void call_service_async(sp_service_t svc, const service_arglist_t& req, 
+                service_completion_t done);
+
+        //! call a robotkernel service asynchronously
+        /*!
+         * \param[in]  owner         Owner of service to call.
+         * \param[in]  name          Name of service to call.
+         * \param[in]  req           Service request parameters.
+         * \return future of service response
+         */
+        std::future<service_arglist_t> call_service_async(const std::string& owner, 
+                const std::string& name, const service_arglist_t& req);
+
+        //! get service by name
+        /*!
+         * \param[in] owner     Owner of service.
+         * \param[in] name      Name of service.
+         * \return service, throws if not found
+         */
+        sp_service_t get_service(const std::string& owner, const std::string& name);
+
+        //! set typed handler of an existing service
+        /*!
+         * \param[in] owner     Owner of service.
+         * \param[in] name      Name of service.
+         * \param[in] handler   Typed handler, replaces previous one.
+         */
+        void set_service_local_handler(const std::string& owner, const std::string& name,
+                sp_service_local_handler_t handler);
+
+        //! run typed call of queued service on service worker pool and wait
+        /*!
+         * \param[in] svc       Service with dispatch async or serialized.
+         * \param[in] call      Calls typed handler.
+         */
+        void call_local_queued(sp_service_t svc, std::function<void()> call);
+
+        //! get queueing statistics of service
+        /*!
+         * \param[in]  owner         Owner of service.
+         * \param[in]  name          Name of service.
+         * \param[out] st            Statistics.
+         * \return false if service was never queued
+         */
+        bool get_service_queue_stats(const std::string& owner, 
+                const std::string& name, service_queue_stats& st);
 
         //! remove on service given by name
         /*!
@@ -192,6 +316,13 @@ class kernel :
          */
         void remove_devices(const std::string& owner);
 
+        //! get a fd reactor by name
+        /*!
+         * \param[in] name      Name of fd reactor from config file.
+         * \return fd reactor
+         */
+        sp_fd_reactor_t get_fd_reactor(const std::string& name);
+
         //! get a device by name
         /*!
          * \param dev_name device name
@@ -199,6 +330,32 @@ class kernel :
          */
         template <typename T>
         std::shared_ptr<T> get_device(const std::string& dev_name);
+
+        //! get interned handle of a device name
+        /*!
+         * The device does not have to be registered yet. The handle stays
+         * valid when the device is removed and added again.
+         *
+         * \param dev_name device name
+         * \return device handle
+         */
+        device_handle_t get_device_handle(const std::string& dev_name) {
+            return devices.get_handle(dev_name); }
+
+        //! get a device by handle
+        /*!
+         * \param handle device handle from get_device_handle
+         * \return device
+         */
+        template <typename T>
+        std::shared_ptr<T> get_device(device_handle_t handle);
+
+        //! get all devices of given type
+        /*!
+         * \return list of devices
+         */
+        template <typename T>
+        std::list<std::shared_ptr<T> > get_devices();
         
         //! Register a new datatype description
         /*!
@@ -290,9 +447,16 @@ class kernel :
         std::string _internal_modpath;
         std::string _internal_intfpath;
 
+        // declared before rk_log, the log thread uses it until it is stopped
+        std::unique_ptr<flight_recorder> flight;    //!< crash-surviving log ring
+        loglevel flight_ll;                         //!< highest level recorded
+
         log_thread rk_log;
         bool log_to_lttng_ust = false;
 
+        //! update up to which level records above loglevel have to be produced
+        void update_log_capture();
+
         static std::string ll_to_string(loglevel ll);
 
 
@@ -304,6 +468,15 @@ class kernel :
         void svc_get_dump_log(
             const struct services::robotkernel::kernel::svc_req_get_dump_log& req, 
             struct services::robotkernel::kernel::svc_resp_get_dump_log& resp) override;
+
+        //! svc_get_dump_log_page
+        /*!
+         * \param[in]   req     Service request data.
+         * \param[out]  resp    Service response data.
+         */
+        void svc_get_dump_log_page(
+            const struct services::robotkernel::kernel::svc_req_get_dump_log_page& req, 
+            struct services::robotkernel::kernel::svc_resp_get_dump_log_page& resp) override;
         
         //! svc_config_dump_log
         /*!
@@ -421,15 +594,34 @@ class kernel :
         void svc_list_pd_injections(
             const struct services::robotkernel::kernel::svc_req_list_pd_injections& req, 
             struct services::robotkernel::kernel::svc_resp_list_pd_injections& resp) override;
+
+        //! svc_service_stats
+        /*!
+         * \param[in]   req     Service request data.
+         * \param[out]  resp    Service response data.
+         */
+        void svc_service_stats(
+            const struct services::robotkernel::kernel::svc_req_service_stats& req, 
+            struct services::robotkernel::kernel::svc_resp_service_stats& resp) override;
+
+        //! svc_call_batch
+        /*!
+         * \param[in]   req     Service request data.
+         * \param[out]  resp    Service response data.
+         */
+        void svc_call_batch(
+            const struct services::robotkernel::kernel::svc_req_call_batch& req, 
+            struct services::robotkernel::kernel::svc_resp_call_batch& resp) override;
 };
         
 // get a device by name
 template <typename T>
 inline std::shared_ptr<T> kernel::get_device(const std::string& dev_name) {
-    if (device_map.find(dev_name) == device_map.end()) 
+    sp_device_t dev = devices.find(dev_name);
+    if (!dev) 
         throw std::runtime_error(robotkernel::string_printf("device %s not found\n", dev_name.c_str()));
 
-    std::shared_ptr<T> retval = std::dynamic_pointer_cast<T>(device_map[dev_name]);
+    std::shared_ptr<T> retval = std::dynamic_pointer_cast<T>(dev);
     if (!retval)
         throw std::runtime_error(robotkernel::string_printf("device %s is not of type %s\n", 
                 dev_name.c_str(), typeid(T).name()));
@@ -437,6 +629,29 @@ inline std::shared_ptr<T> kernel::get_device(const std::string& dev_name) {
     return retval;
 };
 
+// get a device by handle
+template <typename T>
+inline std::shared_ptr<T> kernel::get_device(device_handle_t handle) {
+    sp_device_t dev = devices.find(handle);
+    if (!dev) 
+        throw std::runtime_error(robotkernel::string_printf("device with handle %u not found\n", handle));
+
+    std::shared_ptr<T> retval = std::dynamic_pointer_cast<T>(dev);
+    if (!retval)
+        throw std::runtime_error(robotkernel::string_printf("device %s is not of type %s\n", 
+                dev->id().c_str(), typeid(T).name()));
+
+    return retval;
+};
+
+// get all devices of given type
+template <typename T>
+inline std::list<std::shared_ptr<T> > kernel::get_devices() {
+    std::list<std::shared_ptr<T> > retval;
+    devices.get(retval);
+    return retval;
+};
+
 } // namespace robotkernel
 
 #endif // ROBOTKERNEL__KERNEL_H
@@ -0,0 +1,109 @@
+//! robotkernel kernel clock
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/kernel_clock.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace robotkernel;
+
+kernel_clock::state kernel_clock::st = { false, 0, 0, 0 };
+std::atomic<int64_t> kernel_clock::wall_offset(0);
+
+//! check if linux uses tsc as clocksource
+static bool tsc_is_clocksource() {
+    FILE *f = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+    if (!f)
+        return false;
+
+    char buf[32] = { 0 };
+    bool ret = (fgets(buf, sizeof(buf), f) != NULL) && (strncmp(buf, "tsc", 3) == 0);
+    fclose(f);
+    return ret;
+}
+
+#if defined(__x86_64__)
+//! sample tsc and CLOCK_MONOTONIC_RAW at the same time
+static void sample(uint64_t& tsc, uint64_t& ns) {
+    uint64_t best = (uint64_t)-1;
+
+    // keep sample with smallest tsc window around clock read
+    for (int i = 0; i < 5; ++i) {
+        struct timespec ts;
+        uint64_t t0 = __rdtsc();
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        uint64_t t1 = __rdtsc();
+
+        if (t1 - t0 < best) {
+            best = t1 - t0;
+            tsc  = t0 + (t1 - t0) / 2;
+            ns   = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+        }
+    }
+}
+#endif
+
+//! calibrate time stamp counter and wall clock anchor
+/*!
+ * Has to be called once before other threads use the clock, takes 
+ * about 10 ms.
+ */
+void kernel_clock::calibrate() {
+#if defined(__x86_64__)
+    if (!st.use_tsc && tsc_is_clocksource()) {
+        uint64_t tsc0, ns0, tsc1, ns1;
+
+        sample(tsc0, ns0);
+        usleep(10000);
+        sample(tsc1, ns1);
+
+        if (tsc1 > tsc0) {
+            st.mult     = (uint64_t)(((unsigned __int128)(ns1 - ns0) << 32) / (tsc1 - tsc0));
+            st.tsc_base = tsc1;
+            st.ns_base  = ns1;
+            st.use_tsc  = true;
+        }
+    }
+#endif
+
+    resync_wall();
+}
+
+//! refresh wall clock anchor
+void kernel_clock::resync_wall() {
+    struct timespec ts;
+    uint64_t before = now_ns();
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t after = now_ns();
+
+    int64_t real = (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+    wall_offset.store(real - (int64_t)(before + (after - before) / 2), 
+            std::memory_order_relaxed);
+}
+
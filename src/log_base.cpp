@@ -27,6 +27,7 @@
 // public headers
 #include "robotkernel/log_base.h"
 #include "robotkernel/config.h"
+#include "robotkernel/kernel_clock.h"
 #include "robotkernel/service_definitions.h"
 
 // private headers
@@ -43,12 +44,49 @@ using namespace std;
 using namespace std::placeholders;
 using namespace robotkernel;
 
+std::atomic<int> log_base::capture_level(0);
+
+//! check if message may pass
+/*!
+ * \param[in]   rate        Allowed messages per second.
+ * \param[in]   burst       Allowed burst of messages.
+ * \param[out]  n_supp      Number of messages suppressed since
+ *                          last passed message.
+ * \return true if message may be logged
+ */
+bool log_ratelimit::pass(double rate, unsigned int burst, uint32_t& n_supp) {
+    n_supp = 0;
+
+    if (rate <= 0.)
+        return true;
+
+    uint64_t interval = (uint64_t)(1e9 / rate);
+    uint64_t tolerance = interval * (burst > 0 ? burst - 1 : 0);
+    uint64_t now = kernel_clock::now_ns();
+    uint64_t cur = tat.load(std::memory_order_relaxed);
+
+    while (true) {
+        if (cur > now + tolerance) {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        uint64_t next = std::max(cur, now) + interval;
+        if (tat.compare_exchange_weak(cur, next, std::memory_order_relaxed))
+            break;
+    }
+
+    n_supp = suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
 //! construction
 /*!
  * \param[in]   ll          Loglevel to set.
  */
 log_base::log_base(loglevel ll) :
-    ll(ll), name("robotkernel"), impl("robotkernel"), service_prefix("")
+    ll(ll), name("robotkernel"), impl("robotkernel"), service_prefix(""),
+    log_rate(0.), log_burst(10)
 {
     //add_svc_configure_loglevel(name, "configure_loglevel");
 }
@@ -59,7 +97,8 @@ log_base::log_base(loglevel ll) :
  */
 log_base::log_base(const std::string& name, const std::string& impl, 
         const std::string& service_prefix, const YAML::Node& node) :
-    name(name), impl(impl), service_prefix(service_prefix)
+    name(name), impl(impl), service_prefix(service_prefix), 
+    log_rate(0.), log_burst(10)
 {
     ll = robotkernel::kernel::instance.get_loglevel();
 
@@ -81,18 +120,26 @@ log_base::log_base(const std::string& name, const std::string& impl,
             else if (ll_string == "verbose")
                 ll = verbose;
         } 
+
+        log_rate  = get_as<double>(node, "log_rate", log_rate.load());
+        log_burst = get_as<unsigned int>(node, "log_burst", log_burst.load());
     }
 
     std::string service_name = "configure_loglevel";
-    if (service_prefix != "") 
+    std::string rate_service_name = "configure_log_rate";
+    if (service_prefix != "") {
         service_name = service_prefix + "." + service_name;
+        rate_service_name = service_prefix + "." + rate_service_name;
+    }
 
     add_svc_configure_loglevel(name, service_name);
+    add_svc_configure_log_rate(name, rate_service_name);
 }
 
 //! destruction
 log_base::~log_base() {
     remove_svc_configure_loglevel();
+    remove_svc_configure_log_rate();
 }
 
 //! svc_configure_loglevel
@@ -109,41 +156,125 @@ void log_base::svc_configure_loglevel(
     resp.error_message = "";
 }
 
+//! svc_configure_log_rate
+/*!
+ * Negative request values keep the current setting.
+ *
+ * \param[in]   req     Service request data.
+ * \param[out]  resp    Service response data.
+ */
+void log_base::svc_configure_log_rate(
+        const struct services::robotkernel::log_base::svc_req_configure_log_rate& req, 
+        struct services::robotkernel::log_base::svc_resp_configure_log_rate& resp) 
+{
+    resp.current_log_rate = log_rate;
+    resp.current_log_burst = log_burst;
+    resp.error_message = "";
+
+    if (req.set_log_rate >= 0.)
+        log_rate = req.set_log_rate;
+    if (req.set_log_burst >= 0)
+        log_burst = req.set_log_burst;
+}
+
 //! log to kernel logging facility
 void log_base::log(loglevel lvl, const char *format, ...) {
-    struct log_thread::log_pool_object *obj;
-
-    if ((obj = robotkernel::kernel::instance.rk_log.get_pool_object()) != NULL) {
-        // only ifempty log pool avaliable!
-        obj->lvl = lvl;
-        int bufpos = snprintf(obj->buf+bufpos, sizeof(obj->buf)-bufpos, "[%s|%s] ", 
-            name.c_str(), impl.c_str());
-
-        // format argument list    
-        va_list args;
-        va_start(args, format);
-        bufpos += vsnprintf(obj->buf+bufpos, sizeof(obj->buf)-bufpos, format, args);
-        va_end(args);
-    
-        obj->len = bufpos;
-
-        if (robotkernel::kernel::instance.do_log_to_trace_fd()) {
-            robotkernel::kernel::instance.trace_write(obj);
+    if (!log_enabled(lvl))
+        return;
+
+    va_list args;
+    va_start(args, format);
+    vlog(lvl, format, args);
+    va_end(args);
+}
+
+//! log to kernel logging facility with rate limiting
+/*!
+ * \param[in]   rl      Rate limiter of callsite.
+ * \param[in]   lvl     Loglevel of message.
+ * \param[in]   format  Printf-like format string.
+ */
+void log_base::log_ratelimited(log_ratelimit& rl, loglevel lvl, 
+        const char *format, ...) {
+    if (!log_enabled(lvl))
+        return;
+
+    uint32_t n_supp;
+    if (!rl.pass(log_rate.load(std::memory_order_relaxed), 
+                log_burst.load(std::memory_order_relaxed), n_supp))
+        return;
+
+    if (n_supp)
+        log(lvl, "%u messages suppressed by rate limit\n", n_supp);
+
+    va_list args;
+    va_start(args, format);
+    vlog(lvl, format, args);
+    va_end(args);
+}
+
+//! log to kernel logging facility
+void log_base::vlog(loglevel lvl, const char *format, va_list args) {
+    log_thread& rk_log = robotkernel::kernel::instance.rk_log;
+    struct log_thread::log_record rec;
+
+    rec.ts = kernel_clock::now_ns();
+    rec.lvl = lvl;
+    rec.do_print = !(lvl > ll);
+    rec.fmt = NULL;
+    log_thread::put_prefix(&rec, name, impl);
+
+    va_list ap;
+
+    if (rk_log.binary_logging && !rk_log.sync_logging && 
+            !robotkernel::kernel::instance.flight) {
+        // defer formatting to log thread, records above loglevel are 
+        // still queued because the dump log wants them too. Not used with
+        // flight recorder, queued records would be lost on a crash.
+        va_copy(ap, args);
+        bool packed = log_thread::pack(&rec, format, ap);
+        va_end(ap);
+
+        if (packed) {
+            rk_log.log(&rec);
+            return;
         }
+    }
+
+    // format argument list    
+    int bufpos = rec.len;
+    va_copy(ap, args);
+    bufpos += vsnprintf(rec.buf+bufpos, sizeof(rec.buf)-bufpos, format, ap);
+    va_end(ap);
+
+    rec.len = std::min((size_t)bufpos, sizeof(rec.buf) - 1);
+    rec.size = rec.len + 1;
+
+    log_forward(&rec);
+
+    if (rec.do_print)
+        rk_log.log(&rec);
+}
+
+//! forward formatted record to trace fd, lttng and dump log
+void robotkernel::log_forward(const struct log_thread::log_record *rec) {
+    if (robotkernel::kernel::instance.do_log_to_trace_fd()) {
+        robotkernel::kernel::instance.trace_write(rec);
+    }
 
 #if (HAVE_LTTNG_UST == 1)
-        if (robotkernel::kernel::instance.log_to_lttng_ust) {
-            tracepoint(robotkernel, lttng_log, obj->buf);
-        }
+    if (robotkernel::kernel::instance.log_to_lttng_ust) {
+        tracepoint(robotkernel, lttng_log, rec->buf);
+    }
 #endif
 
-        dump_log(obj->buf);
+    dump_log("%s", rec->buf);
 
-        if (lvl > ll) {
-            robotkernel::kernel::instance.rk_log.return_pool_object(obj);
-        } else {
-            robotkernel::kernel::instance.rk_log.log(obj);
-        }
+    const auto& flight = robotkernel::kernel::instance.flight;
+    if (flight && (rec->lvl.value <= robotkernel::kernel::instance.flight_ll.value)) {
+        flight->append(flight_recorder::type_log, rec->lvl.value,
+                kernel_clock::to_wall_ns(rec->ts),
+                rec->buf, rec->len);
     }
 }
 
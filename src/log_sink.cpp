@@ -0,0 +1,291 @@
+//! robotkernel log sinks
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/config.h"
+#include "robotkernel/helpers.h"
+
+// private headers
+#include "log_sink.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <syslog.h>
+#include <algorithm>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace robotkernel;
+
+static const char ANSI_RESET[]  = "\u001B[0m";
+static const char ANSI_RED[]    = "\u001B[31m";
+static const char ANSI_GREEN[]  = "\u001B[32m";
+static const char ANSI_YELLOW[] = "\u001B[33m";
+
+//! construction with yaml node
+/*!
+ * \param[in] node  Sink configuration, may contain loglevel.
+ */
+log_sink::log_sink(const YAML::Node& node) : ll(verbose) {
+    if (node["loglevel"])
+        ll = get_as<string>(node, "loglevel");
+}
+
+//! construction with loglevel
+/*!
+ * \param[in] ll    Highest level written by this sink.
+ */
+log_sink::log_sink(loglevel ll) : ll(ll) {}
+
+//! create sink from yaml node
+/*!
+ * \param[in] node  Sink configuration with type stdout, file or syslog.
+ * \return created sink
+ */
+sp_log_sink_t log_sink::create(const YAML::Node& node) {
+    string type = get_as<string>(node, "type");
+
+    if (type == "stdout")
+        return make_shared<log_sink_stdout>(node);
+    if (type == "file")
+        return make_shared<log_sink_file>(node);
+    if (type == "syslog" || type == "journald")
+        return make_shared<log_sink_syslog>(node);
+
+    throw runtime_error(string_printf("unknown log sink type \"%s\"", type.c_str()));
+}
+
+//! construction
+/*!
+ * \param[in] node  Sink configuration.
+ * \param[in] fd    Output file descriptor.
+ * \param[in] color Add ANSI colours by level.
+ */
+log_sink_fd::log_sink_fd(const YAML::Node& node, int fd, bool color) :
+    log_sink(node), fd(fd), color(color), batch_len(0), iov_cnt(0)
+{}
+
+//! write pending iovecs to fd
+void log_sink_fd::write_iov() {
+    struct iovec *act = iov;
+    int cnt = iov_cnt;
+
+    while ((fd >= 0) && (cnt > 0)) {
+        ssize_t n = ::writev(fd, act, cnt);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;  // nobody to tell, drop batch
+        }
+
+        // skip completely written iovecs, adjust partially written one
+        while ((cnt > 0) && ((size_t)n >= act->iov_len)) {
+            n -= act->iov_len;
+            act++;
+            cnt--;
+        }
+
+        if (cnt > 0) {
+            act->iov_base = (char *)act->iov_base + n;
+            act->iov_len -= n;
+        }
+    }
+
+    batch_len = 0;
+    iov_cnt   = 0;
+}
+
+//! add formatted line
+/*!
+ * \param[in] lvl       Level of record.
+ * \param[in] line      Formatted line including timestamp, level
+ *                      and newline.
+ * \param[in] len       Length of line.
+ * \param[in] msg_off   Offset of message behind timestamp and level.
+ */
+void log_sink_fd::write(loglevel lvl, const char *line, size_t len, size_t /* msg_off */) {
+    const char *col = NULL;
+
+    if (color) {
+        if (lvl == error)           col = ANSI_RED;
+        else if (lvl == warning)    col = ANSI_YELLOW;
+        else if (lvl == verbose)    col = ANSI_GREEN;
+    }
+
+    len = std::min(len, sizeof(batch));
+    if ((batch_len + len > sizeof(batch)) || (iov_cnt + 3 > max_iov))
+        write_iov();
+
+    if (col) {
+        iov[iov_cnt].iov_base = (void *)col;
+        iov[iov_cnt++].iov_len = strlen(col);
+    }
+
+    char *dst = &batch[batch_len];
+    memcpy(dst, line, len);
+    batch_len += len;
+
+    // extend previous iovec if it ends right here
+    if ((iov_cnt > 0) && ((char *)iov[iov_cnt - 1].iov_base + 
+                iov[iov_cnt - 1].iov_len == dst))
+        iov[iov_cnt - 1].iov_len += len;
+    else {
+        iov[iov_cnt].iov_base = dst;
+        iov[iov_cnt++].iov_len = len;
+    }
+
+    if (col) {
+        iov[iov_cnt].iov_base = (void *)ANSI_RESET;
+        iov[iov_cnt++].iov_len = sizeof(ANSI_RESET) - 1;
+    }
+}
+
+//! write all collected lines
+void log_sink_fd::flush() {
+    if (iov_cnt > 0)
+        write_iov();
+}
+
+//! construction
+/*!
+ * \param[in] node  Sink configuration, may contain color, 
+ *                  defaults to true if stdout is a terminal.
+ */
+log_sink_stdout::log_sink_stdout(const YAML::Node& node) :
+    log_sink_fd(node, STDOUT_FILENO, 
+            get_as<bool>(node, "color", isatty(STDOUT_FILENO) == 1))
+{}
+
+//! construction
+/*!
+ * \param[in] node  Sink configuration with path, optional 
+ *                  max_size [bytes] and max_files.
+ */
+log_sink_file::log_sink_file(const YAML::Node& node) :
+    log_sink_fd(node, -1, get_as<bool>(node, "color", false)), file_size(0)
+{
+    path      = get_as<string>(node, "path");
+    max_size  = get_as<size_t>(node, "max_size", 0);
+    max_files = get_as<unsigned int>(node, "max_files", 5);
+
+    open_file();
+    if (fd < 0)
+        throw runtime_error(string_printf("cannot open log file \"%s\": %s", 
+                    path.c_str(), strerror(errno)));
+}
+
+//! destruction
+log_sink_file::~log_sink_file() {
+    flush();
+
+    if (fd >= 0)
+        close(fd);
+}
+
+//! open log file for appending
+void log_sink_file::open_file() {
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    file_size = 0;
+
+    struct stat st;
+    if ((fd >= 0) && (fstat(fd, &st) == 0))
+        file_size = st.st_size;
+}
+
+//! rotate log files
+void log_sink_file::rotate() {
+    if (fd >= 0)
+        close(fd);
+
+    if (max_files == 0)
+        unlink(path.c_str());
+    else {
+        for (unsigned int i = max_files - 1; i > 0; --i)
+            rename(string_printf("%s.%u", path.c_str(), i).c_str(),
+                    string_printf("%s.%u", path.c_str(), i + 1).c_str());
+
+        rename(path.c_str(), (path + ".1").c_str());
+    }
+
+    open_file();
+}
+
+//! add formatted line
+/*!
+ * \param[in] lvl       Level of record.
+ * \param[in] line      Formatted line including timestamp, level
+ *                      and newline.
+ * \param[in] len       Length of line.
+ * \param[in] msg_off   Offset of message behind timestamp and level.
+ */
+void log_sink_file::write(loglevel lvl, const char *line, size_t len, size_t msg_off) {
+    if (max_size && (file_size > 0) && (file_size + len > max_size)) {
+        write_iov();
+        rotate();
+    }
+
+    log_sink_fd::write(lvl, line, len, msg_off);
+    file_size += len;
+}
+
+//! construction
+/*!
+ * \param[in] node  Sink configuration, may contain ident.
+ */
+log_sink_syslog::log_sink_syslog(const YAML::Node& node) :
+    log_sink(node)
+{
+    ident = get_as<string>(node, "ident", "robotkernel");
+    openlog(ident.c_str(), LOG_PID | LOG_NDELAY, LOG_USER);
+}
+
+//! destruction
+log_sink_syslog::~log_sink_syslog() {
+    closelog();
+}
+
+//! add formatted line
+/*!
+ * \param[in] lvl       Level of record.
+ * \param[in] line      Formatted line including timestamp, level
+ *                      and newline.
+ * \param[in] len       Length of line.
+ * \param[in] msg_off   Offset of message behind timestamp and level.
+ */
+void log_sink_syslog::write(loglevel lvl, const char *line, size_t len, size_t msg_off) {
+    int prio = LOG_INFO;
+
+    if (lvl == error)           prio = LOG_ERR;
+    else if (lvl == warning)    prio = LOG_WARNING;
+    else if (lvl == verbose)    prio = LOG_DEBUG;
+
+    // syslog adds its own timestamp
+    syslog(prio, "%.*s", (int)(len - msg_off), line + msg_off);
+}
+
@@ -0,0 +1,213 @@
+//! robotkernel log sinks
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__LOG_SINK_H
+#define ROBOTKERNEL__LOG_SINK_H
+
+#include <string>
+#include <memory>
+#include <sys/uio.h>
+
+// public headers
+#include "robotkernel/loglevel.h"
+
+#include "yaml-cpp/yaml.h"
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! log sink base class
+/*!
+ * A sink receives formatted log lines from the log thread. Lines are
+ * collected during one wakeup of the log thread and written with as few
+ * system calls as possible when \link flush \endlink is called.
+ */
+class log_sink {
+    private:
+        log_sink(const log_sink&);             // prevent copy-construction
+        log_sink& operator=(const log_sink&);  // prevent assignment
+
+    public:
+        loglevel ll;                //!< highest level written by this sink
+
+        //! construction with yaml node
+        /*!
+         * \param[in] node  Sink configuration, may contain loglevel.
+         */
+        log_sink(const YAML::Node& node);
+
+        //! construction with loglevel
+        /*!
+         * \param[in] ll    Highest level written by this sink.
+         */
+        log_sink(loglevel ll);
+
+        //! destruction
+        virtual ~log_sink() {}
+
+        //! add formatted line
+        /*!
+         * \param[in] lvl       Level of record.
+         * \param[in] line      Formatted line including timestamp, level
+         *                      and newline.
+         * \param[in] len       Length of line.
+         * \param[in] msg_off   Offset of message behind timestamp and level.
+         */
+        virtual void write(loglevel lvl, const char *line, size_t len, 
+                size_t msg_off) = 0;
+
+        //! write all collected lines
+        virtual void flush() = 0;
+
+        //! create sink from yaml node
+        /*!
+         * \param[in] node  Sink configuration with type stdout, file or syslog.
+         * \return created sink
+         */
+        static std::shared_ptr<log_sink> create(const YAML::Node& node);
+};
+
+typedef std::shared_ptr<log_sink> sp_log_sink_t;
+
+//! batching file descriptor sink
+/*!
+ * Lines are copied into a batch buffer and written with one writev call
+ * per flush. Colour escape sequences are passed as separate iovecs 
+ * pointing to constant strings.
+ */
+class log_sink_fd : public log_sink {
+    protected:
+        int fd;                     //!< output file descriptor
+        bool color;                 //!< add ANSI colours by level
+
+        char batch[64 * 1024];      //!< batch buffer
+        size_t batch_len;           //!< used bytes of batch buffer
+
+        static const int max_iov = 256;
+        struct iovec iov[max_iov];  //!< pending iovecs
+        int iov_cnt;                //!< used iovecs
+
+        //! write pending iovecs to fd
+        void write_iov();
+
+    public:
+        //! construction
+        /*!
+         * \param[in] node  Sink configuration.
+         * \param[in] fd    Output file descriptor.
+         * \param[in] color Add ANSI colours by level.
+         */
+        log_sink_fd(const YAML::Node& node, int fd, bool color);
+
+        //! add formatted line
+        void write(loglevel lvl, const char *line, size_t len, 
+                size_t msg_off) override;
+
+        //! write all collected lines
+        void flush() override;
+};
+
+//! stdout sink
+class log_sink_stdout : public log_sink_fd {
+    public:
+        //! construction
+        /*!
+         * \param[in] node  Sink configuration, may contain color, 
+         *                  defaults to true if stdout is a terminal.
+         */
+        log_sink_stdout(const YAML::Node& node = YAML::Node());
+};
+
+//! rotating file sink
+/*!
+ * If the file would exceed max_size it is renamed to path.1, older files
+ * are shifted up to path.<max_files>.
+ */
+class log_sink_file : public log_sink_fd {
+    private:
+        std::string path;           //!< log file path
+        size_t max_size;            //!< rotate if file exceeds size, 0 never
+        unsigned int max_files;     //!< number of rotated files kept
+        size_t file_size;           //!< current file size
+
+        //! open log file for appending
+        void open_file();
+
+        //! rotate log files
+        void rotate();
+
+    public:
+        //! construction
+        /*!
+         * \param[in] node  Sink configuration with path, optional 
+         *                  max_size [bytes] and max_files.
+         */
+        log_sink_file(const YAML::Node& node);
+
+        //! destruction
+        ~log_sink_file();
+
+        //! add formatted line
+        void write(loglevel lvl, const char *line, size_t len, 
+                size_t msg_off) override;
+};
+
+//! syslog sink
+/*!
+ * Lines are passed to syslog(3), journald picks them up from there. The
+ * level of the record is mapped to the syslog priority.
+ */
+class log_sink_syslog : public log_sink {
+    private:
+        std::string ident;          //!< syslog ident, has to stay valid
+
+    public:
+        //! construction
+        /*!
+         * \param[in] node  Sink configuration, may contain ident.
+         */
+        log_sink_syslog(const YAML::Node& node);
+
+        //! destruction
+        ~log_sink_syslog();
+
+        //! add formatted line
+        void write(loglevel lvl, const char *line, size_t len, 
+                size_t msg_off) override;
+
+        //! write all collected lines
+        void flush() override {}
+};
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__LOG_SINK_H
+
@@ -26,13 +26,16 @@
 
 // public headers
 #include "robotkernel/config.h"
+#include "robotkernel/kernel_clock.h"
 
 // private headers
 #include "log_thread.h"
 #include "kernel.h"
 
 #include <unistd.h>
+#include <stddef.h>
 #include <string.h>
+#include <algorithm>
 #ifdef HAVE_SYS_SYSCALL_H
 #include <sys/syscall.h>
 #endif
@@ -56,186 +59,624 @@ int _gettid() {
 
 //! de-/construction
 /*!
- * \param size number of buffers in pool
+ * \param arena_size size of record arena in bytes, rounded up to 
+ *                   a power of two
  */
-log_thread::log_thread(int pool_size) : 
-    runnable(0, 0, "log_thread") 
+log_thread::log_thread(size_t arena_size) : 
+    runnable(0, 0, "log_thread"), write_pos(0), read_pos(0), producers(0), 
+    resizing(false), dropped(0), high_water(0), dropped_reported(0), 
+    wakeup_pending(false)
 {
     sync_logging = false;
+    binary_logging = false;
+    fix_modname_length = 20;
 
-    int i;
-    for (i = 0; i < pool_size; ++i) {
-        struct log_pool_object *obj = new struct log_pool_object;
-        obj->len = 1024;
-        empty_pool.push_back(obj);                
-    }
+    alloc_arena(arena_size);
+    sinks.push_back(std::make_shared<log_sink_stdout>());
+    sem_init(&wakeup, 0, 0);
+}
 
-    fix_modname_length = 20;
+//! replace log sinks
+/*!
+ * \param new_sinks sinks to write records to
+ */
+void log_thread::set_sinks(const std::vector<sp_log_sink_t>& new_sinks) {
+    std::unique_lock<std::mutex> lock(sinks_mtx);
+
+    for (const auto& sink : sinks)
+        sink->flush();
+
+    sinks = new_sinks;
 }
 
 //! destruction, do clean ups
 log_thread::~log_thread() {
     // stop thread
     run_flag = false; // give thread chance to exit voluntarily, without timeout
-    cond.notify_all();
+    sem_post(&wakeup);
     tid.join();
 
-    // clean up pools
-    while (!full_pool.empty()) {
-        struct log_pool_object *obj = full_pool.front();
-        full_pool.pop_front();
-        printf("%s", obj->buf);
-        delete obj;
-    }
-    while (!empty_pool.empty()) {
-        struct log_pool_object *obj = empty_pool.front();
-        empty_pool.pop_front();
-        delete obj;
+    // print remaining records
+    struct log_record rec;
+    while (pop(rec)) {
+        if (rec.fmt)
+            format(&rec);
+        if (rec.do_print)
+            print(&rec);
     }
+
+    for (const auto& sink : sinks)
+        sink->flush();
+
+    sem_destroy(&wakeup);
 }
 
-//! get empty object from log pool
+//! allocate empty arena
+void log_thread::alloc_arena(size_t size) {
+    // at least one maximum sized record has to fit
+    size_t min_size = sizeof(chunk_header) + sizeof(log_record);
+    if (size < min_size)
+        size = min_size;
+
+    arena_size = 1;
+    while (arena_size < size)
+        arena_size <<= 1;
+
+    arena_mask = arena_size - 1;
+    arena.reset(new uint64_t[arena_size / sizeof(uint64_t)]());
+
+    write_pos.store(0, std::memory_order_relaxed);
+    read_pos.store(0, std::memory_order_relaxed);
+    high_water.store(0, std::memory_order_relaxed);
+}
+
+//! change size of record arena
 /*!
- * \return empty pool object
+ * Drains all queued records and reallocates the arena. Waits until no 
+ * producer is inside the arena, records logged meanwhile are dropped 
+ * and counted.
+ *
+ * \param arena_size size of record arena in bytes, rounded up to 
+ *                   a power of two
  */
-struct log_thread::log_pool_object *log_thread::get_pool_object() {
-    std::unique_lock<std::mutex> lock(mtx);
-    
-    if (empty_pool.empty())
-        return NULL;
+void log_thread::set_arena_size(size_t arena_size) {
+    // keep producers out first, the log thread drains until the arena is empty
+    resizing.store(true, std::memory_order_seq_cst);
+    while (producers.load(std::memory_order_seq_cst))
+        std::this_thread::yield();
+
+    bool was_running = running();
+
+    if (was_running) {
+        run_flag = false;
+        sem_post(&wakeup);
+        tid.join();
+    }
 
-    log_thread::log_pool_object *obj = empty_pool.front();
-    empty_pool.pop_front();
+    drain();
+    alloc_arena(arena_size);
 
-    clock_gettime(CLOCK_REALTIME, &obj->ts);
-    return obj;
-}
+    resizing.store(false, std::memory_order_release);
 
-static bool log_thread_value = false;
+    if (was_running)
+        start();
+}
 
-//! log object to stdout and return to pool
+//! queue record to log thread
 /*!
- * \param obj object to print and to be returned to pool
+ * Copies the used part of the record into the arena, in sync mode 
+ * the record is printed directly.
+ *
+ * \param rec record to queue
  */
-void log_thread::log(struct log_pool_object *obj) {
-    std::unique_lock<std::mutex> lock(mtx);
-    
+void log_thread::log(const struct log_record *rec) {
     if(sync_logging) {
-        printf("%s", obj->buf);
-        empty_pool.push_back(obj);
-    } else {
-        full_pool.push_back(obj);
-
-        if (!log_thread_value) {
-            log_thread_value = true;
-            cond.notify_all();
+        std::unique_lock<std::mutex> lock(sinks_mtx);
+        print(const_cast<struct log_record *>(rec));
+        for (const auto& sink : sinks)
+            sink->flush();
+        return;
+    }
+
+    // set_arena_size waits for producers announced here
+    producers.fetch_add(1, std::memory_order_seq_cst);
+
+    if (!resizing.load(std::memory_order_seq_cst))
+        push(rec);
+    else
+        dropped.fetch_add(1, std::memory_order_relaxed);
+
+    producers.fetch_sub(1, std::memory_order_release);
+}
+
+//! copy record into arena and wake log thread
+/*!
+ * \param rec record to queue
+ */
+void log_thread::push(const struct log_record *rec) {
+    size_t rec_size = offsetof(log_record, buf) + rec->size;
+    uint64_t need = (sizeof(chunk_header) + rec_size + 7) & ~7ull;
+    uint64_t pos = write_pos.load(std::memory_order_relaxed);
+    uint64_t off, tail, total, used;
+
+    while (true) {
+        // chunks never wrap, the rest of the arena is skipped by padding
+        off   = pos & arena_mask;
+        tail  = arena_size - off;
+        total = (tail < need) ? tail + need : need;
+        used  = pos + total - read_pos.load(std::memory_order_acquire);
+
+        if (used > arena_size) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
         }
+
+        if (write_pos.compare_exchange_weak(pos, pos + total, 
+                    std::memory_order_relaxed, std::memory_order_relaxed))
+            break;
     }
+
+    uint64_t hw = high_water.load(std::memory_order_relaxed);
+    while ((used > hw) && !high_water.compare_exchange_weak(hw, used, 
+                std::memory_order_relaxed));
+
+    char *base = (char *)arena.get();
+
+    if (tail < need) {
+        chunk_header *pad = (chunk_header *)&base[off];
+        pad->state.store(tail | chunk_pad, std::memory_order_release);
+        off = 0;
+    }
+
+    chunk_header *hdr = (chunk_header *)&base[off];
+    memcpy(&base[off + sizeof(chunk_header)], rec, rec_size);
+    hdr->state.store(need, std::memory_order_release);
+
+    // sem_post does not block and is only called once per wakeup
+    if (!wakeup_pending.exchange(true, std::memory_order_acq_rel))
+        sem_post(&wakeup);
 }
 
-const static std::string ANSI_RESET = "\u001B[0m";
-const static std::string ANSI_BLACK = "\u001B[30m";
-const static std::string ANSI_RED = "\u001B[31m";
-const static std::string ANSI_GREEN = "\u001B[32m";
-const static std::string ANSI_YELLOW = "\u001B[33m";
-const static std::string ANSI_BLUE = "\u001B[34m";
-const static std::string ANSI_PURPLE = "\u001B[35m";
-const static std::string ANSI_CYAN = "\u001B[36m";
-const static std::string ANSI_WHITE = "\u001B[37m";
+//! copy next committed record out of arena and release its chunk
+/*!
+ * \param rec   Record to fill.
+ * \return false if no committed record is available
+ */
+bool log_thread::pop(struct log_record& rec) {
+    char *base = (char *)arena.get();
+    uint64_t pos = read_pos.load(std::memory_order_relaxed);
 
-//! handler function called if thread is running
-void log_thread::run() {
-    set_name("rk:log_thread");
-    kernel::instance.log(verbose, "log_thread started at tid %d\n", _gettid());
-    char tmp_buf[2*1024];
+    while (pos != write_pos.load(std::memory_order_acquire)) {
+        uint64_t off = pos & arena_mask;
+        chunk_header *hdr = (chunk_header *)&base[off];
+        uint32_t state = hdr->state.load(std::memory_order_acquire);
 
-    std::unique_lock<std::mutex> lock(mtx);
-    
-    while (running()) {
-        // wait for trigger, this will unlock mutex
-        // other threads can now safely add/remove something from _modules
-        if (!log_thread_value) {
-            if (cond.wait_for(lock, std::chrono::seconds(1)) == std::cv_status::timeout) {
-                continue;
+        if (state == 0)
+            return false;   // reserved but not yet committed
+
+        uint32_t chunk_size = state & ~chunk_pad;
+
+        if (!(state & chunk_pad))
+            memcpy((void *)&rec, &base[off + sizeof(chunk_header)], 
+                    std::min((size_t)chunk_size - sizeof(chunk_header), sizeof(rec)));
+
+        // producers rely on cleared chunks, header reads 0 until committed
+        memset(&base[off], 0, chunk_size);
+        pos += chunk_size;
+        read_pos.store(pos, std::memory_order_release);
+
+        if (!(state & chunk_pad))
+            return true;
+    }
+
+    return false;
+}
+
+//! wait until all queued records are processed
+void log_thread::flush() {
+    if (!running() || sync_logging)
+        return;
+
+    uint64_t target = write_pos.load(std::memory_order_acquire);
+
+    if (!wakeup_pending.exchange(true, std::memory_order_acq_rel))
+        sem_post(&wakeup);
+
+    // bounded wait, the log thread may be blocked on a slow terminal
+    for (int i = 0; (i < 1000) && (read_pos.load(std::memory_order_acquire) < target); ++i)
+        usleep(1000);
+}
+
+//! write record prefix "[name|impl] "
+/*!
+ * \param rec   Log record, len and size are set to prefix length.
+ * \param name  Module name.
+ * \param impl  Implementation name.
+ */
+void log_thread::put_prefix(struct log_record *rec, 
+        const std::string& name, const std::string& impl) {
+    // names are clipped to keep room for the message
+    size_t name_len = std::min(name.size(), sizeof(rec->buf) / 4);
+    size_t impl_len = std::min(impl.size(), sizeof(rec->buf) / 4);
+    char *pos = rec->buf;
+
+    *pos++ = '[';
+    memcpy(pos, name.c_str(), name_len); pos += name_len;
+    *pos++ = '|';
+    memcpy(pos, impl.c_str(), impl_len); pos += impl_len;
+    *pos++ = ']';
+    *pos++ = ' ';
+    *pos   = '\0';
+
+    rec->len  = pos - rec->buf;
+    rec->size = rec->len + 1;
+}
+
+//! printf conversion specification
+struct conv_spec {
+    const char *start;      //!< points to '%'
+    const char *end;        //!< one past conversion character
+    int stars;              //!< number of '*' width/precision arguments
+    int precision;          //!< precision, -1 if none, -2 if given by '*'
+    char length[3];         //!< length modifier
+    char conv;              //!< conversion character
+};
+
+//! find next conversion specification
+/*!
+ * \param p     Position in format string.
+ * \param c     Parsed specification.
+ * \return 1 if found, 0 at end of format, -1 if malformed.
+ */
+static int next_conv(const char *p, conv_spec& c) {
+    if ((p = strchr(p, '%')) == NULL)
+        return 0;
+
+    c.start = p++;
+    c.stars = 0;
+    c.precision = -1;
+
+    while ((*p != '\0') && (strchr("-+ #0'", *p) != NULL))
+        p++;
+
+    if (*p == '*') { c.stars++; p++; } 
+    else while ((*p >= '0') && (*p <= '9')) p++;
+
+    if (*p == '.') {
+        p++;
+        if (*p == '*') { c.stars++; c.precision = -2; p++; }
+        else {
+            c.precision = 0;
+            while ((*p >= '0') && (*p <= '9')) 
+                c.precision = (c.precision * 10) + (*p++ - '0');
+        }
+    }
+
+    int l = 0;
+    while ((l < 2) && (*p != '\0') && (strchr("hlLqjzt", *p) != NULL))
+        c.length[l++] = *p++;
+    c.length[l] = '\0';
+
+    if (*p == '\0')
+        return -1;
+
+    c.conv = *p;
+    c.end  = p + 1;
+    return 1;
+}
+
+#define PACK(type, val) {                                       \
+    type v = (val);                                             \
+    if ((size_t)(end - pos) < sizeof(v))                        \
+        return false;                                           \
+    memcpy(pos, &v, sizeof(v)); pos += sizeof(v); }
+
+#define PACK_INT(stype, sgn) {                                       \
+    if      (!strcmp(c.length, "hh")) PACK(stype, sgn ? (stype)(signed char)va_arg(ap, int)   : (stype)(unsigned char)va_arg(ap, int))    \
+    else if (!strcmp(c.length, "h"))  PACK(stype, sgn ? (stype)(short)va_arg(ap, int)         : (stype)(unsigned short)va_arg(ap, int))   \
+    else if (!strcmp(c.length, "l"))  PACK(stype, sgn ? (stype)va_arg(ap, long)               : (stype)va_arg(ap, unsigned long))         \
+    else if (!strcmp(c.length, "j"))  PACK(stype, sgn ? (stype)va_arg(ap, intmax_t)           : (stype)va_arg(ap, uintmax_t))             \
+    else if (!strcmp(c.length, "z"))  PACK(stype, sgn ? (stype)va_arg(ap, ssize_t)            : (stype)va_arg(ap, size_t))                \
+    else if (!strcmp(c.length, "t"))  PACK(stype, (stype)va_arg(ap, ptrdiff_t))                                                        \
+    else if (c.length[0] == '\0')     PACK(stype, sgn ? (stype)va_arg(ap, int)                : (stype)va_arg(ap, unsigned int))          \
+    else                              PACK(stype, sgn ? (stype)va_arg(ap, long long)          : (stype)va_arg(ap, unsigned long long)) }
+
+//! pack raw format arguments behind prefix
+/*!
+ * \param rec   Log record with prefix.
+ * \param fmt   printf format string.
+ * \param ap    Format arguments.
+ * \return false if the record has to be formatted directly.
+ */
+bool log_thread::pack(struct log_record *rec, const char *fmt, va_list ap) {
+    char *pos = rec->buf + rec->len, *end = rec->buf + sizeof(rec->buf);
+    const char *p = fmt;
+    conv_spec c;
+    int ret, star = 0;
+
+    while ((ret = next_conv(p, c)) == 1) {
+        p = c.end;
+
+        for (int i = 0; i < c.stars; ++i) {
+            star = va_arg(ap, int);
+            PACK(int, star);
+        }
+
+        switch (c.conv) {
+            case '%':
+                break;
+            case 'd': case 'i':
+                PACK_INT(long long, true);
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                PACK_INT(unsigned long long, false);
+                break;
+            case 'c':
+                if (c.length[0] != '\0')
+                    return false;
+                PACK(int, va_arg(ap, int));
+                break;
+            case 'e': case 'E': case 'f': case 'F': 
+            case 'g': case 'G': case 'a': case 'A':
+                if (!strcmp(c.length, "L"))
+                    PACK(long double, va_arg(ap, long double))
+                else
+                    PACK(double, va_arg(ap, double))
+                break;
+            case 'p':
+                PACK(void *, va_arg(ap, void *));
+                break;
+            case 's': {
+                if (c.length[0] != '\0')
+                    return false;
+
+                const char *str = va_arg(ap, const char *);
+                if (!str)
+                    str = "(null)";
+
+                // copy string, truncated if it does not fit
+                if (pos >= end)
+                    return false;
+
+                // never read behind precision, string may not be terminated
+                size_t max = end - pos - 1;
+                if ((c.precision >= 0) && ((size_t)c.precision < max))
+                    max = c.precision;
+                else if ((c.precision == -2) && (star >= 0) && ((size_t)star < max))
+                    max = star;
+
+                size_t n = strnlen(str, max);
+                memcpy(pos, str, n);
+                pos[n] = '\0';
+                pos += n + 1;
+                break;
             }
+            default:
+                // %n, %m, positional arguments, ...
+                return false;
         }
+    }
 
-        log_thread_value = false;
+    if (ret < 0)
+        return false;
+
+    rec->fmt  = fmt;
+    rec->size = pos - rec->buf;
+    return true;
+}
 
-        while (!full_pool.empty()) {
-            struct log_pool_object *obj = full_pool.front();
-            full_pool.pop_front();
-            lock.unlock();
+#define UNPACK(type, var)                                       \
+    type var; memcpy(&var, rd, sizeof(var)); rd += sizeof(var);
 
-            struct tm timeinfo;
-            double timestamp = (double)obj->ts.tv_sec + (obj->ts.tv_nsec / 1e9);
-            time_t seconds = (time_t)timestamp;
-            int mseconds = (timestamp - (double)seconds) * 1000;
-            localtime_r(&seconds, &timeinfo);
-            strftime(&tmp_buf[0], sizeof(tmp_buf), "%F %T", &timeinfo);
+#define EMIT(val) {                                                                 \
+    size_t rem = sizeof(out) - o;                                                   \
+    int n;                                                                          \
+    if (c.stars == 0)      n = snprintf(&out[o], rem, spec, val);                   \
+    else if (c.stars == 1) n = snprintf(&out[o], rem, spec, star[0], val);          \
+    else                   n = snprintf(&out[o], rem, spec, star[0], star[1], val); \
+    if (n > 0) o += std::min((size_t)n, rem - 1); }
 
+//! format packed record to text
+/*!
+ * \param rec   Log record packed with \link pack \endlink.
+ */
+void log_thread::format(struct log_record *rec) {
+    char out[sizeof(rec->buf)];
+    size_t o = rec->len;
+    const char *rd = rec->buf + rec->len;
+    const char *p = rec->fmt;
+    conv_spec c;
+
+    memcpy(out, rec->buf, rec->len);
+
+    while (next_conv(p, c) == 1) {
+        size_t lit = std::min((size_t)(c.start - p), sizeof(out) - 1 - o);
+        memcpy(&out[o], p, lit);
+        o += lit;
+        p = c.end;
+
+        if (c.conv == '%') {
+            if (o < sizeof(out) - 1)
+                out[o++] = '%';
+            continue;
+        }
 
-            int len = strlen(&tmp_buf[0]);
-            snprintf(&tmp_buf[len], sizeof(tmp_buf) - len, ".%03d ", mseconds);
-            len = strlen(&tmp_buf[0]);
-            snprintf(&tmp_buf[len], sizeof(tmp_buf) - len, "%s %s", 
-                    kernel::instance.ll_to_string(obj->lvl).c_str(), obj->buf);
+        int star[2] = { 0, 0 };
+        for (int i = 0; i < c.stars; ++i) {
+            UNPACK(int, s);
+            star[i] = s;
+        }
 
-            char* have_error = strstr(&tmp_buf[0], "ERR");
-            if (have_error) {
-                printf("%s", ANSI_RED.c_str());
+        // rebuild specification with length modifier of packed type
+        char spec[64];
+        size_t spec_len = (c.end - 1 - strlen(c.length)) - c.start;
+        if (spec_len > sizeof(spec) - 4)
+            spec_len = sizeof(spec) - 4;
+        memcpy(spec, c.start, spec_len);
+
+        switch (c.conv) {
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': {
+                snprintf(&spec[spec_len], 4, "ll%c", c.conv);
+                UNPACK(long long, v);
+                EMIT(v);
+                break;
+            }
+            case 'e': case 'E': case 'f': case 'F': 
+            case 'g': case 'G': case 'a': case 'A':
+                if (!strcmp(c.length, "L")) {
+                    snprintf(&spec[spec_len], 4, "L%c", c.conv);
+                    UNPACK(long double, v);
+                    EMIT(v);
+                } else {
+                    snprintf(&spec[spec_len], 4, "%c", c.conv);
+                    UNPACK(double, v);
+                    EMIT(v);
+                }
+                break;
+            case 'c': {
+                snprintf(&spec[spec_len], 4, "%c", c.conv);
+                UNPACK(int, v);
+                EMIT(v);
+                break;
             }
-            
-            char* have_warning = strstr(&tmp_buf[0], "WARN");
-            if (have_warning) {
-                printf("%s", ANSI_YELLOW.c_str());
+            case 'p': {
+                snprintf(&spec[spec_len], 4, "%c", c.conv);
+                UNPACK(void *, v);
+                EMIT(v);
+                break;
             }
-
-            char* have_verbose = strstr(&tmp_buf[0], "VERB");
-            if (have_verbose) {
-                printf("%s", ANSI_GREEN.c_str());
+            case 's': {
+                snprintf(&spec[spec_len], 4, "%c", c.conv);
+                const char *v = rd;
+                rd += strlen(rd) + 1;
+                EMIT(v);
+                break;
             }
+        }
+    }
 
-            if(fix_modname_length == 0)
-                printf("%s", &tmp_buf[0]);
-            else {
-                char* open = strchr(&tmp_buf[0], '[');
-                char* close = NULL;
-
-                if(open)
-                    close = strchr(open, ']');
-
-                if(close) {
-                    unsigned int len = close - open;
-                    if(len == fix_modname_length + 1)
-                        close = NULL;
-                    else if(len <= fix_modname_length) {
-                        // insert padding
-                        printf("%-*.*s%-*.*s%s", (int)(close - &tmp_buf[0]), 
-                                (int)(close - &tmp_buf[0]), &tmp_buf[0], 
-                                fix_modname_length + 1 - len, 
-                                fix_modname_length + 1 - len, "", close);
-                    } else {
-                        // truncate
-                        printf("%-*.*s%s",
-                                (int)((open + fix_modname_length + 1) - &tmp_buf[0]), 
-                                (int)((open + fix_modname_length + 1) - &tmp_buf[0]), 
-                                &tmp_buf[0], close);
-                    }
-                }
+    size_t lit = std::min(strlen(p), sizeof(out) - 1 - o);
+    memcpy(&out[o], p, lit);
+    o += lit;
+    out[o] = '\0';
 
-                if(!close)
-                    // missing closing bracket or length already ok
-                    printf("%s", &tmp_buf[0]);
+    memcpy(rec->buf, out, o + 1);
+    rec->len  = o;
+    rec->size = o + 1;
+    rec->fmt  = NULL;
+}
 
-                if (have_error || have_warning || have_verbose) {
-                    printf("%s", ANSI_RESET.c_str());
-                }
+//! return fixed width level string
+static const char *level_string(loglevel lvl) {
+    if (lvl == error)    return "ERR ";
+    if (lvl == warning)  return "WARN";
+    if (lvl == info)     return "INFO";
+    if (lvl == verbose)  return "VERB";
+
+    return "????";
+}
+
+//! format output line of record
+/*!
+ * \param rec       Formatted record.
+ * \param line      Output buffer.
+ * \param size      Size of output buffer.
+ * \param msg_off   Returns offset of message behind timestamp and level.
+ * \return length of line
+ */
+size_t log_thread::format_line(const struct log_record *rec, char *line, 
+        size_t size, size_t& msg_off) {
+    struct tm timeinfo;
+    uint64_t wall = kernel_clock::to_wall_ns(rec->ts);
+    time_t seconds = wall / 1000000000ull;
+    localtime_r(&seconds, &timeinfo);
+
+    size_t len = strftime(line, size, "%F %T", &timeinfo);
+    len += snprintf(&line[len], size - len, ".%03d %s ", 
+            (int)((wall % 1000000000ull) / 1000000), level_string(rec->lvl));
+    msg_off = len;
+
+    const char *msg = rec->buf;
+    const char *close = NULL;
+
+    if ((fix_modname_length != 0) && (msg[0] == '['))
+        close = strchr(msg, ']');
+
+    if (close) {
+        // pad or truncate "[name|impl" to fixed length
+        int width = fix_modname_length + 1;
+        len += snprintf(&line[len], size - len, "%-*.*s%s", width,
+                std::min((int)(close - msg), width), msg, close);
+    } else
+        len += snprintf(&line[len], size - len, "%s", msg);
+
+    return std::min(len, size - 1);
+}
+
+//! print record to all sinks
+void log_thread::print(struct log_record *rec) {
+    char line[2*1024];
+    size_t msg_off;
+    size_t len = format_line(rec, line, sizeof(line), msg_off);
+
+    for (const auto& sink : sinks)
+        if (!(rec->lvl > sink->ll))
+            sink->write(rec->lvl, line, len, msg_off);
+}
+
+//! print all queued records
+void log_thread::drain() {
+    struct log_record rec;
+
+    {
+        std::unique_lock<std::mutex> lock(sinks_mtx);
+
+        while (pop(rec)) {
+            if (rec.fmt) {
+                format(&rec);
+                log_forward(&rec);
             }
 
-            lock.lock();
-            empty_pool.push_back(obj);
+            if (rec.do_print)
+                print(&rec);
         }
+
+        // one batch per wakeup
+        for (const auto& sink : sinks)
+            sink->flush();
+    }
+
+    uint64_t act_dropped = dropped.load(std::memory_order_relaxed);
+    if (act_dropped != dropped_reported) {
+        RK_LOG(kernel::instance, warning, "[log_thread] log arena full (%llu of %llu bytes "
+                "used at most), dropped %llu records\n",
+                (unsigned long long)high_water.load(std::memory_order_relaxed),
+                (unsigned long long)arena_size,
+                (unsigned long long)(act_dropped - dropped_reported));
+        dropped_reported = act_dropped;
     }
 }
 
+//! handler function called if thread is running
+void log_thread::run() {
+    set_name("rk:log_thread");
+    kernel::instance.log(verbose, "log_thread started at tid %d\n", _gettid());
+
+    while (running()) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += 1;
+
+        if (sem_timedwait(&wakeup, &ts) != 0) {
+            // idle, follow wall clock adjustments
+            kernel_clock::resync_wall();
+            continue;
+        }
+
+        // reset before draining, later records post again
+        wakeup_pending.store(false, std::memory_order_release);
+        drain();
+    }
+
+    drain();
+}
@@ -29,9 +29,14 @@
 
 #include <string>
 #include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <vector>
 #include "robotkernel/runnable.h"
 #include "robotkernel/loglevel.h"
+#include "log_sink.h"
 
 #ifdef __VXWORKS__
 #undef log
@@ -42,59 +47,186 @@ namespace robotkernel {
 }
 #endif
 
-//! logging thread with pool
+//! logging thread with record arena
+/*!
+ * Log records are copied into a byte ring arena as variable-length chunks,
+ * so a short message only occupies the bytes it needs. Producers reserve
+ * space with a single compare-and-swap on the write position, the log 
+ * thread consumes chunks in reservation order and clears them before
+ * releasing the space. Queueing a record never blocks and never allocates,
+ * if the arena is full the record is dropped and counted.
+ */
 class log_thread : public runnable {
     private:
         log_thread(const log_thread&);             // prevent copy-construction
         log_thread& operator=(const log_thread&);  // prevent assignment
 
     public:
-        struct log_pool_object {
-            char buf[1024];
-            size_t len;
-            struct timespec ts;
+        //! log record, filled by producer on its own stack
+        struct log_record {
+            uint64_t ts;                        //!< kernel_clock timestamp [ns]
             loglevel lvl;
+            bool do_print;                      //!< print record, otherwise only forward it
+            uint32_t size;                      //!< bytes used in buf, including packed arguments
+            size_t len;                         //!< text length, prefix length of packed record
+            const char *fmt;                    //!< format of packed record, NULL if buf holds text
+            char buf[1024];
         };
     
         unsigned int fix_modname_length;
         bool sync_logging;
+        bool binary_logging;                    //!< defer formatting to log thread
 
         //! de-/construction
         /*!
-         * \param size number of buffers in pool
+         * \param arena_size size of record arena in bytes, rounded up to 
+         *                   a power of two
          */
-        log_thread(int pool_size = 100000);
+        log_thread(size_t arena_size = default_arena_size);
         ~log_thread();
 
-        //! get empty object from log pool
+        //! change size of record arena
+        /*!
+         * Drains all queued records and reallocates the arena. Waits until no 
+         * producer is inside the arena, records logged meanwhile are dropped 
+         * and counted.
+         *
+         * \param arena_size size of record arena in bytes, rounded up to 
+         *                   a power of two
+         */
+        void set_arena_size(size_t arena_size);
+
+        //! replace log sinks
+        /*!
+         * \param new_sinks sinks to write records to
+         */
+        void set_sinks(const std::vector<sp_log_sink_t>& new_sinks);
+
+        //! queue record to log thread
         /*!
-         * \return empty pool object
+         * Copies the used part of the record into the arena, in sync mode 
+         * the record is printed directly.
+         *
+         * \param rec record to queue
          */
-        struct log_pool_object *get_pool_object();
+        void log(const struct log_record *rec);
 
-        void return_pool_object(struct log_pool_object *obj) {
-            empty_pool.push_back(obj);
-        }
+        //! write record prefix "[name|impl] "
+        /*!
+         * \param rec   Log record, len and size are set to prefix length.
+         * \param name  Module name.
+         * \param impl  Implementation name.
+         */
+        static void put_prefix(struct log_record *rec, 
+                const std::string& name, const std::string& impl);
+
+        //! pack raw format arguments behind prefix
+        /*!
+         * Stores the format pointer and the argument values, strings are 
+         * copied. Formatting is done later by \link format \endlink.
+         *
+         * \param rec   Log record with prefix.
+         * \param fmt   printf format string, has to stay valid until the
+         *              record is formatted (see \link flush \endlink).
+         * \param ap    Format arguments.
+         * \return false if the format is not supported or the arguments 
+         *         do not fit, the record has to be formatted directly then.
+         */
+        static bool pack(struct log_record *rec, const char *fmt, va_list ap);
+
+        //! format packed record to text
+        /*!
+         * \param rec   Log record packed with \link pack \endlink.
+         */
+        static void format(struct log_record *rec);
 
-        //! log object to stdout and return to pool
+        //! wait until all queued records are processed
         /*!
-         * \param obj object to print and to be returned to pool
+         * Has to be called before format strings become invalid, e.g.
+         * before a module is unloaded.
          */
-        void log(struct log_pool_object *obj);
+        void flush();
 
         //! handler function called if thread is running
         void run();
 
+        //! return number of records dropped because the arena was full
+        uint64_t get_dropped() const { return dropped; }
+
+        //! return arena size in bytes
+        size_t get_arena_size() const { return arena_size; }
+
+        //! return maximum number of arena bytes in use
+        size_t get_high_water_mark() const { return high_water; }
+
+        static const size_t default_arena_size = 16 * 1024 * 1024;
+
     private:
-        // sync objects
-        std::condition_variable cond;
-        std::mutex              mtx;
+        static const uint32_t chunk_pad = 0x80000000;   //!< chunk is wrap-around padding
+
+        //! header in front of each arena chunk, 0 until committed
+        struct chunk_header {
+            std::atomic<uint32_t> state;                //!< chunk size | chunk_pad
+            uint32_t reserved;
+        };
+
+        //! format output line of record
+        /*!
+         * \param rec       Formatted record.
+         * \param line      Output buffer.
+         * \param size      Size of output buffer.
+         * \param msg_off   Returns offset of message behind timestamp and level.
+         * \return length of line
+         */
+        size_t format_line(const struct log_record *rec, char *line, 
+                size_t size, size_t& msg_off);
 
-        // log pools
-        std::list<struct log_pool_object *> empty_pool;
-        std::list<struct log_pool_object *> full_pool;
+        //! print record to all sinks
+        void print(struct log_record *rec);
+
+        //! copy next committed record out of arena and release its chunk
+        /*!
+         * \param rec   Record to fill.
+         * \return false if no committed record is available
+         */
+        bool pop(struct log_record& rec);
+
+        //! print all queued records
+        void drain();
+
+        //! copy record into arena and wake log thread
+        /*!
+         * \param rec record to queue
+         */
+        void push(const struct log_record *rec);
+
+        //! allocate empty arena
+        void alloc_arena(size_t size);
+
+        // record arena
+        size_t arena_size;
+        size_t arena_mask;
+        std::unique_ptr<uint64_t[]> arena;              //!< 8 byte aligned storage
+        alignas(64) std::atomic<uint64_t> write_pos;    //!< reserved bytes
+        alignas(64) std::atomic<uint64_t> read_pos;     //!< released bytes
+        alignas(64) std::atomic<uint32_t> producers;    //!< producers inside log()
+        std::atomic<bool> resizing;                     //!< set_arena_size in progress
+
+        alignas(64) std::atomic<uint64_t> dropped;      //!< records dropped
+        std::atomic<uint64_t> high_water;               //!< max bytes in use
+        uint64_t dropped_reported;                      //!< dropped count already reported
+
+        // log thread wakeup
+        std::atomic<bool> wakeup_pending;
+        sem_t wakeup;
+
+        std::vector<sp_log_sink_t> sinks;               //!< output sinks
+        std::mutex sinks_mtx;                           //!< protects sinks, serializes sync logging
 };
 
+//! forward formatted record to trace fd, lttng and dump log
+void log_forward(const struct log_thread::log_record *rec);
+
 #ifdef EMACS
 {
 #endif
@@ -28,6 +28,7 @@
 #include "robotkernel/exceptions.h"
 #include "robotkernel/helpers.h"
 #include "robotkernel/service_definitions.h"
+#include "robotkernel/local_service.h"
 
 // private headers 
 #include "kernel.h"
@@ -221,6 +222,11 @@ module::module(const YAML::Node& node)
     kernel::instance.add_service(name, "get_config",
             service_definition_get_config,
             std::bind(&module::service_get_config, this, _1, _2));
+
+    // typed handlers for in-process callers, e.g. a supervisor
+    add_local_handler(name, "set_state", this, &svc_base_set_state::svc_set_state);
+    add_local_handler(name, "get_state", this, &svc_base_get_state::svc_get_state);
+    add_local_handler(name, "get_config", this, &svc_base_get_config::svc_get_config);
 }
         
 void module::_init() {
@@ -419,26 +425,41 @@ module_state_t module::get_state() {
  */
 int module::service_set_state(const service_arglist_t& request, 
         service_arglist_t& response) {
+    services::robotkernel::module::svc_req_set_state req;
+    services::robotkernel::module::svc_resp_set_state resp;
+
     // request data
 #define SET_STATE_REQ_STATE     0
     string state = request[SET_STATE_REQ_STATE];
+    req.state = state;
 
-    // response data
-    string error_message;
-
-    try {      
-        kernel::instance.set_state(name, string_to_state(state.c_str()));
-    } catch (const exception& e) {
-        error_message = e.what();
-    }
+    svc_set_state(req, resp);
 
 #define SET_STATE_RESP_ERROR_MESSAGE    0
     response.resize(1);
-    response[SET_STATE_RESP_ERROR_MESSAGE] = error_message;
+    response[SET_STATE_RESP_ERROR_MESSAGE] = resp.error_message;
 
     return 0;
 }
 
+//! svc_set_state
+/*!
+ * \param[in]   req     Service request data.
+ * \param[out]  resp    Service response data.
+ */
+void module::svc_set_state(
+        const struct services::robotkernel::module::svc_req_set_state& req, 
+        struct services::robotkernel::module::svc_resp_set_state& resp) 
+{
+    resp.error_message = "";
+
+    try {      
+        kernel::instance.set_state(name, string_to_state(req.state.c_str()));
+    } catch (const exception& e) {
+        resp.error_message = e.what();
+    }
+}
+
 //! get module state
 /*!
  * \param request service request data
@@ -447,23 +468,16 @@ int module::service_set_state(const service_arglist_t& request,
  */
 int module::service_get_state(const service_arglist_t& request, 
         service_arglist_t& response) {
-    
-    // response data
-    string state = "";
-    string error_message = "";
+    services::robotkernel::module::svc_req_get_state req;
+    services::robotkernel::module::svc_resp_get_state resp;
 
-    try {      
-        module_state_t act_state = kernel::instance.get_state(name);
-        state = state_to_string(act_state);
-    } catch (const exception& e) {
-        error_message = e.what();
-    }
+    svc_get_state(req, resp);
 
 #define GET_STATE_RESP_STATE            0
 #define GET_STATE_RESP_ERROR_MESSAGE    1
     response.resize(2);
-    response[GET_STATE_RESP_STATE]          = state;
-    response[GET_STATE_RESP_ERROR_MESSAGE]  = error_message;
+    response[GET_STATE_RESP_STATE]          = resp.state;
+    response[GET_STATE_RESP_ERROR_MESSAGE]  = resp.error_message;
 
     return 0;
 }
@@ -476,14 +490,51 @@ int module::service_get_state(const service_arglist_t& request,
  */
 int module::service_get_config(const service_arglist_t& request, 
         service_arglist_t& response) {
-    YAML::Emitter out;
-    out << *this;
+    services::robotkernel::module::svc_req_get_config req;
+    services::robotkernel::module::svc_resp_get_config resp;
+
+    svc_get_config(req, resp);
 
 #define GET_CONFIG_RESP_CONFIG  0
     response.resize(1);
-    response[GET_CONFIG_RESP_CONFIG] = string(out.c_str());
+    response[GET_CONFIG_RESP_CONFIG] = resp.config;
 
     return 0;
 }
 
+//! svc_get_state
+/*!
+ * \param[in]   req     Service request data.
+ * \param[out]  resp    Service response data.
+ */
+void module::svc_get_state(
+        const struct services::robotkernel::module::svc_req_get_state& req, 
+        struct services::robotkernel::module::svc_resp_get_state& resp) 
+{
+    resp.state = "";
+    resp.error_message = "";
+
+    try {      
+        module_state_t act_state = kernel::instance.get_state(name);
+        resp.state = state_to_string(act_state);
+    } catch (const exception& e) {
+        resp.error_message = e.what();
+    }
+}
+
+//! svc_get_config
+/*!
+ * \param[in]   req     Service request data.
+ * \param[out]  resp    Service response data.
+ */
+void module::svc_get_config(
+        const struct services::robotkernel::module::svc_req_get_config& req, 
+        struct services::robotkernel::module::svc_resp_get_config& resp) 
+{
+    YAML::Emitter out;
+    out << *this;
+
+    resp.config = string(out.c_str());
+}
+
 
@@ -32,6 +32,7 @@
 
 // public headers
 #include "robotkernel/service.h"
+#include "robotkernel/service_definitions.h"
 #include "robotkernel/module_base.h"
 
 // private headers
@@ -55,7 +56,10 @@ namespace robotkernel {
  */
 class module :
     public std::enable_shared_from_this<module>,
-    public robotkernel::so_file
+    public robotkernel::so_file,
+    public services::robotkernel::module::svc_base_set_state,
+    public services::robotkernel::module::svc_base_get_state,
+    public services::robotkernel::module::svc_base_get_config
 {
     private:
         module();
@@ -142,6 +146,33 @@ class module :
                 service_arglist_t& response);
         static const std::string service_definition_get_config;
 
+        //! svc_set_state
+        /*!
+         * \param[in]   req     Service request data.
+         * \param[out]  resp    Service response data.
+         */
+        void svc_set_state(
+            const struct services::robotkernel::module::svc_req_set_state& req, 
+            struct services::robotkernel::module::svc_resp_set_state& resp) override;
+
+        //! svc_get_state
+        /*!
+         * \param[in]   req     Service request data.
+         * \param[out]  resp    Service response data.
+         */
+        void svc_get_state(
+            const struct services::robotkernel::module::svc_req_get_state& req, 
+            struct services::robotkernel::module::svc_resp_get_state& resp) override;
+
+        //! svc_get_config
+        /*!
+         * \param[in]   req     Service request data.
+         * \param[out]  resp    Service response data.
+         */
+        void svc_get_config(
+            const struct services::robotkernel::module::svc_req_get_config& req, 
+            struct services::robotkernel::module::svc_resp_get_config& resp) override;
+
         void set_power_up(module_state_t power_up_state) {
             power_up = power_up_state;
         }
@@ -202,6 +202,8 @@ void process_data::find_pd_offset_and_type(pd_entry_t& e) {
     find_pd_offset_and_type(e.field_name, e.type_str, e.type, e.offset);
 }
 
+std::atomic<uint64_t> process_data::topology_generation(0);
+
 //! set data provider thread, only thread allowed to write and push
 void process_data::set_provider(sp_pd_provider_t& prov) { 
     if (    (provider != nullptr) && 
@@ -211,6 +213,10 @@ void process_data::set_provider(sp_pd_provider_t& prov) {
 
     provider = prov;
     prov->hash = std::hash<std::shared_ptr<robotkernel::pd_provider> >{}(prov);
+    topology_generation++;
+
+    if (prov->numa_node >= 0)
+        bind_numa_node(prov->numa_node);
 }
 
 //! reset data provider thread
@@ -221,6 +227,7 @@ void process_data::reset_provider(sp_pd_provider_t& prov) {
 
     prov->hash = 0;
     provider = nullptr;
+    topology_generation++;
 }
 
 //!< set main consumer thread, only thread allowed to pop
@@ -231,6 +238,7 @@ void process_data::set_consumer(sp_pd_consumer_t& cons) {
 
     consumer = cons;
     cons->hash = std::hash<std::shared_ptr<robotkernel::pd_consumer> >{}(cons);
+    topology_generation++;
 }
 
 //! reset main consumer thread
@@ -240,6 +248,7 @@ void process_data::reset_consumer(sp_pd_consumer_t& cons) {
 
     cons->hash = 0;
     consumer = nullptr;
+    topology_generation++;
 }
         
 //! inject value to process data
@@ -283,6 +292,11 @@ process_data(length, owner, name, process_data_definition, clk_device)
     data.resize(length);
 }
 
+//! move process data buffers to NUMA node
+void single_buffer::bind_numa_node(int numa_node) {
+    numa_bind_memory(&data[0], data.size(), numa_node);
+}
+
 //! Get a pointer to the a data buffer which we can write next, has to be
 //  completed with calling \link push \endlink
 /*
@@ -382,6 +396,12 @@ process_data(length, owner, name, process_data_definition, clk_device)
     data[2].resize(length);
 }
 
+//! move process data buffers to NUMA node
+void triple_buffer::bind_numa_node(int numa_node) {
+    for (auto& d : data)
+        numa_bind_memory(&d[0], d.size(), numa_node);
+}
+
 //! Get a pointer to the a data buffer which we can write next, has to be
 //  completed with calling \link push \endlink
 /*
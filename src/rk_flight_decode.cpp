@@ -1,7 +1,6 @@
-//! robotkernel module definition
+//! robotkernel flight recorder decoder
 /*!
  * (C) Robert Burger <robert.burger@dlr.de>
- * (C) Florian Schmidt <florian.schmidt@dlr.de>
  */
 
 // vim: set expandtab softtabstop=4 shiftwidth=4
@@ -25,48 +24,35 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
-#ifndef ROBOTKERNEL__CHAR_RINGBUFFER_H
-#define ROBOTKERNEL__CHAR_RINGBUFFER_H
+// public headers
+#include "robotkernel/flight_recorder.h"
 
-#include <sstream>
-#include <mutex>
-
-#ifdef DEBUG
 #include <stdio.h>
-#endif
-
-namespace robotkernel {
-
-class char_ringbuffer {
-    private:
-        unsigned int size;
-        char* data;
-
-        unsigned int write_start;
-        unsigned int read_start;
-        bool buffer_full;
-
-        std::mutex mtx;
-
-    public:
-        char_ringbuffer(unsigned int size);
-        ~char_ringbuffer();
-
-        unsigned int get_size();
-
-        void set_size(unsigned int new_size);
-        void write(std::string data);
-
-#ifdef DEBUG
-        void debug();
-#endif
-
-        std::string get(bool keep=false);
-        bool has_data();
-        unsigned int get_data_len();
-};
-
-}; // namespace robotkernel
-
-#endif // ROBOTKERNEL__CHAR_RINGBUFFER_H
+#include <stdlib.h>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+using namespace robotkernel;
+
+int main(int argc, char** argv) {
+    if ((argc < 2) || (argc > 3)) {
+        fprintf(stderr, "usage: %s <flight recorder file> [last MB]\n", argv[0]);
+        return 1;
+    }
+
+    size_t max_bytes = 0;
+    if (argc == 3)
+        max_bytes = (size_t)(atof(argv[2]) * 1024 * 1024);
+
+    try {
+        size_t cnt = flight_recorder::decode(argv[1], cout, max_bytes);
+        fprintf(stderr, "%zu records decoded\n", cnt);
+    } catch (const exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
 
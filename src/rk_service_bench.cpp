@@ -0,0 +1,314 @@
+//! robotkernel service path microbenchmark
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/rk_type.h"
+#include "robotkernel/kernel_clock.h"
+#include "robotkernel/helpers.h"
+
+// private headers
+#include "kernel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <new>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <functional>
+
+using namespace std;
+using namespace robotkernel;
+
+// count allocations per thread
+static thread_local uint64_t thread_allocs = 0;
+
+static void *counted_alloc(size_t size) {
+    thread_allocs++;
+
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void *operator new(size_t size) { return counted_alloc(size); }
+void *operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+//! keep compiler from optimizing away benchmarked values
+static inline void clobber(const void *p) {
+    asm volatile("" : : "g"(p) : "memory");
+}
+
+static uint64_t iterations = 200000;
+static const char *filter = NULL;
+
+//! run benchmark and print result
+/*!
+ * The body is executed once for warm up, then concurrently on all 
+ * threads. ns/op is the wall time divided by the operations of one
+ * thread, allocs/op the allocations of all threads per operation.
+ *
+ * \param[in] name      Benchmark name with parameters.
+ * \param[in] threads   Number of threads running body concurrently.
+ * \param[in] ops       Operations per thread.
+ * \param[in] body      Runs given number of operations.
+ */
+static void run(const string& name, int threads, uint64_t ops, 
+        const function<void(uint64_t)>& body) {
+    if (filter && (name.find(filter) == string::npos))
+        return;
+
+    body(ops / 10 + 1);
+
+    atomic<int> ready(0);
+    atomic<bool> go(false);
+    atomic<uint64_t> allocs(0);
+    vector<thread> workers;
+
+    for (int i = 0; i < threads; ++i)
+        workers.emplace_back([&]() {
+            ready++;
+            while (!go) {}
+
+            uint64_t start_allocs = thread_allocs;
+            body(ops);
+            allocs += thread_allocs - start_allocs;
+        });
+
+    while (ready < threads) {}
+
+    uint64_t start = kernel_clock::now_ns();
+    go = true;
+
+    for (auto& w : workers)
+        w.join();
+
+    uint64_t dur = kernel_clock::now_ns() - start;
+
+    printf("%-52s %3d %10.1f %9.2f\n", name.c_str(), threads, 
+            (double)dur / ops, (double)allocs / (ops * threads));
+    fflush(stdout);
+}
+
+//! build request with cnt arguments
+static service_arglist_t make_args(int cnt, int string_len) {
+    service_arglist_t args;
+
+    for (int i = 0; i < cnt; ++i) {
+        if (string_len)
+            args.push_back(rk_type(string(string_len, 'a' + i % 26)));
+        else
+            args.push_back(rk_type(1.5 * i));
+    }
+
+    return args;
+}
+
+//! set registry to cnt services besides the benchmarked ones
+static void set_registry(int cnt) {
+    kernel& k = kernel::instance;
+
+    k.remove_services("bench_registry");
+    for (int i = 0; i < cnt; ++i)
+        k.add_service("bench_registry", string_printf("service_%d", i), "", 
+                [](const service_arglist_t&, service_arglist_t&) { return 0; });
+}
+
+static void bench_rk_type() {
+    run("rk_type construct double", 1, iterations, [](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; ++i) {
+            rk_type v(1.5 * i);
+            clobber(&v);
+        }
+    });
+
+    for (int len : { 8, 64, 1024 }) {
+        string s(len, 'x');
+
+        run(string_printf("rk_type construct string len=%d", len), 1, iterations, [&s](uint64_t ops) {
+            for (uint64_t i = 0; i < ops; ++i) {
+                rk_type v(s);
+                clobber(&v);
+            }
+        });
+
+        rk_type src(s);
+        run(string_printf("rk_type copy string len=%d", len), 1, iterations, [&src](uint64_t ops) {
+            for (uint64_t i = 0; i < ops; ++i) {
+                rk_type v(src);
+                clobber(&v);
+            }
+        });
+    }
+
+    rk_type vec(convertVector(vector<double>(16, 1.5)));
+    run("rk_type copy vector<double> len=16", 1, iterations, [&vec](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; ++i) {
+            rk_type v(vec);
+            clobber(&v);
+        }
+    });
+}
+
+static void bench_convert() {
+    for (int len : { 16, 1024 }) {
+        vector<double> in(len, 1.5);
+        uint64_t ops = iterations * 16 / len + 1;
+
+        run(string_printf("convertVector<double> len=%d", len), 1, ops, [&in](uint64_t ops) {
+            for (uint64_t i = 0; i < ops; ++i) {
+                vector<rk_type> v = convertVector(in);
+                clobber(&v);
+            }
+        });
+
+        vector<rk_type> rk_in = convertVector(in);
+        run(string_printf("convertVector2<double> len=%d", len), 1, ops, [&rk_in](uint64_t ops) {
+            for (uint64_t i = 0; i < ops; ++i) {
+                vector<double> v = convertVector2<double>(rk_in);
+                clobber(&v);
+            }
+        });
+    }
+
+    vector<string> in(16, string(32, 'x'));
+    run("convertVector<string> len=16 string_len=32", 1, iterations / 16, [&in](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; ++i) {
+            vector<rk_type> v = convertVector(in);
+            clobber(&v);
+        }
+    });
+}
+
+static void bench_add_service() {
+    kernel& k = kernel::instance;
+    uint64_t ops = iterations / 20 + 1;
+
+    for (int reg : { 0, 1000, 10000 }) {
+        set_registry(reg);
+
+        run(string_printf("add_service+remove_services registry=%d", reg), 1, ops, 
+                [&k](uint64_t ops) {
+            for (uint64_t i = 0; i < ops; ++i)
+                k.add_service("bench_add", string_printf("service_%d", (int)i), "", 
+                        [](const service_arglist_t&, service_arglist_t&) { return 0; });
+
+            k.remove_services("bench_add");
+        });
+    }
+}
+
+//! benchmark both call_service overloads
+static void bench_call(const string& params, int threads, int args, int string_len) {
+    kernel& k = kernel::instance;
+    service_arglist_t req = make_args(args, string_len);
+
+    run("call_service(owner, name) " + params, threads, iterations, [&k, &req](uint64_t ops) {
+        service_arglist_t resp;
+        for (uint64_t i = 0; i < ops; ++i) {
+            resp.clear();
+            k.call_service("bench", "echo", req, resp);
+        }
+    });
+
+    run("call_service(\"owner.name\") " + params, threads, iterations, [&k, &req](uint64_t ops) {
+        service_arglist_t resp;
+        for (uint64_t i = 0; i < ops; ++i) {
+            resp.clear();
+            k.call_service("bench.echo", req, resp);
+        }
+    });
+}
+
+static void bench_call_service() {
+    kernel& k = kernel::instance;
+
+    // echo service, copies request to response like a typical wrapper
+    k.add_service("bench", "echo", "", [](const service_arglist_t& req, service_arglist_t& resp) {
+        resp.assign(req.begin(), req.end());
+        return 0;
+    });
+
+    set_registry(1000);
+
+    for (int args : { 0, 4, 16 })
+        bench_call(string_printf("args=%d", args), 1, args, 0);
+
+    for (int len : { 8, 64, 1024 })
+        bench_call(string_printf("args=4 string_len=%d", len), 1, 4, len);
+
+    unsigned cpus = std::thread::hardware_concurrency();
+    for (int threads : { 2, 4, 8 })
+        if ((unsigned)threads <= std::max(cpus, 2u))
+            bench_call(string_printf("args=4 threads=%d", threads), threads, 4, 0);
+
+    for (int reg : { 10, 10000 }) {
+        set_registry(reg);
+        bench_call(string_printf("args=4 registry=%d", reg), 1, 4, 0);
+    }
+
+    set_registry(0);
+    k.remove_services("bench");
+}
+
+int main(int argc, char** argv) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n': 
+                iterations = strtoull(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [filter]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind < argc)
+        filter = argv[optind];
+
+    if (iterations < 100)
+        iterations = 100;
+
+    printf("%-52s %3s %10s %9s\n", "benchmark", "thr", "ns/op", "allocs/op");
+
+    bench_rk_type();
+    bench_convert();
+    bench_add_service();
+    bench_call_service();
+
+    return 0;
+}
+
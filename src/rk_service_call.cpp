@@ -0,0 +1,337 @@
+//! robotkernel unix domain socket bridge client
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/service_descriptor.h"
+
+// private headers
+#include "uds_protocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <set>
+#include <iostream>
+#include <stdexcept>
+
+#include "yaml-cpp/yaml.h"
+
+using namespace std;
+using namespace robotkernel;
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-s socket] list\n"
+            "       %s [-s socket] [-n count] [-p depth] <owner> <name> [request]\n\n"
+            "  request   yaml sequence in field order or map by field name\n"
+            "  -n count  call service count times and print timing\n"
+            "  -p depth  keep up to depth calls in flight (default 1)\n", prog, prog);
+}
+
+static void write_all(int fd, const string& buf) {
+    size_t off = 0;
+
+    while (off < buf.size()) {
+        ssize_t ret = ::write(fd, buf.data() + off, buf.size() - off);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            throw runtime_error(string("write failed: ") + strerror(errno));
+        }
+
+        off += ret;
+    }
+}
+
+static void read_all(int fd, char *buf, size_t len) {
+    while (len) {
+        ssize_t ret = ::read(fd, buf, len);
+        if (ret == 0)
+            throw runtime_error("connection closed by robotkernel");
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            throw runtime_error(string("read failed: ") + strerror(errno));
+        }
+
+        buf += ret;
+        len -= ret;
+    }
+}
+
+//! append request frame to buffer
+static void add_request(string& out, uint32_t id, uint16_t type, const string& payload) {
+    uds_frame_header hdr;
+    hdr.length = payload.size();
+    hdr.id     = id;
+    hdr.type   = type;
+    hdr.status = uds_status_ok;
+
+    out.append((const char *)&hdr, sizeof(hdr));
+    out.append(payload);
+}
+
+//! read response frame, throws error responses
+static void read_response(int fd, uds_frame_header& hdr, string& payload) {
+    read_all(fd, (char *)&hdr, sizeof(hdr));
+    payload.resize(hdr.length);
+    if (hdr.length)
+        read_all(fd, &payload[0], hdr.length);
+
+    if (hdr.status != uds_status_ok) {
+        uds_reader r(payload.data(), payload.size());
+        throw runtime_error(r.get_string());
+    }
+}
+
+//! send one request and wait for its response
+static void transact(int fd, uint16_t type, const string& req, string& resp) {
+    string out;
+    uds_frame_header hdr;
+
+    add_request(out, 0, type, req);
+    write_all(fd, out);
+    read_response(fd, hdr, resp);
+}
+
+//! encode scalar from yaml, empty node encodes default
+static void put_scalar(const service_field_descriptor& f, const YAML::Node& n, uds_writer& w) {
+    bool empty = !n.IsDefined() || n.IsNull();
+
+    switch (f.type) {
+        case service_field_string: w.put_string(empty ? string() : n.as<string>()); break;
+        case service_field_double: w.put<double>(empty ? 0. : n.as<double>()); break;
+        case service_field_float:  w.put<float>(empty ? 0.f : n.as<float>()); break;
+        case service_field_int8:   w.put<int8_t>(empty ? 0 : n.as<int>()); break;
+        case service_field_uint8:  w.put<uint8_t>(empty ? 0 : n.as<unsigned>()); break;
+        case service_field_int16:  w.put<int16_t>(empty ? 0 : n.as<int16_t>()); break;
+        case service_field_uint16: w.put<uint16_t>(empty ? 0 : n.as<uint16_t>()); break;
+        case service_field_int32:  w.put<int32_t>(empty ? 0 : n.as<int32_t>()); break;
+        case service_field_uint32: w.put<uint32_t>(empty ? 0 : n.as<uint32_t>()); break;
+        case service_field_int64:  w.put<int64_t>(empty ? 0 : n.as<int64_t>()); break;
+        case service_field_uint64: w.put<uint64_t>(empty ? 0 : n.as<uint64_t>()); break;
+        default:
+            throw runtime_error("unsupported service argument type " + f.type_name);
+    }
+}
+
+//! encode request from yaml sequence or map
+static void encode_request(const service_fields_t& fields, const YAML::Node& node, uds_writer& w) {
+    if (node.IsSequence() && (node.size() > fields.size()))
+        throw runtime_error("too many request arguments");
+
+    for (size_t i = 0; i < fields.size(); ++i) {
+        const service_field_descriptor& f = fields[i];
+        YAML::Node value;
+
+        if (node.IsSequence() && (i < node.size()))
+            value = node[i];
+        else if (node.IsMap() && node[f.name])
+            value = node[f.name];
+
+        if (!f.is_array) {
+            put_scalar(f, value, w);
+            continue;
+        }
+
+        if (value.IsDefined() && !value.IsNull() && !value.IsSequence())
+            throw runtime_error("expected sequence for " + f.name);
+
+        w.put<uint32_t>(value.IsSequence() ? value.size() : 0);
+        if (value.IsSequence())
+            for (const auto& elem : value)
+                put_scalar(f, elem, w);
+    }
+}
+
+//! decode scalar to yaml
+static void get_scalar(const service_field_descriptor& f, uds_reader& r, YAML::Emitter& out) {
+    switch (f.type) {
+        case service_field_string: out << YAML::DoubleQuoted << r.get_string(); break;
+        case service_field_double: out << r.get<double>(); break;
+        case service_field_float:  out << r.get<float>(); break;
+        case service_field_int8:   out << (int)r.get<int8_t>(); break;
+        case service_field_uint8:  out << (unsigned)r.get<uint8_t>(); break;
+        case service_field_int16:  out << r.get<int16_t>(); break;
+        case service_field_uint16: out << r.get<uint16_t>(); break;
+        case service_field_int32:  out << r.get<int32_t>(); break;
+        case service_field_uint32: out << r.get<uint32_t>(); break;
+        case service_field_int64:  out << (long long)r.get<int64_t>(); break;
+        case service_field_uint64: out << (unsigned long long)r.get<uint64_t>(); break;
+        default:
+            throw runtime_error("unsupported service argument type " + f.type_name);
+    }
+}
+
+//! decode response to yaml map
+static string decode_response(const service_fields_t& fields, const string& payload) {
+    uds_reader r(payload.data(), payload.size());
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+
+    for (const auto& f : fields) {
+        out << YAML::Key << f.name << YAML::Value;
+
+        if (!f.is_array) {
+            get_scalar(f, r, out);
+            continue;
+        }
+
+        uint32_t cnt = r.get<uint32_t>();
+        out << YAML::Flow << YAML::BeginSeq;
+        for (uint32_t i = 0; i < cnt; ++i)
+            get_scalar(f, r, out);
+        out << YAML::EndSeq;
+    }
+
+    out << YAML::EndMap;
+    return out.c_str();
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    const char *socket_path = getenv("ROBOTKERNEL_SOCKET");
+    long count = 0;
+    long depth = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:n:p:h")) != -1) {
+        switch (opt) {
+            case 's': socket_path = optarg; break;
+            case 'n': count = atol(optarg); break;
+            case 'p': depth = atol(optarg); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (!socket_path) {
+        fprintf(stderr, "no socket given, use -s or ROBOTKERNEL_SOCKET\n");
+        return 1;
+    }
+
+    int nargs = argc - optind;
+    bool list = (nargs == 1) && (string(argv[optind]) == "list");
+    if (!list && (nargs != 2) && (nargs != 3)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if ((fd == -1) || (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1))
+            throw runtime_error(string("cannot connect to ") + socket_path + ": " + strerror(errno));
+
+        string payload;
+
+        if (list) {
+            transact(fd, uds_msg_list, string(), payload);
+
+            uds_reader r(payload.data(), payload.size());
+            set<string> names;
+            for (uint32_t i = r.get<uint32_t>(); i > 0; --i) {
+                string owner = r.get_string();
+                names.insert(owner + "." + r.get_string());
+            }
+
+            for (const auto& n : names)
+                printf("%s\n", n.c_str());
+
+            close(fd);
+            return 0;
+        }
+
+        // resolve service once
+        string req;
+        uds_writer w(req);
+        w.put_string(argv[optind]);
+        w.put_string(argv[optind + 1]);
+        transact(fd, uds_msg_resolve, req, payload);
+
+        uds_reader r(payload.data(), payload.size());
+        uint32_t handle = r.get<uint32_t>();
+        auto desc = service_descriptor::parse(r.get_string());
+
+        req.clear();
+        w.put<uint32_t>(handle);
+        encode_request(desc->request, YAML::Load(nargs == 3 ? argv[optind + 2] : "{}"), w);
+
+        // pipeline calls, keep up to depth requests in flight
+        long calls = count > 0 ? count : 1;
+        long sent = 0, received = 0;
+        uds_frame_header hdr;
+        string out;
+        double start = now();
+
+        if (depth < 1)
+            depth = 1;
+
+        while (received < calls) {
+            out.clear();
+            while ((sent < calls) && (sent - received < depth))
+                add_request(out, sent++, uds_msg_call, req);
+            if (!out.empty())
+                write_all(fd, out);
+
+            read_response(fd, hdr, payload);
+            received++;
+        }
+
+        double dur = now() - start;
+
+        cout << decode_response(desc->response, payload) << endl;
+        if (count > 0)
+            fprintf(stderr, "%ld calls in %.3f s, %.2f us/call, %.0f calls/s\n",
+                    calls, dur, dur * 1e6 / calls, calls / dur);
+
+        close(fd);
+    } catch (const exception& e) {
+        string msg = e.what();
+        while (!msg.empty() && (msg[msg.size() - 1] == '\n'))
+            msg.erase(msg.size() - 1);
+
+        fprintf(stderr, "%s\n", msg.c_str());
+        return 1;
+    }
+
+    return 0;
+}
+
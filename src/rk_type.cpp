@@ -32,10 +32,9 @@
 using namespace std;
 
 namespace robotkernel {
-    reference_map_t rk_type::__refs;
-    std::mutex      rk_type::__refsLock;
+    const rk_type::ops_t rk_type::heap_ops = { true, NULL, NULL, NULL };
 
-    std::string rk_type::to_string(){
+    std::string rk_type::to_string() const {
         if(__type == typeid(int8_t)){
             return string_printf("%d", (int8_t) *this);
         } else if(__type == typeid(int16_t)){
@@ -43,24 +42,23 @@ namespace robotkernel {
         } else if(__type == typeid(int32_t)){
             return string_printf("%d", (int32_t) *this);
         } else if(__type == typeid(int64_t)){
-            return string_printf("%d", (int64_t) *this);
+            return string_printf("%lld", (long long)(int64_t) *this);
         } else if(__type == typeid(uint8_t)){
             return string_printf("%d", (uint8_t) *this);
         } else if(__type == typeid(uint16_t)){
             return string_printf("%d", (uint16_t) *this);
         } else if(__type == typeid(uint32_t)){
-            return string_printf("%d", (uint32_t) *this);
+            return string_printf("%u", (uint32_t) *this);
         } else if(__type == typeid(uint64_t)){
-            return string_printf("%d", (uint64_t) *this);
+            return string_printf("%llu", (unsigned long long)(uint64_t) *this);
         } else if(__type == typeid(float)){
             return string_printf("%f", (float) *this);
         } else if(__type == typeid(double)){
             return string_printf("%f", (double) *this);
         } else if(__type == typeid(std::string)){
-            std::string v = *static_cast<std::string*>((void*)__value);
-            return v;
+            return *static_cast<const std::string*>(data());
         } else if(__type == typeid(std::vector<rk_type>)){
-            std::vector<rk_type> v = *static_cast<std::vector<rk_type>*>((void*)__value);
+            const std::vector<rk_type>& v = *static_cast<const std::vector<rk_type>*>(data());
             std::stringstream response;
             response << '{';
             for (unsigned int i=0; i<v.size(); ++i){
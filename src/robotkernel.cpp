@@ -26,6 +26,7 @@
 
 // public headers
 #include "robotkernel/robotkernel.h"
+#include "robotkernel/local_service.h"
 
 // private headers
 #include "kernel.h"
@@ -36,14 +37,86 @@
  * \param name service name
  * \param service_definition service definition
  * \param callback service callback
+ * \param dispatch how the service is executed, may be 
+ *                 overridden by service_dispatch configuration
  */
 void robotkernel::add_service(
         const std::string &owner,
         const std::string &name,
         const std::string &service_definition,
-        service_callback_t callback)
+        service_callback_t callback,
+        service_dispatch_t dispatch)
 {
-    return robotkernel::kernel::instance.add_service(owner, name, service_definition, callback);
+    return robotkernel::kernel::instance.add_service(owner, name, service_definition, 
+            callback, dispatch);
+}
+
+//! call a service asynchronously
+/*!
+ * \param[in]  owner         Owner of service to call.
+ * \param[in]  name          Name of service to call.
+ * \param[in]  req           Service request parameters.
+ * \param[in]  done          Completion, called with response or exception.
+ */
+void robotkernel::call_service_async(
+        const std::string& owner,
+        const std::string& name,
+        const service_arglist_t& req,
+        service_completion_t done)
+{
+    return robotkernel::kernel::instance.call_service_async(owner, name, req, done);
+}
+
+//! call a service asynchronously
+/*!
+ * \param[in]  owner         Owner of service to call.
+ * \param[in]  name          Name of service to call.
+ * \param[in]  req           Service request parameters.
+ * \return future of service response
+ */
+std::future<robotkernel::service_arglist_t> robotkernel::call_service_async(
+        const std::string& owner,
+        const std::string& name,
+        const service_arglist_t& req)
+{
+    return robotkernel::kernel::instance.call_service_async(owner, name, req);
+}
+
+//! get service by name
+/*!
+ * \param[in] owner     Owner of service.
+ * \param[in] name      Name of service.
+ * \return service, throws if not found
+ */
+robotkernel::sp_service_t robotkernel::get_service(
+        const std::string& owner,
+        const std::string& name)
+{
+    return robotkernel::kernel::instance.get_service(owner, name);
+}
+
+//! set typed handler of an existing service
+/*!
+ * \param[in] owner     Owner of service.
+ * \param[in] name      Name of service.
+ * \param[in] handler   Typed handler, replaces previous one.
+ */
+void robotkernel::set_service_local_handler(
+        const std::string& owner,
+        const std::string& name,
+        sp_service_local_handler_t handler)
+{
+    return robotkernel::kernel::instance.set_service_local_handler(owner, name, handler);
+}
+
+//! run typed call of queued service on service worker pool and wait
+/*!
+ * \param[in] svc       Service with dispatch async or serialized.
+ * \param[in] call      Calls typed handler.
+ */
+void robotkernel::call_service_local_queued(sp_service_t svc, std::function<void()> call)
+{
+    return robotkernel::kernel::instance.call_local_queued(svc, call);
 }
 
 //! remove on service given by name
@@ -103,6 +176,33 @@ std::shared_ptr<robotkernel::device> robotkernel::get_device(const std::string&
     return robotkernel::kernel::instance.get_device<robotkernel::device>(dev_name);
 }
 
+//! get interned handle of a device name
+/*!
+ * \param dev_name device name
+ * \return device handle
+ */
+robotkernel::device_handle_t robotkernel::get_device_handle(const std::string& dev_name) {
+    return robotkernel::kernel::instance.get_device_handle(dev_name);
+}
+
+//! get a device by handle
+/*!
+ * \param handle device handle from get_device_handle
+ * \return device
+ */
+std::shared_ptr<robotkernel::device> robotkernel::get_device(robotkernel::device_handle_t handle) {
+    return robotkernel::kernel::instance.get_device<robotkernel::device>(handle);
+}
+
+//! get a fd reactor by name
+/*!
+ * \param[in] name      Name of fd reactor from config file.
+ * \return fd reactor
+ */
+robotkernel::sp_fd_reactor_t robotkernel::get_fd_reactor(const std::string& name) {
+    return robotkernel::kernel::instance.get_fd_reactor(name);
+}
+
 //! get robotkernel name
 const std::string robotkernel::name(void) {
     return robotkernel::kernel::instance.name;
@@ -26,11 +26,13 @@
 
 #include <stdio.h>
 #include <signal.h>
+#include <time.h>
 
 // public headers
 #include "robotkernel/runnable.h"
 #include "robotkernel/config.h"
 #include "robotkernel/helpers.h"
+#include "robotkernel/kernel_clock.h"
 
 // private headers
 #include "kernel.h"
@@ -44,28 +46,73 @@
 #include <taskLib.h>
 #endif
         
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE  6
+#endif
+
 using namespace std;
 using namespace robotkernel;
 
+//! validate SCHED_DEADLINE parameters
+/*!
+ * \param[in]     name          Thread name for error message.
+ * \param[in]     runtime_ns    Worst case execution time per period [ns].
+ * \param[in,out] deadline_ns   Relative deadline [ns], 0 is replaced by period.
+ * \param[in]     period_ns     Period [ns], 0 disables SCHED_DEADLINE.
+ */
+static void check_deadline(const string& name, uint64_t runtime_ns, 
+        uint64_t& deadline_ns, uint64_t period_ns) {
+    if (deadline_ns == 0)
+        deadline_ns = period_ns;
+
+    if (period_ns && ((runtime_ns == 0) || (runtime_ns > deadline_ns) || (deadline_ns > period_ns)))
+        throw runtime_error(string_printf("[runnable] %s: invalid SCHED_DEADLINE parameters, "
+                    "0 < runtime <= deadline <= period required!", name.c_str()));
+}
+
 //! construction with yaml node
 /*!
  * \param node yaml node which should contain prio and affinity
  */
-runnable::runnable(const YAML::Node& node) {
-    run_flag       = false;
+runnable_config::runnable_config(const YAML::Node& node) :
+    dl_runtime(0), dl_deadline(0), dl_period(0)
+{
     prio           = get_as<int>(node, "prio", 0);
-    policy         = SCHED_FIFO;
-    affinity_mask  = 0;
+    numa_node      = get_as<int>(node, "numa_node", -1);
     thread_name    = get_as<string>(node, "thread_name", "runnable");
 
-    if(node["affinity"]) {
-        const YAML::Node& affinity = node["affinity"];
-        if (affinity.Type() == YAML::NodeType::Scalar)
-            affinity_mask = (1 << affinity.as<int>());
-        else if (affinity.Type() == YAML::NodeType::Sequence)
-            for (YAML::const_iterator it = affinity.begin(); it != affinity.end(); ++it)
-                affinity_mask |= (1 << it->as<int>());
+    if (node["sched_deadline"]) {
+        const YAML::Node& dl = node["sched_deadline"];
+
+        dl_runtime  = (uint64_t)(get_as<double>(dl, "runtime") * 1E9);
+        dl_deadline = (uint64_t)(get_as<double>(dl, "deadline", 0.) * 1E9);
+        dl_period   = (uint64_t)(get_as<double>(dl, "period") * 1E9);
+
+        check_deadline(thread_name, dl_runtime, dl_deadline, dl_period);
     }
+
+    if (node["affinity"])
+        affinity = cpu_affinity(node["affinity"]);
+    else if (numa_node >= 0)
+        affinity = cpu_affinity::numa_node_cpus(numa_node);
+}
+
+//! construction with yaml node
+/*!
+ * \param node yaml node which should contain prio and affinity
+ */
+runnable::runnable(const YAML::Node& node) : runnable(runnable_config(node)) {}
+
+//! construction with parsed thread settings
+/*!
+ * \param config thread settings
+ */
+runnable::runnable(const runnable_config& config) :
+    policy(SCHED_FIFO), prio(config.prio), affinity(config.affinity), 
+    numa_node(config.numa_node), dl_runtime(config.dl_runtime), 
+    dl_deadline(config.dl_deadline), dl_period(config.dl_period),
+    deadline_misses(0), runtime_overruns(0),
+    thread_name(config.thread_name), run_flag(false) {
 }
 
 //! construction with prio and affinity_mask
@@ -75,9 +122,27 @@ runnable::runnable(const YAML::Node& node) {
  */
 runnable::runnable(const int prio, const int affinity_mask,
         std::string thread_name) :
-    policy(SCHED_FIFO), prio(prio), affinity_mask(affinity_mask), 
+    policy(SCHED_FIFO), prio(prio), affinity(affinity_mask), numa_node(-1),
+    dl_runtime(0), dl_deadline(0), dl_period(0), 
+    deadline_misses(0), runtime_overruns(0),
     thread_name(thread_name), run_flag(false) {
 }
+
+//! construction with prio and cpu affinity
+/*!
+ * \param[in] prio          Runnable thread priority.
+ * \param[in] affinity      Runnable thread cpu affinity.
+ * \param[in] thread_name   Name of runnable thread if started.
+ * \param[in] numa_node     NUMA node for thread memory, -1 for none.
+ */
+runnable::runnable(const int prio, const cpu_affinity& affinity,
+        std::string thread_name, int numa_node) :
+    policy(SCHED_FIFO), prio(prio), affinity(affinity), numa_node(-1),
+    dl_runtime(0), dl_deadline(0), dl_period(0), 
+    deadline_misses(0), runtime_overruns(0),
+    thread_name(thread_name), run_flag(false) {
+    set_numa_node(numa_node);
+}
         
 //! run wrapper to create posix thread
 /*!
@@ -86,8 +151,28 @@ runnable::runnable(const int prio, const int affinity_mask,
  */
 void runnable::run_wrapper() { 
     ::set_thread_name(thread_name);
-    ::set_priority(prio);
-    ::set_affinity_mask(affinity_mask);
+
+    if (dl_period) {
+        if (!affinity.empty())
+            robotkernel::kernel::instance.log(warning, "[runnable] %s: ignoring affinity "
+                    "mask for SCHED_DEADLINE thread, use exclusive cpusets\n", thread_name.c_str());
+
+        if (::set_sched_deadline(dl_runtime, dl_deadline, dl_period))
+            policy = SCHED_DEADLINE;
+        else {
+            robotkernel::kernel::instance.log(warning, "[runnable] %s: falling back to "
+                    "priority %d\n", thread_name.c_str(), prio);
+
+            ::set_priority(prio);
+            ::set_affinity(affinity);
+        }
+    } else {
+        ::set_priority(prio);
+        ::set_affinity(affinity);
+    }
+
+    if (numa_node >= 0)
+        ::numa_bind_thread(numa_node);
     
     run(); 
 };
@@ -145,14 +230,65 @@ void runnable::set_prio(int prio) {
  * \param mask new cup affinity mask 
  */
 void runnable::set_affinity_mask(int mask) {
-    if (mask != 0) {
-        robotkernel::kernel::instance.log(verbose, "[runnable] setting cpu affinity mask %Xh\n", mask); 
-        this->affinity_mask = mask;
+    set_affinity(cpu_affinity(mask));
+}
+
+//! set cpu affinity
+/*!
+ * \param affinity new cpu affinity
+ */
+void runnable::set_affinity(const cpu_affinity& affinity) {
+    if (!affinity.empty()) {
+        robotkernel::kernel::instance.log(verbose, "[runnable] setting cpu affinity %s\n", 
+                affinity.to_string().c_str()); 
+        this->affinity = affinity;
         if (running())
-            ::set_affinity_mask(mask);
+            ::set_affinity(affinity);
     }
 }
+
+//! bind thread memory to NUMA node
+/*!
+ * \param[in] node      NUMA node, -1 for none.
+ */
+void runnable::set_numa_node(int node) {
+    numa_node = node;
+
+    if ((numa_node >= 0) && affinity.empty())
+        affinity = cpu_affinity::numa_node_cpus(numa_node);
+}
         
+//! use SCHED_DEADLINE instead of priority
+/*!
+ * \param[in] runtime_ns    Worst case execution time per period [ns].
+ * \param[in] deadline_ns   Relative deadline [ns], 0 for period.
+ * \param[in] period_ns     Period [ns], 0 disables SCHED_DEADLINE.
+ */
+void runnable::set_deadline(uint64_t runtime_ns, uint64_t deadline_ns, uint64_t period_ns) {
+    check_deadline(thread_name, runtime_ns, deadline_ns, period_ns);
+
+    dl_runtime  = runtime_ns;
+    dl_deadline = deadline_ns;
+    dl_period   = period_ns;
+}
+
+//! account one finished job of a deadline thread
+/*!
+ * \param[in] release_ns    Job release time, kernel_clock [ns].
+ * \param[in] cpu_ns        CPU time consumed by the job [ns].
+ */
+void runnable::account_job(uint64_t release_ns, uint64_t cpu_ns) {
+    if (!dl_period)
+        return;
+
+    uint64_t now_ns = kernel_clock::now_ns();
+
+    if ((now_ns - release_ns) > dl_deadline)
+        deadline_misses++;
+    if (cpu_ns > dl_runtime)
+        runtime_overruns++;
+}
+
 //! set thread name
 void runnable::set_name(std::string name) {
     robotkernel::kernel::instance.log(verbose, "[runnable] setting thread name to %s\n", name.c_str());
@@ -0,0 +1,108 @@
+//! robotkernel reader/writer lock
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__RWLOCK_H
+#define ROBOTKERNEL__RWLOCK_H
+
+#include <pthread.h>
+#include <stdexcept>
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! reader/writer lock
+/*!
+ * Any number of readers may hold the lock at the same time, writers are
+ * exclusive. Writers are preferred where the platform supports it, so 
+ * frequent readers cannot starve them.
+ */
+class rwlock {
+    private:
+        rwlock(const rwlock&);             // prevent copy-construction
+        rwlock& operator=(const rwlock&);  // prevent assignment
+
+        pthread_rwlock_t lock;
+
+    public:
+        //! construction
+        rwlock() {
+            pthread_rwlockattr_t attr;
+            pthread_rwlockattr_init(&attr);
+#if defined(__GLIBC__)
+            pthread_rwlockattr_setkind_np(&attr, 
+                    PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+
+            if (pthread_rwlock_init(&lock, &attr) != 0)
+                throw std::runtime_error("[rwlock] pthread_rwlock_init failed!");
+
+            pthread_rwlockattr_destroy(&attr);
+        }
+
+        //! destruction
+        ~rwlock() { pthread_rwlock_destroy(&lock); }
+
+        void lock_shared()   { pthread_rwlock_rdlock(&lock); }
+        void unlock_shared() { pthread_rwlock_unlock(&lock); }
+        void lock_exclusive()   { pthread_rwlock_wrlock(&lock); }
+        void unlock_exclusive() { pthread_rwlock_unlock(&lock); }
+
+        //! scoped shared lock
+        class read_guard {
+            private:
+                read_guard(const read_guard&);
+                read_guard& operator=(const read_guard&);
+
+                rwlock& l;
+
+            public:
+                read_guard(rwlock& l) : l(l) { l.lock_shared(); }
+                ~read_guard() { l.unlock_shared(); }
+        };
+
+        //! scoped exclusive lock
+        class write_guard {
+            private:
+                write_guard(const write_guard&);
+                write_guard& operator=(const write_guard&);
+
+                rwlock& l;
+
+            public:
+                write_guard(rwlock& l) : l(l) { l.lock_exclusive(); }
+                ~write_guard() { l.unlock_exclusive(); }
+        };
+};
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__RWLOCK_H
+
@@ -0,0 +1,121 @@
+//! robotkernel service descriptor
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/service_descriptor.h"
+
+#include "yaml-cpp/yaml.h"
+
+using namespace std;
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! map type name from service definition to field type
+static service_field_type_t field_type(const std::string& type) {
+    static const struct { const char *name; service_field_type_t type; } types[] = {
+        { "string",   service_field_string },
+        { "double",   service_field_double },
+        { "float",    service_field_float },
+        { "int8_t",   service_field_int8 },
+        { "uint8_t",  service_field_uint8 },
+        { "int16_t",  service_field_int16 },
+        { "uint16_t", service_field_uint16 },
+        { "int32_t",  service_field_int32 },
+        { "uint32_t", service_field_uint32 },
+        { "int64_t",  service_field_int64 },
+        { "uint64_t", service_field_uint64 },
+    };
+
+    for (const auto& t : types)
+        if (type == t.name)
+            return t.type;
+
+    return service_field_unknown;
+}
+
+//! parse one section of a service definition
+static void parse_fields(const YAML::Node& section, service_fields_t& fields) {
+    if (!section)
+        return;
+
+    for (const auto& entry : section) {
+        for (const auto& kv : entry) {
+            service_field_descriptor f;
+            f.type_name = kv.first.as<string>();
+            f.name      = kv.second.as<string>();
+            f.is_array  = f.type_name.compare(0, 7, "vector/") == 0;
+            f.type      = field_type(f.is_array ? f.type_name.substr(7) : f.type_name);
+            f.offset    = fields.size();
+            fields.push_back(f);
+        }
+    }
+}
+
+//! find field by name
+static const service_field_descriptor *find_field(const service_fields_t& fields, 
+        const std::string& name) {
+    for (const auto& f : fields)
+        if (f.name == name)
+            return &f;
+
+    return NULL;
+}
+
+//! parse service definition
+/*!
+ * \param[in] definition    Service definition (yaml).
+ * \return descriptor
+ */
+sp_service_descriptor_t service_descriptor::parse(const std::string& definition) {
+    auto desc = make_shared<service_descriptor>();
+
+    YAML::Node doc = YAML::Load(definition);
+    if (doc.IsMap()) {
+        parse_fields(doc["request"], desc->request);
+        parse_fields(doc["response"], desc->response);
+    }
+
+    return desc;
+}
+
+//! find request field by name
+const service_field_descriptor *service_descriptor::find_request(const std::string& name) const {
+    return find_field(request, name);
+}
+
+//! find response field by name
+const service_field_descriptor *service_descriptor::find_response(const std::string& name) const {
+    return find_field(response, name);
+}
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
@@ -0,0 +1,381 @@
+//! robotkernel service executor
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/helpers.h"
+#include "robotkernel/kernel_clock.h"
+#include "robotkernel/cpu_affinity.h"
+
+// private headers
+#include "service_executor.h"
+#include "kernel.h"
+
+using namespace std;
+using namespace robotkernel;
+
+static thread_local bool _in_worker = false;
+
+//! worker construction
+/*!
+ * \param[in] exec      Owning executor.
+ * \param[in] prio      Worker thread priority.
+ * \param[in] cpu       CPU to pin worker to, -1 for no pinning.
+ */
+service_executor::worker::worker(service_executor& exec, int prio, int cpu) :
+    runnable(prio, cpu_affinity(), cpu < 0 ?
+            string("rk:svc_exec") : string_printf("rk:svc_exec.cpu%d", cpu)),
+    exec(exec)
+{
+    if (cpu >= 0) {
+        cpu_affinity affinity;
+        affinity.set(cpu);
+        set_affinity(affinity);
+    }
+
+    start();
+}
+
+//! worker destruction
+service_executor::worker::~worker() {
+    {
+        std::unique_lock<std::mutex> lock(exec.mtx);
+        run_flag = false;
+        exec.cond_work.notify_all();
+    }
+
+    join();
+}
+
+//! handler function called if thread is running
+void service_executor::worker::run() {
+    _in_worker = true;
+    job j;
+
+    while (running() && exec.next(j)) {
+        service_arglist_t resp;
+        std::exception_ptr ex;
+        int ret = 0;
+
+        try {
+            if (j.task)
+                j.task();
+            else
+                ret = j.svc->handler(j.req, resp);
+        } catch (...) {
+            ex = std::current_exception();
+        }
+
+        // release owner before completion, caller may call again
+        exec.finished(j);
+
+        try {
+            if (j.done)
+                j.done(ret, resp, ex);
+        } catch (const exception& e) {
+            RK_LOG(kernel::instance, error, "[service_executor] completion of %s.%s "
+                    "threw exception: %s\n", j.svc->owner.c_str(), j.svc->name.c_str(), e.what());
+        }
+
+        j = job();
+    }
+}
+
+//! construction with yaml node
+/*!
+ * \param[in] node  Executor configuration, may contain
+ *                  workers, prio, cpus and queue_len.
+ */
+service_executor::service_executor(const YAML::Node& node) :
+    stopping(false)
+{
+    int prio  = get_as<int>(node, "prio", 0);
+    queue_len = get_as<size_t>(node, "queue_len", 256);
+
+    if (queue_len == 0)
+        throw runtime_error(string_printf("[service_executor] queue_len has to be > 0!\n"));
+
+    if (node["cpus"]) {
+        cpu_affinity cpus(node["cpus"]);
+
+        for (int cpu = cpus.first(); cpu != -1; cpu = cpus.next(cpu))
+            workers.push_back(make_shared<worker>(*this, prio, cpu));
+    } else {
+        int cnt = get_as<int>(node, "workers", 2);
+
+        for (int i = 0; i < cnt; ++i)
+            workers.push_back(make_shared<worker>(*this, prio, -1));
+    }
+
+    if (workers.empty())
+        throw runtime_error(string_printf("[service_executor] need at least one worker!\n"));
+
+    kernel::instance.log(info, "[service_executor] created with %d workers, queue length %d\n",
+            (int)workers.size(), (int)queue_len);
+}
+
+//! destruction, pending jobs are completed with an exception
+service_executor::~service_executor() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        stopping = true;
+        cond_space.notify_all();
+    }
+
+    workers.clear();
+
+    std::deque<job> left;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        left.swap(queue);
+    }
+
+    for (auto& j : left) {
+        service_arglist_t resp;
+        
+        try {
+            throw runtime_error(string_printf("[service_executor] stopped before "
+                        "%s.%s was called!\n", j.svc->owner.c_str(), j.svc->name.c_str()));
+        } catch (...) {
+            if (j.done)
+                j.done(0, resp, std::current_exception());
+        }
+    }
+}
+
+//! take next runnable job, returns false if stopping
+bool service_executor::next(job& j) {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (!stopping) {
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (it->svc->dispatch == service_dispatch_serialized) {
+                if (!busy.insert(std::make_pair(it->svc->owner, 
+                                std::this_thread::get_id())).second)
+                    continue;   // owner has a running call
+            }
+
+            j = std::move(*it);
+            queue.erase(it);
+            cond_space.notify_one();
+
+            service_queue_stats& st = stats[j.svc->owner + "." + j.svc->name];
+            uint64_t wait_ns = kernel_clock::now_ns() - j.enqueue_ns;
+            st.total_wait_ns += wait_ns;
+            if (wait_ns > st.max_wait_ns)
+                st.max_wait_ns = wait_ns;
+
+            return true;
+        }
+
+        cond_work.wait(lock);
+    }
+
+    return false;
+}
+
+//! finish job, release owner
+void service_executor::finished(const job& j) {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    stats[j.svc->owner + "." + j.svc->name].pending--;
+
+    if (j.svc->dispatch == service_dispatch_serialized)
+        release(j.svc->owner);
+}
+
+//! release owner of serialized call, mtx has to be locked
+void service_executor::release(const std::string& owner) {
+    busy.erase(owner);
+
+    // nested calls may wait for this owner
+    if (!waiting.empty())
+        cond_owner.notify_all();
+
+    // calls of this owner may have been skipped
+    if (!queue.empty())
+        cond_work.notify_one();
+}
+
+//! queue service call
+/*!
+ * \param[in] svc       Service to call.
+ * \param[in] req       Service request parameters.
+ * \param[in] done      Completion, called from worker thread.
+ * \param[in] block     Wait for queue space, otherwise throw if full.
+ */
+void service_executor::submit(sp_service_t svc, const service_arglist_t& req, 
+        completion_t done, bool block) {
+    job j;
+    j.svc  = svc;
+    j.req  = req;
+    j.done = done;
+
+    enqueue(std::move(j), block);
+}
+
+//! queue typed in-process service call
+/*!
+ * \param[in] svc       Service to call.
+ * \param[in] task      Calls typed service handler.
+ * \param[in] done      Completion, called from worker thread 
+ *                      with empty response.
+ * \param[in] block     Wait for queue space, otherwise throw if full.
+ */
+void service_executor::submit(sp_service_t svc, std::function<void()> task,
+        completion_t done, bool block) {
+    job j;
+    j.svc  = svc;
+    j.task = task;
+    j.done = done;
+
+    enqueue(std::move(j), block);
+}
+
+//! run service call of a worker on the calling thread
+/*!
+ * Queueing and waiting from a worker could dead-lock the pool.
+ * A serialized service claims its owner like a queued call and
+ * waits while another thread runs a call of that owner. Calls of
+ * an owner already claimed by the calling thread run directly.
+ * Throws if waiting would close a cycle of nested calls.
+ *
+ * \param[in] svc       Service to call.
+ * \param[in] call      Calls service handler.
+ */
+void service_executor::run_nested(const sp_service_t& svc, const std::function<void()>& call) {
+    if (svc->dispatch != service_dispatch_serialized) {
+        call();
+        return;
+    }
+
+    const std::string& owner = svc->owner;
+    std::thread::id self = std::this_thread::get_id();
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        busy_map_t::iterator it;
+
+        while ((it = busy.find(owner)) != busy.end()) {
+            if (it->second == self) {
+                // nested call of the owner we are already running
+                lock.unlock();
+                call();
+                return;
+            }
+
+            // follow waiting threads, we must not end up waiting for ourselves
+            for (std::thread::id holder = it->second; ; ) {
+                auto w = waiting.find(holder);
+                if (w == waiting.end())
+                    break;
+
+                busy_map_t::const_iterator b = busy.find(w->second);
+                if (b == busy.end())
+                    break;
+
+                if ((holder = b->second) == self)
+                    throw runtime_error(string_printf("[service_executor] cyclic nested "
+                                "call of serialized service %s.%s!\n", 
+                                owner.c_str(), svc->name.c_str()));
+            }
+
+            waiting[self] = owner;
+            cond_owner.wait(lock);
+            waiting.erase(self);
+        }
+
+        busy[owner] = self;
+    }
+
+    try {
+        call();
+    } catch (...) {
+        std::unique_lock<std::mutex> lock(mtx);
+        release(owner);
+        throw;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx);
+    release(owner);
+}
+
+//! append job to queue
+/*!
+ * \param[in] j         Job to run.
+ * \param[in] block     Wait for queue space, otherwise throw if full.
+ */
+void service_executor::enqueue(job&& j, bool block) {
+    const sp_service_t& svc = j.svc;
+    std::unique_lock<std::mutex> lock(mtx);
+    service_queue_stats& st = stats[svc->owner + "." + svc->name];
+
+    if (!stopping && (queue.size() >= queue_len)) {
+        if (!block) {
+            st.rejected++;
+            throw runtime_error(string_printf("[service_executor] queue full, rejected "
+                        "call of %s.%s!\n", svc->owner.c_str(), svc->name.c_str()));
+        }
+
+        st.blocked++;
+        cond_space.wait(lock, [this] { return stopping || (queue.size() < queue_len); });
+    }
+
+    if (stopping)
+        throw runtime_error(string_printf("[service_executor] stopped, cannot call "
+                    "%s.%s!\n", svc->owner.c_str(), svc->name.c_str()));
+
+    st.calls++;
+    if (++st.pending > st.max_pending)
+        st.max_pending = st.pending;
+
+    j.enqueue_ns = kernel_clock::now_ns();
+    queue.push_back(std::move(j));
+
+    cond_work.notify_one();
+}
+
+//! get queueing statistics of service
+/*!
+ * \param[in]  name     Service name "owner.name".
+ * \param[out] st       Statistics.
+ * \return false if service was never queued
+ */
+bool service_executor::get_stats(const std::string& name, service_queue_stats& st) {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    stats_map_t::const_iterator it = stats.find(name);
+    if (it == stats.end())
+        return false;
+
+    st = it->second;
+    return true;
+}
+
+//! true if calling thread is a worker of any executor
+bool service_executor::in_worker() {
+    return _in_worker;
+}
+
@@ -0,0 +1,205 @@
+//! robotkernel service executor
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__SERVICE_EXECUTOR_H
+#define ROBOTKERNEL__SERVICE_EXECUTOR_H
+
+#include <string>
+#include <deque>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+
+// public headers
+#include "robotkernel/runnable.h"
+#include "robotkernel/service.h"
+
+#include "yaml-cpp/yaml.h"
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! queueing statistics of one service
+struct service_queue_stats {
+    uint64_t calls;             //!< queued calls
+    uint64_t blocked;           //!< synchronous calls which waited for queue space
+    uint64_t rejected;          //!< asynchronous calls rejected because queue was full
+    uint64_t pending;           //!< calls currently queued or running
+    uint64_t max_pending;       //!< high water mark of pending
+    uint64_t total_wait_ns;     //!< sum of queueing delays
+    uint64_t max_wait_ns;       //!< longest queueing delay
+};
+
+//! service worker pool
+/*!
+ * Executes services registered with dispatch mode async or serialized on
+ * a pool of worker threads. Calls are taken from one bounded queue in 
+ * arrival order, a serialized call is skipped while another call of the
+ * same owner is running. Synchronous callers wait for queue space, 
+ * asynchronous callers are rejected if the queue is full.
+ */
+class service_executor {
+    public:
+        //! completion of a queued call
+        /*!
+         * \param ret   Return value of service handler, 0 for typed calls.
+         * \param resp  Service response parameters.
+         * \param ex    Exception thrown by service handler, NULL on success.
+         */
+        typedef std::function<void(int ret, service_arglist_t& resp, 
+                std::exception_ptr ex)> completion_t;
+
+    private:
+        service_executor(const service_executor&);             // prevent copy-construction
+        service_executor& operator=(const service_executor&);  // prevent assignment
+
+        class worker : public runnable {
+            public:
+                worker(service_executor& exec, int prio, int cpu);
+                ~worker();
+
+                //! handler function called if thread is running
+                void run();
+
+            private:
+                service_executor& exec;
+        };
+
+        typedef std::shared_ptr<worker> sp_worker_t;
+
+        struct job {
+            sp_service_t svc;
+            service_arglist_t req;
+            std::function<void()> task;         //!< typed call, replaces handler
+            completion_t done;
+            uint64_t enqueue_ns;
+        };
+
+        std::mutex              mtx;            //!< protects queue, busy and stats
+        std::condition_variable cond_work;      //!< signals new jobs to workers
+        std::condition_variable cond_space;     //!< signals free queue space
+        std::condition_variable cond_owner;     //!< signals released owners to nested calls
+
+        std::deque<job> queue;                  //!< pending jobs in arrival order
+        size_t queue_len;                       //!< maximum number of pending jobs
+        bool stopping;
+
+        typedef std::map<std::string, std::thread::id> busy_map_t;
+        busy_map_t busy;                        //!< owners with running serialized call, 
+                                                //!< by running thread
+        std::map<std::thread::id, std::string> waiting; //!< owner a nested call waits for
+
+        //! release owner of serialized call, mtx has to be locked
+        void release(const std::string& owner);
+
+        typedef std::unordered_map<std::string, service_queue_stats> stats_map_t;
+        stats_map_t stats;                      //!< stats by "owner.name"
+
+        std::vector<sp_worker_t> workers;
+
+        //! take next runnable job, returns false if stopping
+        bool next(job& j);
+
+        //! finish job, release owner
+        void finished(const job& j);
+
+        //! append job to queue
+        /*!
+         * \param[in] j         Job to run.
+         * \param[in] block     Wait for queue space, otherwise throw if full.
+         */
+        void enqueue(job&& j, bool block);
+
+    public:
+        //! construction with yaml node
+        /*!
+         * \param[in] node  Executor configuration, may contain
+         *                  workers, prio, cpus and queue_len.
+         */
+        service_executor(const YAML::Node& node);
+
+        //! destruction, pending jobs are completed with an exception
+        ~service_executor();
+
+        //! queue service call
+        /*!
+         * \param[in] svc       Service to call.
+         * \param[in] req       Service request parameters.
+         * \param[in] done      Completion, called from worker thread.
+         * \param[in] block     Wait for queue space, otherwise throw if full.
+         */
+        void submit(sp_service_t svc, const service_arglist_t& req, 
+                completion_t done, bool block);
+
+        //! queue typed in-process service call
+        /*!
+         * \param[in] svc       Service to call.
+         * \param[in] task      Calls typed service handler.
+         * \param[in] done      Completion, called from worker thread 
+         *                      with empty response.
+         * \param[in] block     Wait for queue space, otherwise throw if full.
+         */
+        void submit(sp_service_t svc, std::function<void()> task,
+                completion_t done, bool block);
+
+        //! run service call of a worker on the calling thread
+        /*!
+         * Queueing and waiting from a worker could dead-lock the pool.
+         * A serialized service claims its owner like a queued call and
+         * waits while another thread runs a call of that owner. Calls of
+         * an owner already claimed by the calling thread run directly.
+         * Throws if waiting would close a cycle of nested calls.
+         *
+         * \param[in] svc       Service to call.
+         * \param[in] call      Calls service handler.
+         */
+        void run_nested(const sp_service_t& svc, const std::function<void()>& call);
+
+        //! get queueing statistics of service
+        /*!
+         * \param[in]  name     Service name "owner.name".
+         * \param[out] st       Statistics.
+         * \return false if service was never queued
+         */
+        bool get_stats(const std::string& name, service_queue_stats& st);
+
+        //! true if calling thread is a worker of any executor
+        static bool in_worker();
+};
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__SERVICE_EXECUTOR_H
+
@@ -0,0 +1,171 @@
+//! robotkernel service argument marshalling
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/helpers.h"
+
+// private headers
+#include "service_marshal.h"
+
+using namespace std;
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! convert yaml scalar to service argument
+static rk_type scalar_to_rk_type(const service_field_descriptor& field, const YAML::Node& node) {
+    bool empty = !node.IsDefined() || node.IsNull();
+
+    // 8 bit types are read as numbers, yaml-cpp reads them as characters
+    switch (field.type) {
+        case service_field_string: return rk_type(empty ? string() : node.as<string>());
+        case service_field_double: return rk_type(empty ? 0. : node.as<double>());
+        case service_field_float:  return rk_type(empty ? 0.f : node.as<float>());
+        case service_field_int8:   return rk_type((int8_t)(empty ? 0 : node.as<int>()));
+        case service_field_uint8:  return rk_type((uint8_t)(empty ? 0 : node.as<unsigned>()));
+        case service_field_int16:  return rk_type(empty ? (int16_t)0 : node.as<int16_t>());
+        case service_field_uint16: return rk_type(empty ? (uint16_t)0 : node.as<uint16_t>());
+        case service_field_int32:  return rk_type(empty ? (int32_t)0 : node.as<int32_t>());
+        case service_field_uint32: return rk_type(empty ? (uint32_t)0 : node.as<uint32_t>());
+        case service_field_int64:  return rk_type(empty ? (int64_t)0 : node.as<int64_t>());
+        case service_field_uint64: return rk_type(empty ? (uint64_t)0 : node.as<uint64_t>());
+        default:
+            break;
+    }
+
+    throw runtime_error(string_printf("unsupported service argument type %s\n", 
+                field.type_name.c_str()));
+}
+
+//! convert yaml node to service argument
+rk_type yaml_to_rk_type(const service_field_descriptor& field, const YAML::Node& node) {
+    if (!field.is_array)
+        return scalar_to_rk_type(field, node);
+
+    std::vector<rk_type> v;
+
+    if (node.IsSequence()) {
+        v.reserve(node.size());
+        for (const auto& elem : node)
+            v.push_back(scalar_to_rk_type(field, elem));
+    } else if (node.IsDefined() && !node.IsNull())
+        throw runtime_error(string_printf("expected sequence for %s\n", field.type_name.c_str()));
+
+    return rk_type(v);
+}
+
+//! emit scalar service argument as yaml
+static void scalar_to_yaml(const service_field_descriptor& field, const rk_type& value, 
+        YAML::Emitter& out) {
+    switch (field.type) {
+        case service_field_string: out << YAML::DoubleQuoted << rk_type_cast<string>(value); break;
+        case service_field_double: out << rk_type_cast<double>(value); break;
+        case service_field_float:  out << rk_type_cast<float>(value); break;
+        case service_field_int8:   out << (int)rk_type_cast<int8_t>(value); break;
+        case service_field_uint8:  out << (unsigned)rk_type_cast<uint8_t>(value); break;
+        case service_field_int16:  out << rk_type_cast<int16_t>(value); break;
+        case service_field_uint16: out << rk_type_cast<uint16_t>(value); break;
+        case service_field_int32:  out << rk_type_cast<int32_t>(value); break;
+        case service_field_uint32: out << rk_type_cast<uint32_t>(value); break;
+        case service_field_int64:  out << (long long)rk_type_cast<int64_t>(value); break;
+        case service_field_uint64: out << (unsigned long long)rk_type_cast<uint64_t>(value); break;
+        default:
+            throw runtime_error(string_printf("unsupported service argument type %s\n", 
+                        field.type_name.c_str()));
+    }
+}
+
+//! emit service argument as yaml
+void rk_type_to_yaml(const service_field_descriptor& field, const rk_type& value, 
+        YAML::Emitter& out) {
+    if (!field.is_array) {
+        scalar_to_yaml(field, value, out);
+        return;
+    }
+
+    const std::vector<rk_type> v = rk_type_cast<std::vector<rk_type> >(value);
+
+    out << YAML::Flow << YAML::BeginSeq;
+    for (const auto& elem : v)
+        scalar_to_yaml(field, elem, out);
+    out << YAML::EndSeq;
+}
+
+//! build request argument list from yaml
+/*!
+ * \param[in]  fields    Request fields.
+ * \param[in]  node      Sequence of values in field order or map 
+ *                       by field name, missing fields are default values.
+ * \param[out] req       Request argument list.
+ */
+void yaml_to_arglist(const service_fields_t& fields, const YAML::Node& node, 
+        service_arglist_t& req) {
+    req.clear();
+    req.reserve(fields.size());
+
+    if (node.IsSequence() && (node.size() > fields.size()))
+        throw runtime_error(string_printf("got %d arguments, service takes %d\n", 
+                    (int)node.size(), (int)fields.size()));
+
+    for (size_t i = 0; i < fields.size(); ++i) {
+        const service_field_descriptor& f = fields[i];
+        YAML::Node value;
+
+        if (node.IsSequence() && (i < node.size()))
+            value = node[i];
+        else if (node.IsMap() && node[f.name])
+            value = node[f.name];
+
+        req.push_back(yaml_to_rk_type(f, value));
+    }
+}
+
+//! format response argument list as yaml flow map
+/*!
+ * \param[in] fields     Response fields.
+ * \param[in] resp       Response argument list.
+ * \return yaml map by field name
+ */
+std::string arglist_to_yaml(const service_fields_t& fields, const service_arglist_t& resp) {
+    YAML::Emitter out;
+    out << YAML::Flow << YAML::BeginMap;
+
+    for (size_t i = 0; (i < fields.size()) && (i < resp.size()); ++i) {
+        out << YAML::Key << fields[i].name << YAML::Value;
+        rk_type_to_yaml(fields[i], resp[i], out);
+    }
+
+    out << YAML::EndMap;
+    return out.c_str();
+}
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
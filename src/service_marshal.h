@@ -0,0 +1,84 @@
+//! robotkernel service argument marshalling
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__SERVICE_MARSHAL_H
+#define ROBOTKERNEL__SERVICE_MARSHAL_H
+
+#include <string>
+#include <vector>
+
+// public headers
+#include "robotkernel/service.h"
+
+#include "yaml-cpp/yaml.h"
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! convert yaml node to service argument
+/*!
+ * \param[in] field     Field descriptor.
+ * \param[in] node      Yaml scalar or sequence for array fields.
+ * \return service argument
+ */
+rk_type yaml_to_rk_type(const service_field_descriptor& field, const YAML::Node& node);
+
+//! emit service argument as yaml
+/*!
+ * \param[in] field     Field descriptor.
+ * \param[in] value     Service argument.
+ * \param[in] out       Yaml emitter.
+ */
+void rk_type_to_yaml(const service_field_descriptor& field, const rk_type& value, 
+        YAML::Emitter& out);
+
+//! build request argument list from yaml
+/*!
+ * \param[in]  fields    Request fields.
+ * \param[in]  node      Sequence of values in field order or map 
+ *                       by field name, missing fields are default values.
+ * \param[out] req       Request argument list.
+ */
+void yaml_to_arglist(const service_fields_t& fields, const YAML::Node& node, 
+        service_arglist_t& req);
+
+//! format response argument list as yaml flow map
+/*!
+ * \param[in] fields     Response fields.
+ * \param[in] resp       Response argument list.
+ * \return yaml map by field name
+ */
+std::string arglist_to_yaml(const service_fields_t& fields, const service_arglist_t& resp);
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__SERVICE_MARSHAL_H
+
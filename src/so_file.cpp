@@ -127,6 +127,9 @@ so_file::~so_file() {
     if (so_handle && !kernel::instance._do_not_unload_modules) {
         kernel::instance.log(verbose, "unloading so_file %s\n", file_name.c_str());
 
+        // deferred log records may still point to format strings of the so
+        kernel::instance.rk_log.flush();
+
         if (dlclose(so_handle) != 0)
             kernel::instance.log(error, "error on unloading so_file %s\n", file_name.c_str());
         else
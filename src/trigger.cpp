@@ -28,17 +28,26 @@
 #include "robotkernel/trigger.h"
 #include "robotkernel/trigger_worker.h"
 
+#include "robotkernel/config.h"
+
 // private headers
 #include "kernel.h"
 
 #include <condition_variable>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
 
 using namespace std;
 using namespace robotkernel;
 
 // construction
 trigger::trigger(const std::string& owner, const std::string& name, double rate) 
-    : device(owner, name, "trigger"), rate(rate)
+    : device(owner, name, "trigger"), wait_generation(0), waiters(0), rate(rate)
 {
 }
 
@@ -47,6 +56,7 @@ trigger::~trigger() {
     {
         std::unique_lock<std::mutex> lock(list_mtx);
         triggers.clear();
+        scheduler = nullptr;
     }
 
     for (auto& kv : workers) {
@@ -62,22 +72,50 @@ trigger::~trigger() {
  */
 void trigger::add_trigger(sp_trigger_base_t trigger, 
         bool direct_mode, int worker_prio, int worker_affinity) {
-    trigger_worker::worker_key k = { worker_prio, worker_affinity, trigger->divisor };
+    trigger_worker::worker_key k = { worker_prio, cpu_affinity(worker_affinity), trigger->divisor, 0, 0, 0 };
 
     std::unique_lock<std::mutex> lock(list_mtx);
 
     if (direct_mode) {
         triggers.push_back(trigger);
-        return;
+    } else {
+        if (workers.find(k) == workers.end()) {
+            // create new worker thread
+            workers[k] = make_shared<trigger_worker>(worker_prio, worker_affinity, trigger->divisor);
+            triggers.push_back(workers[k]);
+        }
+
+        workers[k]->add_trigger(trigger);
     }
 
+    if (scheduler)
+        scheduler->rebuild(triggers);
+}
+
+//! add a trigger callback function executed by a worker thread
+/*!
+ * \param[in] trigger       Trigger callback.
+ * \param[in] worker_config Worker configuration, may contain prio,
+ *                          affinity and sched_deadline.
+ */
+void trigger::add_trigger(sp_trigger_base_t trigger, const YAML::Node& worker_config) {
+    runnable_config cfg(worker_config);
+
+    trigger_worker::worker_key k = { cfg.prio, cfg.affinity, trigger->divisor, 
+        cfg.dl_runtime, cfg.dl_deadline, cfg.dl_period };
+
+    std::unique_lock<std::mutex> lock(list_mtx);
+
     if (workers.find(k) == workers.end()) {
         // create new worker thread
-        workers[k] = make_shared<trigger_worker>(worker_prio, worker_affinity, trigger->divisor);
+        workers[k] = make_shared<trigger_worker>(worker_config, trigger->divisor);
         triggers.push_back(workers[k]);
     }
 
     workers[k]->add_trigger(trigger);
+
+    if (scheduler)
+        scheduler->rebuild(triggers);
 }
 
 //! remove a trigger callback function
@@ -100,22 +138,37 @@ void trigger::remove_trigger(sp_trigger_base_t trigger) {
         }
     }
 
+    if (scheduler)
+        scheduler->rebuild(triggers);
+
     robotkernel::kernel::instance.log(verbose, "trigger %s removed\n", id().c_str());
 }
 
 //! wait blocking for next trigger
 void trigger::wait(double timeout) {
-    std::shared_ptr<trigger_waiter> waiter = make_shared<trigger_waiter>();
-    add_trigger(waiter);
-    
-    try {
-        waiter->wait(timeout);
-    } catch (runtime_error& e) {
-        remove_trigger(waiter);
-        throw e;
-    }
-    
-    remove_trigger(waiter);
+    if (!try_wait(timeout))
+        throw runtime_error("timeout waiting for trigger");
+}
+
+//! wait blocking for next trigger
+bool trigger::try_wait(double timeout) {
+    std::unique_lock<std::mutex> lock(wait_mtx);
+    uint64_t generation = wait_generation;
+
+    waiters++;
+    bool triggered = wait_cond.wait_for(lock, std::chrono::nanoseconds(
+                (uint64_t)(timeout * 1000000000)), 
+            [&]() { return wait_generation != generation; });
+    waiters--;
+
+    return triggered;
+}
+
+//! create pollable subscription
+sp_trigger_eventfd_t trigger::subscribe(int divisor) {
+    sp_trigger_eventfd_t sub = make_shared<trigger_eventfd>(divisor);
+    add_trigger(sub);
+    return sub;
 }
 
 //! set rate of trigger device
@@ -129,10 +182,35 @@ void trigger::set_rate(double new_rate) {
     throw runtime_error(string_printf("setting rate not permitted!"));
 }
 
+//! set parallel scheduler for direct mode callbacks
+/*!
+ * \param[in] sched     Scheduler to use, nullptr to execute 
+ *                      callbacks serially in list order.
+ */
+void trigger::set_scheduler(sp_trigger_scheduler_t sched) {
+    std::unique_lock<std::mutex> lock(list_mtx);
+
+    if (sched)
+        sched->rebuild(triggers);
+
+    scheduler = sched;
+}
+
 //! trigger all modules in list
 void trigger::do_trigger() {
     std::unique_lock<std::mutex> lock(list_mtx);
 
+    if (scheduler) {
+        if (scheduler->outdated())
+            scheduler->rebuild(triggers);
+
+        scheduler->execute();
+
+        lock.unlock();
+        notify_waiters();
+        return;
+    }
+
     for (const auto& t : triggers) {
         if (((++t->cnt) % t->divisor) == 0) {
             t->cnt = 0;
@@ -140,5 +218,96 @@ void trigger::do_trigger() {
             t->tick();
         }
     }
+
+    lock.unlock();
+    notify_waiters();
+}
+
+//! wake up threads blocked in wait
+void trigger::notify_waiters() {
+    if (!waiters)
+        return;
+
+    std::unique_lock<std::mutex> lock(wait_mtx);
+    wait_generation++;
+    wait_cond.notify_all();
+}
+
+//! construction
+trigger_eventfd::trigger_eventfd(int divisor) : 
+    trigger_base(divisor)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+    fd = wr_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd == -1)
+        throw runtime_error(string_printf("cannot create eventfd: %s", strerror(errno)));
+#else
+    int fds[2];
+    if (pipe(fds) == -1)
+        throw runtime_error(string_printf("cannot create pipe: %s", strerror(errno)));
+
+    for (int i = 0; i < 2; ++i) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    fd    = fds[0];
+    wr_fd = fds[1];
+#endif
+}
+
+//! destruction
+trigger_eventfd::~trigger_eventfd() {
+    if (wr_fd != fd)
+        close(wr_fd);
+    close(fd);
+}
+
+//! trigger function
+void trigger_eventfd::tick() {
+#ifdef HAVE_SYS_EVENTFD_H
+    uint64_t val = 1;
+    ssize_t local_ret = ::write(wr_fd, &val, sizeof(val));
+#else
+    uint8_t val = 1;
+    ssize_t local_ret = ::write(wr_fd, &val, sizeof(val));
+#endif
+    (void)local_ret; // counter overflow or full pipe, reader is behind anyway
+}
+
+//! consume pending ticks
+uint64_t trigger_eventfd::consume() {
+#ifdef HAVE_SYS_EVENTFD_H
+    uint64_t val = 0;
+    if (::read(fd, &val, sizeof(val)) != sizeof(val))
+        return 0;
+
+    return val;
+#else
+    uint8_t buf[64];
+    uint64_t cnt = 0;
+    ssize_t n;
+
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0)
+        cnt += n;
+
+    return cnt;
+#endif
+}
+
+//! wait blocking for next tick
+bool trigger_eventfd::wait(double timeout) {
+    struct pollfd pfd;
+    pfd.fd      = fd;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+
+    int ret;
+    while (((ret = poll(&pfd, 1, (int)(timeout * 1000))) == -1) && (errno == EINTR)) {}
+
+    if (ret <= 0)
+        return false;
+
+    return consume() != 0;
 }
 
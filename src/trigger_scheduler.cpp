@@ -0,0 +1,402 @@
+//! robotkernel trigger scheduler
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/trigger_scheduler.h"
+#include "robotkernel/process_data.h"
+#include "robotkernel/helpers.h"
+#include "robotkernel/kernel_clock.h"
+
+// private headers
+#include "kernel.h"
+
+#include <set>
+
+using namespace std;
+using namespace robotkernel;
+
+//! check if two sets have at least one common element
+static bool intersects(const set<string>& a, const set<string>& b) {
+    auto it_a = a.begin(), it_b = b.begin();
+
+    while ((it_a != a.end()) && (it_b != b.end())) {
+        if (*it_a < *it_b)
+            ++it_a;
+        else if (*it_b < *it_a)
+            ++it_b;
+        else
+            return true;
+    }
+
+    return false;
+}
+
+//! worker construction
+/*!
+ * \param[in] sched     Owning scheduler.
+ * \param[in] prio      Worker thread priority.
+ * \param[in] cpu       CPU to pin worker to, -1 for no pinning.
+ */
+trigger_scheduler::worker::worker(trigger_scheduler& sched, int prio, int cpu) :
+    runnable(prio, cpu_affinity(), cpu < 0 ?
+            string("rk:tsched") : string_printf("rk:tsched.cpu%d", cpu)),
+    sched(sched)
+{
+    if (cpu >= 0) {
+        cpu_affinity affinity;
+        affinity.set(cpu);
+        set_affinity(affinity);
+    }
+
+    start();
+}
+
+//! worker destruction
+trigger_scheduler::worker::~worker() {
+    {
+        std::unique_lock<std::mutex> lock(sched.mtx);
+        run_flag = false;
+        sched.cond.notify_all();
+    }
+
+    join();
+}
+
+//! handler function called if thread is running
+void trigger_scheduler::worker::run() {
+    std::unique_lock<std::mutex> lock(sched.mtx);
+
+    while (running()) {
+        if (sched.ready.empty()) {
+            sched.cond.wait(lock);
+            continue;
+        }
+
+        sched.process(lock, false);
+    }
+}
+
+//! construction with yaml node
+/*!
+ * \param[in] node  Scheduler configuration, may contain
+ *                  prio, cpus and depends.
+ */
+trigger_scheduler::trigger_scheduler(const YAML::Node& node) :
+    done(0), pd_generation(0)
+{
+    int prio = get_as<int>(node, "prio", 0);
+
+    if (node["depends"]) {
+        for (const auto& kv : node["depends"]) {
+            string cb_name = kv.first.as<string>();
+
+            if (kv.second.Type() == YAML::NodeType::Scalar)
+                depends[cb_name].push_back(kv.second.as<string>());
+            else
+                for (const auto& d : kv.second)
+                    depends[cb_name].push_back(d.as<string>());
+        }
+    }
+
+    if (node["cpus"]) {
+        cpu_affinity cpus(node["cpus"]);
+
+        for (int cpu = cpus.first(); cpu != -1; cpu = cpus.next(cpu))
+            workers.push_back(make_shared<worker>(*this, prio, cpu));
+    } else {
+        int cnt = get_as<int>(node, "workers", 0);
+
+        for (int i = 0; i < cnt; ++i)
+            workers.push_back(make_shared<worker>(*this, prio, -1));
+    }
+
+    kernel::instance.log(info, "[trigger_scheduler] created with %d workers\n",
+            (int)workers.size());
+}
+
+//! destruction
+trigger_scheduler::~trigger_scheduler() {
+    workers.clear();
+}
+
+//! rebuild dependency graph
+/*!
+ * Has to be called whenever the trigger list changes.
+ *
+ * \param[in] triggers  Trigger callbacks in list order.
+ */
+void trigger_scheduler::rebuild(const trigger_list_t& triggers) {
+    vector<sp_trigger_base_t> list(triggers.begin(), triggers.end());
+    int n = list.size();
+
+    // taken before collecting, a concurrent change triggers another rebuild
+    uint64_t generation = process_data::topology_generation;
+
+    // collect process data access of all callbacks
+    vector<set<string> > reads(n), writes(n);
+    vector<bool> known(n, false);
+    auto pds = kernel::instance.get_devices<process_data>();
+
+    for (int i = 0; i < n; ++i) {
+        const auto& t = list[i];
+
+        reads[i]  = t->reads;
+        writes[i] = t->writes;
+
+        if (t->name != "") {
+            for (const auto& pd : pds) {
+                if (pd->provider && (pd->provider->name == t->name))
+                    writes[i].insert(pd->id());
+                if (pd->consumer && (pd->consumer->name == t->name))
+                    reads[i].insert(pd->id());
+            }
+        }
+
+        known[i] = !reads[i].empty() || !writes[i].empty() ||
+            ((t->name != "") && (depends.find(t->name) != depends.end()));
+    }
+
+    // derive edges, callbacks without any information stay in list order
+    vector<set<int> > succ(n);
+    vector<int> in_degree(n, 0);
+
+    auto add_edge = [&](int from, int to) {
+        if (succ[from].insert(to).second)
+            in_degree[to]++;
+    };
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 1; j < n; ++j) {
+            if (    !known[i] || !known[j] ||
+                    intersects(writes[i], reads[j]) ||
+                    intersects(reads[i], writes[j]) ||
+                    intersects(writes[i], writes[j]))
+                add_edge(i, j);
+        }
+    }
+
+    for (int j = 0; j < n; ++j) {
+        if (list[j]->name == "")
+            continue;
+
+        auto it = depends.find(list[j]->name);
+        if (it == depends.end())
+            continue;
+
+        for (const auto& pred_name : it->second)
+            for (int i = 0; i < n; ++i)
+                if ((i != j) && (list[i]->name == pred_name))
+                    add_edge(i, j);
+    }
+
+    // topological sort, prefer list order
+    vector<int> order, pos(n);
+    set<int> roots;
+    for (int i = 0; i < n; ++i)
+        if (in_degree[i] == 0)
+            roots.insert(i);
+
+    while (!roots.empty()) {
+        int i = *roots.begin();
+        roots.erase(roots.begin());
+
+        pos[i] = order.size();
+        order.push_back(i);
+
+        for (int j : succ[i])
+            if (--in_degree[j] == 0)
+                roots.insert(j);
+    }
+
+    if ((int)order.size() != n)
+        throw runtime_error(string_printf("[trigger_scheduler] cyclic dependencies "
+                    "between trigger callbacks!"));
+
+    std::unique_lock<std::mutex> lock(mtx);
+
+    pd_generation = generation;
+
+    // keep measured execution times of known callbacks
+    map<trigger_base *, uint64_t> exec_times;
+    for (const auto& nd : nodes)
+        exec_times[nd.t.get()] = nd.exec_ns;
+
+    nodes.clear();
+    nodes.resize(n);
+
+    for (int k = 0; k < n; ++k) {
+        int i = order[k];
+        node& nd = nodes[k];
+
+        nd.t        = list[i];
+        nd.fire     = false;
+        nd.n_preds  = 0;
+        nd.pending  = 0;
+        nd.exec_ns  = 1;
+        nd.rank     = 0;
+
+        auto it = exec_times.find(nd.t.get());
+        if (it != exec_times.end())
+            nd.exec_ns = it->second;
+
+        for (int j : succ[i])
+            nd.successors.push_back(pos[j]);
+    }
+
+    for (const auto& nd : nodes)
+        for (int s : nd.successors)
+            nodes[s].n_preds++;
+
+    ready.clear();
+    ready.reserve(n);
+    update_ranks();
+
+    kernel::instance.log(verbose, "[trigger_scheduler] rebuilt graph with %d callbacks\n", n);
+}
+
+//! true if process data topology changed since last rebuild
+bool trigger_scheduler::outdated() const {
+    return pd_generation != process_data::topology_generation;
+}
+
+//! recalculate upward ranks from measured execution times
+void trigger_scheduler::update_ranks() {
+    for (int k = (int)nodes.size() - 1; k >= 0; --k) {
+        node& nd = nodes[k];
+        uint64_t max_succ = 0;
+
+        for (int s : nd.successors)
+            max_succ = std::max(max_succ, nodes[s].rank);
+
+        nd.rank = nd.exec_ns + max_succ;
+    }
+}
+
+//! run ready nodes of current cycle until none is left
+/*!
+ * \param[in] lock      Locked cycle mutex.
+ * \param[in] wait      Wait for more ready nodes until cycle finished.
+ */
+void trigger_scheduler::process(std::unique_lock<std::mutex>& lock, bool wait) {
+    while (true) {
+        if (ready.empty()) {
+            if (!wait || (done == (int)nodes.size()))
+                return;
+
+            cond.wait(lock);
+            continue;
+        }
+
+        // pick ready node with longest remaining critical path
+        size_t best = 0;
+        for (size_t r = 1; r < ready.size(); ++r)
+            if (nodes[ready[r]].rank > nodes[ready[best]].rank)
+                best = r;
+
+        int k = ready[best];
+        ready[best] = ready.back();
+        ready.pop_back();
+
+        node& nd = nodes[k];
+
+        if (nd.fire) {
+            lock.unlock();
+
+            uint64_t start = kernel_clock::now_ns();
+            std::exception_ptr ex;
+            try {
+                nd.t->tick();
+            } catch (...) {
+                ex = std::current_exception();
+            }
+            uint64_t dur = kernel_clock::now_ns() - start;
+
+            lock.lock();
+            nd.exec_ns = ((nd.exec_ns * 7) + dur) / 8;
+
+            // rethrown by execute after the barrier
+            if (ex && !error)
+                error = ex;
+        }
+
+        bool notify = false;
+        for (int s : nd.successors) {
+            if (--nodes[s].pending == 0) {
+                ready.push_back(s);
+                notify = true;
+            }
+        }
+
+        if (++done == (int)nodes.size())
+            notify = true;
+
+        if (notify)
+            cond.notify_all();
+    }
+}
+
+//! execute one cycle
+/*!
+ * Runs all callbacks whose divisor matches and returns after all of
+ * them have finished.
+ */
+void trigger_scheduler::execute() {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (nodes.empty())
+        return;
+
+    done = 0;
+
+    for (int k = 0; k < (int)nodes.size(); ++k) {
+        node& nd = nodes[k];
+        const auto& t = nd.t;
+
+        nd.fire = false;
+        if (((++t->cnt) % t->divisor) == 0) {
+            t->cnt = 0;
+            nd.fire = true;
+        }
+
+        nd.pending = nd.n_preds;
+        if (nd.pending == 0)
+            ready.push_back(k);
+    }
+
+    cond.notify_all();
+
+    // caller takes part and joins at the barrier
+    process(lock, true);
+
+    update_ranks();
+
+    if (error) {
+        std::exception_ptr ex = error;
+        error = nullptr;
+        std::rethrow_exception(ex);
+    }
+}
+
@@ -26,10 +26,13 @@
 
 // public headers
 #include "robotkernel/trigger_worker.h"
+#include "robotkernel/kernel_clock.h"
 
 // private headers
 #include "kernel.h"
 
+#include <time.h>
+
 using namespace std;
 using namespace robotkernel;
 
@@ -41,7 +44,7 @@ bool trigger_worker::worker_key::operator<(const worker_key& a) const {
 
     if (affinity < a.affinity)
         return true;
-    if (affinity > a.affinity)
+    if (a.affinity < affinity)
         return false;
 
     if (divisor < a.divisor)
@@ -49,23 +52,65 @@ bool trigger_worker::worker_key::operator<(const worker_key& a) const {
     if (divisor > a.divisor)
         return false;
 
-    return (int) divisor < (int)a.divisor;
+    if (dl_runtime != a.dl_runtime)
+        return dl_runtime < a.dl_runtime;
+    if (dl_deadline != a.dl_deadline)
+        return dl_deadline < a.dl_deadline;
+
+    return dl_period < a.dl_period;
+}
+
+static uint64_t get_ns(clockid_t clk) {
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
 }
 
 trigger_worker::trigger_worker(int prio, int affinity_mask, int divisor) :
     runnable(prio, affinity_mask, string_printf("trigger_worker.prio_%d."
                 "affinity_mask_%d.divisor_%d", prio, affinity_mask, divisor)), 
-    trigger_base(divisor) 
+    trigger_base(divisor), release_ns(0)
 {
     // start worker thread
     start();
     kernel::instance.log(info, "[trigger_worker] created with prio %d\n", prio);
 };
+
+//! construction with yaml node
+/*!
+ * \param[in] node      Worker configuration, may contain prio, 
+ *                      affinity, thread_name and sched_deadline.
+ * \param[in] divisor   Rate divisor.
+ */
+trigger_worker::trigger_worker(const YAML::Node& node, int divisor) :
+    runnable(node), trigger_base(divisor), release_ns(0)
+{
+    if (thread_name == "runnable")
+        thread_name = string_printf("trigger_worker.prio_%d.affinity_%s.divisor_%d", 
+                get_prio(), get_affinity().empty() ? "none" : get_affinity().to_string().c_str(), 
+                divisor);
+
+    // start worker thread
+    start();
+
+    if (get_dl_period())
+        kernel::instance.log(info, "[trigger_worker] created with SCHED_DEADLINE "
+                "runtime %llu ns, period %llu ns\n", (unsigned long long)get_dl_runtime(),
+                (unsigned long long)get_dl_period());
+    else
+        kernel::instance.log(info, "[trigger_worker] created with prio %d\n", get_prio());
+}
         
 //! destruction
 trigger_worker::~trigger_worker() {
     // stop worker thread
     stop();
+
+    if (get_deadline_misses() || get_runtime_overruns())
+        RK_LOG(kernel::instance, warning, "[trigger_worker] %s: %llu deadline misses, "
+                "%llu runtime overruns\n", thread_name.c_str(), 
+                (unsigned long long)get_deadline_misses(),
+                (unsigned long long)get_runtime_overruns());
     kernel::instance.log(info, "[trigger_worker] destructed\n");
 }
 
@@ -107,8 +152,19 @@ void trigger_worker::run() {
         if (cond.wait_for(lock, std::chrono::seconds(1)) == std::cv_status::timeout)
             continue;
 
+        if (!get_dl_period()) {
+            for (const auto& t : triggers)
+                t->tick();
+
+            continue;
+        }
+
+        uint64_t cpu_start = get_ns(CLOCK_THREAD_CPUTIME_ID);
+
         for (const auto& t : triggers)
             t->tick();
+
+        account_job(release_ns, get_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start);
     }
         
     kernel::instance.log(info, "[trigger_worker] finished worker thread\n");
@@ -117,6 +173,9 @@ void trigger_worker::run() {
 //! trigger worker
 void trigger_worker::tick() {
     // there's no need to lock 'mtx' here, it's only used to protect trigger list
+    if (get_dl_period())
+        release_ns = kernel_clock::now_ns();
+
     cond.notify_all();
 }
 
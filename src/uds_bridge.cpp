@@ -0,0 +1,598 @@
+//! robotkernel unix domain socket bridge
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// public headers
+#include "robotkernel/helpers.h"
+
+// private headers
+#include "kernel.h"
+#include "uds_bridge.h"
+
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+using namespace std;
+using namespace robotkernel;
+
+//! bytes read from one client before returning to the reactor
+static const size_t uds_max_read_per_wakeup = 256 * 1024;
+
+//! decode scalar argument
+static rk_type get_scalar(const service_field_descriptor& f, uds_reader& r) {
+    switch (f.type) {
+        case service_field_string: return rk_type(r.get_string());
+        case service_field_double: return rk_type(r.get<double>());
+        case service_field_float:  return rk_type(r.get<float>());
+        case service_field_int8:   return rk_type(r.get<int8_t>());
+        case service_field_uint8:  return rk_type(r.get<uint8_t>());
+        case service_field_int16:  return rk_type(r.get<int16_t>());
+        case service_field_uint16: return rk_type(r.get<uint16_t>());
+        case service_field_int32:  return rk_type(r.get<int32_t>());
+        case service_field_uint32: return rk_type(r.get<uint32_t>());
+        case service_field_int64:  return rk_type(r.get<int64_t>());
+        case service_field_uint64: return rk_type(r.get<uint64_t>());
+        default:
+            break;
+    }
+
+    throw runtime_error(string_printf("unsupported service argument type %s\n", 
+                f.type_name.c_str()));
+}
+
+//! encode scalar argument, empty value encodes default
+static void put_scalar(const service_field_descriptor& f, const rk_type *v, uds_writer& w) {
+    switch (f.type) {
+        case service_field_string: w.put_string(v ? rk_type_cast<string>(*v) : string()); break;
+        case service_field_double: w.put<double>(v ? rk_type_cast<double>(*v) : 0.); break;
+        case service_field_float:  w.put<float>(v ? rk_type_cast<float>(*v) : 0.f); break;
+        case service_field_int8:   w.put<int8_t>(v ? rk_type_cast<int8_t>(*v) : 0); break;
+        case service_field_uint8:  w.put<uint8_t>(v ? rk_type_cast<uint8_t>(*v) : 0); break;
+        case service_field_int16:  w.put<int16_t>(v ? rk_type_cast<int16_t>(*v) : 0); break;
+        case service_field_uint16: w.put<uint16_t>(v ? rk_type_cast<uint16_t>(*v) : 0); break;
+        case service_field_int32:  w.put<int32_t>(v ? rk_type_cast<int32_t>(*v) : 0); break;
+        case service_field_uint32: w.put<uint32_t>(v ? rk_type_cast<uint32_t>(*v) : 0); break;
+        case service_field_int64:  w.put<int64_t>(v ? rk_type_cast<int64_t>(*v) : 0); break;
+        case service_field_uint64: w.put<uint64_t>(v ? rk_type_cast<uint64_t>(*v) : 0); break;
+        default:
+            throw runtime_error(string_printf("unsupported service argument type %s\n", 
+                        f.type_name.c_str()));
+    }
+}
+
+//! decode request arguments
+static void decode_args(const service_fields_t& fields, uds_reader& r, service_arglist_t& args) {
+    args.reserve(fields.size());
+
+    for (const auto& f : fields) {
+        if (!f.is_array) {
+            args.push_back(get_scalar(f, r));
+            continue;
+        }
+
+        uint32_t cnt = r.get<uint32_t>();
+        std::vector<rk_type> v;
+        v.reserve(std::min(cnt, 4096u));
+
+        for (uint32_t i = 0; i < cnt; ++i)
+            v.push_back(get_scalar(f, r));
+
+        args.push_back(rk_type(v));
+    }
+
+    if (!r.empty())
+        throw runtime_error(string_printf("request has trailing bytes\n"));
+}
+
+//! encode response arguments, missing fields are encoded as defaults
+static void encode_args(const service_fields_t& fields, const service_arglist_t& args, uds_writer& w) {
+    for (const auto& f : fields) {
+        const rk_type *v = f.offset < args.size() ? &args[f.offset] : NULL;
+
+        if (!f.is_array) {
+            put_scalar(f, v, w);
+            continue;
+        }
+
+        if (!v) {
+            w.put<uint32_t>(0);
+            continue;
+        }
+
+        const std::vector<rk_type> elems = rk_type_cast<std::vector<rk_type> >(*v);
+        w.put<uint32_t>(elems.size());
+        for (const auto& e : elems)
+            put_scalar(f, &e, w);
+    }
+}
+
+//! start response frame in buffer
+/*!
+ * \return offset of header, pass to end_frame
+ */
+static size_t begin_frame(std::string& out) {
+    size_t begin = out.size();
+    out.resize(begin + sizeof(uds_frame_header));
+    return begin;
+}
+
+//! finish response frame in buffer
+static void end_frame(std::string& out, size_t begin, uint32_t id, uint16_t type, uint16_t status) {
+    uds_frame_header hdr;
+    hdr.length = out.size() - begin - sizeof(hdr);
+    hdr.id     = id;
+    hdr.type   = type;
+    hdr.status = status;
+    memcpy(&out[begin], &hdr, sizeof(hdr));
+}
+
+//! append error response to buffer
+static void error_frame(std::string& out, uint32_t id, uint16_t type, const std::string& msg) {
+    size_t begin = begin_frame(out);
+    uds_writer(out).put_string(msg);
+    end_frame(out, begin, id, type, uds_status_error);
+}
+
+//! connection destruction
+uds_bridge::connection::~connection() {
+    close(fd);
+}
+
+//! send pending responses without blocking, called with mtx locked
+void uds_bridge::connection::flush() {
+    size_t off = 0;
+
+    while (!closed && (off < out.size())) {
+        ssize_t ret = ::send(fd, out.data() + off, out.size() - off, MSG_NOSIGNAL);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                break;  // client does not read, keep the rest
+
+            drop();     // peer gone
+            return;
+        }
+
+        off += ret;
+    }
+
+    if (closed)
+        return;
+
+    out.erase(0, off);
+
+    if (out.size() > bridge.max_backlog) {
+        bridge.log(warning, "client has %zu unsent bytes, dropping\n", out.size());
+        drop();
+    } else
+        set_writing(!out.empty());
+}
+
+//! let reactor send responses appended by a worker, called with mtx locked
+void uds_bridge::connection::wakeup() {
+    if (closed)
+        return;
+
+    if (out.size() > bridge.max_backlog) {
+        bridge.log(warning, "client has %zu unsent bytes, dropping\n", out.size());
+        drop();
+    } else
+        set_writing(true);
+}
+
+//! wait for socket to become writable or stop, called with mtx locked
+void uds_bridge::connection::set_writing(bool w) {
+    if (closed || (writing == w))
+        return;
+
+    uint32_t events = EPOLLIN;
+    if (w)
+        events |= EPOLLOUT;
+
+    try {
+        bridge.reactor->modify_fd(rfd, events);
+        writing = w;
+    } catch (const exception& e) {
+        bridge.log(error, "%s\n", e.what());
+        drop();
+    }
+}
+
+//! give up on client, reactor notices on next read, called with mtx locked
+void uds_bridge::connection::drop() {
+    closed = true;
+    out.clear();
+    shutdown(fd, SHUT_RDWR);
+}
+
+//! construction
+/*!
+ * \param[in] name      Bridge name.
+ * \param[in] node      Configuration, has to contain path, may contain 
+ *                      mode, group, max_backlog and reactor settings 
+ *                      prio, affinity and max_events.
+ */
+uds_bridge::uds_bridge(const std::string& name, const YAML::Node& node) :
+    bridge_base(name, "uds_bridge", node)
+{
+    path        = get_as<string>(node, "path");
+    max_backlog = get_as<size_t>(node, "max_backlog", 2 * (size_t)uds_max_frame_length);
+
+    // clients can load modules, only the owner may connect by default
+    string mode_str = get_as<string>(node, "mode", "0600");
+    char *end;
+    mode_t mode = strtoul(mode_str.c_str(), &end, 8);
+    if ((*end != '\0') || (mode & ~0777))
+        throw runtime_error(string_printf("[uds_bridge] %s: invalid socket mode %s\n", 
+                    name.c_str(), mode_str.c_str()));
+
+    gid_t gid = (gid_t)-1;
+    if (node["group"]) {
+        string group = get_as<string>(node, "group");
+        struct group *gr = getgrnam(group.c_str());
+        if (!gr)
+            throw runtime_error(string_printf("[uds_bridge] %s: unknown group %s\n", 
+                        name.c_str(), group.c_str()));
+        gid = gr->gr_gid;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(addr.sun_path))
+        throw runtime_error(string_printf("[uds_bridge] %s: socket path too long: %s\n", 
+                    name.c_str(), path.c_str()));
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        throw runtime_error(string_printf("[uds_bridge] %s: socket failed: %s\n", 
+                    name.c_str(), strerror(errno)));
+
+    // only replace a stale socket, never another file
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            close(fd);
+            throw runtime_error(string_printf("[uds_bridge] %s: %s exists and is "
+                        "not a socket\n", name.c_str(), path.c_str()));
+        }
+
+        unlink(path.c_str());
+    }
+
+    // permissions are set before listen, no client can connect earlier
+    if (    (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) || 
+            (chown(path.c_str(), (uid_t)-1, gid) == -1) ||
+            (chmod(path.c_str(), mode) == -1) ||
+            (listen(fd, 64) == -1)) {
+        int err = errno;
+        close(fd);
+        throw runtime_error(string_printf("[uds_bridge] %s: cannot listen on %s: %s\n", 
+                    name.c_str(), path.c_str(), strerror(err)));
+    }
+
+    YAML::Node reactor_node = YAML::Clone(node);
+    reactor_node["name"] = name;
+    reactor.reset(new fd_reactor(reactor_node));
+    reactor->add_fd(fd, nullptr, [this](int fd, uint32_t) { accept_client(fd); });
+
+    log(info, "listening on %s\n", path.c_str());
+}
+
+//! destruction, closes all clients and removes socket
+uds_bridge::~uds_bridge() {
+    reactor->stop();
+
+    // running calls must not wake the reactor any more
+    for (const auto& kv : connections) {
+        std::unique_lock<std::mutex> lock(kv.second->mtx);
+        kv.second->closed = true;
+    }
+
+    reactor.reset();
+    connections.clear();
+
+    unlink(path.c_str());
+}
+
+//! create and register service
+/*!
+ * \param svc robotkernel service struct
+ */
+void uds_bridge::add_service(const robotkernel::service_t &svc) {
+    std::unique_lock<std::mutex> lock(services_mtx);
+    registered.insert(&svc);
+}
+
+//! unregister and remove service 
+/*!
+ * \param svc robotkernel service struct
+ */
+void uds_bridge::remove_service(const robotkernel::service_t &svc) {
+    std::unique_lock<std::mutex> lock(services_mtx);
+    registered.erase(&svc);
+}
+
+//! true if service is still served
+bool uds_bridge::is_registered(const service_t *svc) {
+    std::unique_lock<std::mutex> lock(services_mtx);
+    return registered.find(svc) != registered.end();
+}
+
+//! accept new client
+void uds_bridge::accept_client(int listen_fd) {
+    int fd;
+
+    while ((fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+        // the reactor closes its duplicate on removal, responses of
+        // running calls still go to the original descriptor
+        int rfd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (rfd == -1) {
+            log(error, "dup failed: %s\n", strerror(errno));
+            close(fd);
+            continue;
+        }
+
+        connections[rfd] = make_shared<connection>(*this, fd, rfd);
+        reactor->add_fd(rfd, nullptr, [this](int fd, uint32_t events) {
+                    if (events & EPOLLOUT)
+                        write_client(fd);
+                    if (events & ~EPOLLOUT)
+                        read_client(fd);
+                });
+    }
+
+    if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+        log(error, "accept failed: %s\n", strerror(errno));
+}
+
+//! remove client
+void uds_bridge::close_client(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end())
+        return;
+
+    {
+        // running calls must not wake the reactor for a reused descriptor
+        std::unique_lock<std::mutex> lock(it->second->mtx);
+        it->second->closed = true;
+    }
+
+    connections.erase(it);
+    reactor->remove_fd(fd);
+}
+
+//! send pending responses of client
+void uds_bridge::write_client(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end())
+        return;
+
+    sp_connection_t c = it->second;
+    bool eof;
+
+    {
+        std::unique_lock<std::mutex> lock(c->mtx);
+        c->flush();
+        eof = c->closed;
+    }
+
+    if (eof)
+        close_client(fd);
+}
+
+//! handle all complete frames in receive buffer of client
+/*!
+ * \param[in] c         Client connection.
+ * \return false if client sent an invalid frame
+ */
+bool uds_bridge::handle_frames(const sp_connection_t& c) {
+    size_t pos = 0;
+    bool valid = true;
+
+    while (c->in.size() - pos >= sizeof(uds_frame_header)) {
+        uds_frame_header hdr;
+        memcpy(&hdr, c->in.data() + pos, sizeof(hdr));
+
+        if (hdr.length > uds_max_frame_length) {
+            log(error, "client sent frame of %u bytes, closing\n", hdr.length);
+            valid = false;
+            break;
+        }
+
+        if (c->in.size() - pos - sizeof(hdr) < hdr.length)
+            break;
+
+        handle_request(c, hdr, c->in.data() + pos + sizeof(hdr));
+        pos += sizeof(hdr) + hdr.length;
+    }
+
+    c->in.erase(0, pos);
+    return valid;
+}
+
+//! read requests of client
+/*!
+ * Frames are handled after every recv, at most uds_max_read_per_wakeup 
+ * bytes are read before returning to the reactor. The socket is level 
+ * triggered, so remaining data wakes us up again.
+ */
+void uds_bridge::read_client(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end())
+        return;
+
+    sp_connection_t c = it->second;
+    char buf[65536];
+    bool eof = false;
+    size_t bytes_read = 0;
+
+    {
+        std::unique_lock<std::mutex> lock(c->mtx);
+        c->batching = true;
+    }
+
+    while (bytes_read < uds_max_read_per_wakeup) {
+        ssize_t ret = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if ((ret == -1) && (errno == EINTR))
+            continue;
+
+        if (ret <= 0) {
+            eof = (ret == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK));
+            break;
+        }
+
+        bytes_read += ret;
+        c->in.append(buf, ret);
+
+        if (!handle_frames(c)) {
+            eof = true;
+            break;
+        }
+
+        if (c->in.size() > uds_max_frame_length + sizeof(uds_frame_header)) {
+            log(error, "client has %zu unparsed bytes, closing\n", c->in.size());
+            eof = true;
+            break;
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(c->mtx);
+        c->batching = false;
+        c->flush();
+
+        if (c->closed)
+            eof = true;
+    }
+
+    if (eof)
+        close_client(fd);
+}
+
+//! handle one request
+/*!
+ * \param[in] c         Client connection.
+ * \param[in] hdr       Request header.
+ * \param[in] payload   Request payload.
+ */
+void uds_bridge::handle_request(const sp_connection_t& c, const uds_frame_header& hdr, 
+        const char *payload) {
+    uds_reader r(payload, hdr.length);
+
+    try {
+        switch (hdr.type) {
+            case uds_msg_list: {
+                std::unique_lock<std::mutex> lock(services_mtx);
+                std::unique_lock<std::mutex> out_lock(c->mtx);
+                size_t begin = begin_frame(c->out);
+                uds_writer w(c->out);
+
+                w.put<uint32_t>(registered.size());
+                for (const auto& svc : registered) {
+                    w.put_string(svc->owner);
+                    w.put_string(svc->name);
+                }
+
+                end_frame(c->out, begin, hdr.id, hdr.type, uds_status_ok);
+                return;
+            }
+            case uds_msg_resolve: {
+                string owner = r.get_string();
+                string name  = r.get_string();
+                sp_service_t svc = kernel::instance.get_service(owner, name);
+
+                uint32_t handle = 0;
+                while ((handle < c->handles.size()) && (c->handles[handle] != svc))
+                    handle++;
+                if (handle == c->handles.size())
+                    c->handles.push_back(svc);
+
+                std::unique_lock<std::mutex> out_lock(c->mtx);
+                size_t begin = begin_frame(c->out);
+                uds_writer w(c->out);
+                w.put<uint32_t>(handle);
+                w.put_string(svc->service_definition);
+                end_frame(c->out, begin, hdr.id, hdr.type, uds_status_ok);
+                return;
+            }
+            case uds_msg_call: {
+                uint32_t handle = r.get<uint32_t>();
+                if (handle >= c->handles.size())
+                    throw runtime_error(string_printf("invalid service handle %u\n", handle));
+
+                sp_service_t svc = c->handles[handle];
+                if (!is_registered(svc.get()))
+                    throw runtime_error(string_printf("service \"%s.%s\" was removed!\n", 
+                                svc->owner.c_str(), svc->name.c_str()));
+
+                service_arglist_t req;
+                decode_args(svc->descriptor->request, r, req);
+
+                uint32_t id = hdr.id;
+                kernel::instance.call_service_async(svc, req, 
+                        [c, svc, id](service_arglist_t& resp, std::exception_ptr ex) {
+                    std::unique_lock<std::mutex> lock(c->mtx);
+                    if (c->closed)
+                        return;
+
+                    size_t begin = begin_frame(c->out);
+
+                    try {
+                        if (ex)
+                            std::rethrow_exception(ex);
+
+                        uds_writer w(c->out);
+                        encode_args(svc->descriptor->response, resp, w);
+                        end_frame(c->out, begin, id, uds_msg_call, uds_status_ok);
+                    } catch (const exception& e) {
+                        c->out.resize(begin);
+                        error_frame(c->out, id, uds_msg_call, e.what());
+                    }
+
+                    // reactor sends at the end of its batch or when woken
+                    if (!c->batching)
+                        c->wakeup();
+                });
+                return;
+            }
+            default:
+                throw runtime_error(string_printf("unknown message type %u\n", hdr.type));
+        }
+    } catch (const exception& e) {
+        std::unique_lock<std::mutex> lock(c->mtx);
+        error_frame(c->out, hdr.id, hdr.type, e.what());
+    }
+}
+
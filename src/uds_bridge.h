@@ -0,0 +1,171 @@
+//! robotkernel unix domain socket bridge
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__UDS_BRIDGE_H
+#define ROBOTKERNEL__UDS_BRIDGE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_set>
+#include <mutex>
+#include <memory>
+
+// public headers
+#include "robotkernel/bridge_base.h"
+#include "robotkernel/fd_reactor.h"
+#include "robotkernel/service.h"
+
+// private headers
+#include "uds_protocol.h"
+
+#include "yaml-cpp/yaml.h"
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! built-in unix domain socket bridge
+/*!
+ * Serves all kernel services on a local stream socket using the binary
+ * framing from uds_protocol.h. One reactor thread accepts clients and
+ * reads requests with epoll, inline services are executed on the 
+ * reactor thread, queued services on the service worker pool. Responses
+ * to requests received in one read are sent with one write. Client 
+ * sockets are non-blocking, responses the client does not read yet are
+ * kept and sent by the reactor when the socket becomes writable. Workers
+ * only append responses and wake the reactor.
+ */
+class uds_bridge : public bridge_base {
+    private:
+        uds_bridge(const uds_bridge&);             // prevent copy-construction
+        uds_bridge& operator=(const uds_bridge&);  // prevent assignment
+
+        //! client connection
+        struct connection {
+            uds_bridge& bridge;
+            int fd;                             //!< socket, the reactor owns a duplicate
+            int rfd;                            //!< descriptor registered with the reactor
+            std::string in;                     //!< received bytes, reactor thread only
+            std::vector<sp_service_t> handles;  //!< resolved services, reactor thread only
+
+            std::mutex mtx;                     //!< protects out, batching, writing and closed
+            std::string out;                    //!< pending responses
+            bool batching;                      //!< reactor is processing requests
+            bool writing;                       //!< reactor waits for EPOLLOUT
+            bool closed;                        //!< write failed, drop responses
+
+            connection(uds_bridge& bridge, int fd, int rfd) : bridge(bridge), 
+                fd(fd), rfd(rfd), batching(false), writing(false), closed(false) {}
+            ~connection();
+
+            //! send pending responses without blocking, called with mtx locked
+            void flush();
+
+            //! let reactor send responses appended by a worker, called with mtx locked
+            void wakeup();
+
+            //! wait for socket to become writable or stop, called with mtx locked
+            void set_writing(bool w);
+
+            //! give up on client, reactor notices on next read, called with mtx locked
+            void drop();
+        };
+
+        typedef std::shared_ptr<connection> sp_connection_t;
+        typedef std::map<int, sp_connection_t> connection_map_t;
+
+        std::string path;                       //!< socket path
+        size_t max_backlog;                     //!< clients with more unsent bytes are dropped
+        std::unique_ptr<fd_reactor> reactor;    //!< accepts and reads clients
+        connection_map_t connections;           //!< clients by reactor fd, reactor thread only
+
+        std::mutex services_mtx;                //!< protects registered
+        std::unordered_set<const service_t *> registered;   //!< services served by bridge
+
+        //! accept new client
+        void accept_client(int listen_fd);
+
+        //! read requests of client
+        void read_client(int fd);
+
+        //! handle all complete frames in receive buffer of client
+        bool handle_frames(const sp_connection_t& c);
+
+        //! send pending responses of client
+        void write_client(int fd);
+
+        //! remove client
+        void close_client(int fd);
+
+        //! handle one request
+        /*!
+         * \param[in] c         Client connection.
+         * \param[in] hdr       Request header.
+         * \param[in] payload   Request payload.
+         */
+        void handle_request(const sp_connection_t& c, const uds_frame_header& hdr, 
+                const char *payload);
+
+        //! true if service is still served
+        bool is_registered(const service_t *svc);
+
+    public:
+        //! construction
+        /*!
+         * \param[in] name      Bridge name.
+         * \param[in] node      Configuration, has to contain path, may contain 
+         *                      mode, group, max_backlog and reactor settings 
+         *                      prio, affinity and max_events.
+         */
+        uds_bridge(const std::string& name, const YAML::Node& node);
+
+        //! destruction, closes all clients and removes socket
+        ~uds_bridge();
+
+        //! create and register service
+        /*!
+         * \param svc robotkernel service struct
+         */
+        void add_service(const robotkernel::service_t &svc);
+
+        //! unregister and remove service 
+        /*!
+         * \param svc robotkernel service struct
+         */
+        void remove_service(const robotkernel::service_t &svc);
+};
+
+typedef std::shared_ptr<uds_bridge> sp_uds_bridge_t;
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__UDS_BRIDGE_H
+
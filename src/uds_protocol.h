@@ -0,0 +1,134 @@
+//! robotkernel unix domain socket bridge protocol
+/*!
+ * (C) Robert Burger <robert.burger@dlr.de>
+ */
+
+// vim: set expandtab softtabstop=4 shiftwidth=4
+// -*- mode: c++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*- 
+
+/*
+ * This file is part of robotkernel.
+ *
+ * robotkernel is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * robotkernel is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with robotkernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ROBOTKERNEL__UDS_PROTOCOL_H
+#define ROBOTKERNEL__UDS_PROTOCOL_H
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <stdexcept>
+
+namespace robotkernel {
+#ifdef EMACS
+}
+#endif
+
+//! frame header
+/*!
+ * Every request and response starts with this header followed by
+ * length bytes of payload. All values are in host byte order, the 
+ * socket is only reachable from the local machine. 
+ *
+ * Requests may be pipelined, responses carry the id of their request
+ * and can arrive out of order if services are queued.
+ */
+struct uds_frame_header {
+    uint32_t length;        //!< payload length
+    uint32_t id;            //!< request id, echoed in response
+    uint16_t type;          //!< message type
+    uint16_t status;        //!< response status, 0 in requests
+};
+
+static const uint32_t uds_max_frame_length = 64 * 1024 * 1024;
+
+//! message types
+/*!
+ * Strings are encoded as uint32_t length and characters, arrays as
+ * uint32_t count and elements, all other types with their native size.
+ * Service arguments are encoded field by field in definition order.
+ */
+typedef enum uds_message_type {
+    uds_msg_list    = 1,    //!< req: -, resp: uint32_t count, count * (string owner, string name)
+    uds_msg_resolve = 2,    //!< req: string owner, string name, resp: uint32_t handle, string definition
+    uds_msg_call    = 3     //!< req: uint32_t handle, request fields, resp: response fields
+} uds_message_type_t;
+
+//! response status
+typedef enum uds_status {
+    uds_status_ok    = 0,
+    uds_status_error = 1    //!< payload: string error message
+} uds_status_t;
+
+//! append encoded values to buffer
+class uds_writer {
+    private:
+        std::string& buf;
+
+    public:
+        uds_writer(std::string& buf) : buf(buf) {}
+
+        template <typename T>
+        void put(const T& value) { buf.append((const char *)&value, sizeof(T)); }
+
+        void put_string(const std::string& value) { 
+            put<uint32_t>(value.size());
+            buf.append(value);
+        }
+};
+
+//! read encoded values, throws on truncated payload
+class uds_reader {
+    private:
+        const char *pos;
+        const char *end;
+
+        void check(size_t len) {
+            if ((size_t)(end - pos) < len)
+                throw std::runtime_error("truncated message\n");
+        }
+
+    public:
+        uds_reader(const char *data, size_t len) : pos(data), end(data + len) {}
+
+        template <typename T>
+        T get() {
+            T value;
+            check(sizeof(T));
+            memcpy(&value, pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        std::string get_string() {
+            uint32_t len = get<uint32_t>();
+            check(len);
+            std::string value(pos, len);
+            pos += len;
+            return value;
+        }
+
+        //! true if all bytes were read
+        bool empty() const { return pos == end; }
+};
+
+#ifdef EMACS
+{
+#endif
+} // namespace robotkernel
+
+#endif // ROBOTKERNEL__UDS_PROTOCOL_H
+